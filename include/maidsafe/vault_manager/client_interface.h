@@ -32,11 +32,16 @@
 #include "boost/filesystem/path.hpp"
 
 #include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/rsa.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/passport/passport.h"
 
+#include "maidsafe/vault_manager/vault_resource_limits.h"
+#include "maidsafe/vault_manager/vault_resource_sample.h"
+#include "maidsafe/vault_manager/vault_status.h"
+
 namespace maidsafe {
 
 namespace vault_manager {
@@ -50,21 +55,48 @@ struct PromiseAndTimer;
 
 struct Challenge;
 struct LogMessage;
+struct MoveChunkstoreProgress;
+class RpcMultiplexer;
+struct SessionTicket;
+struct SetVaultResourceLimitsResponse;
+struct StartVaultRequest;
+struct VaultResourceUsageResponse;
 struct VaultRunningResponse;
 struct VaultStartedResponse;
+struct VaultStatusResponse;
 
 class ClientInterface {
  public:
+  // Called with the bytes copied so far and the total to be copied.
+  typedef std::function<void(uint64_t, uint64_t)> MoveProgressFunctor;
+  typedef std::vector<std::future<std::unique_ptr<passport::PmidAndSigner>>> VaultFutures;
+
+  // Parameters of one vault in a TakeOwnershipBatch call.
+  struct VaultOwnership {
+    NonEmptyString label;
+    boost::filesystem::path vault_dir;
+    DiskUsage max_disk_usage;
+  };
+
   ClientInterface(const ClientInterface&) = delete;
   ClientInterface(ClientInterface&&) = delete;
   ClientInterface& operator=(ClientInterface) = delete;
 
+  // Validates the connection to the VaultManager by signing a challenge, unless an earlier
+  // ClientInterface in this process for the same Maid was given a session ticket which is still
+  // valid, in which case the session is resumed using only symmetric-key work.
   explicit ClientInterface(const passport::Maid& maid);
   ~ClientInterface();
 
+  // If 'vault_dir' differs from the vault's current directory, the vault's chunkstore is copied
+  // there while the vault keeps running, with 'on_move_progress' (if non-null) invoked as the copy
+  // proceeds.  The returned future isn't ready until the move is complete.
   std::future<std::unique_ptr<passport::PmidAndSigner>> TakeOwnership(
       const NonEmptyString& label, const boost::filesystem::path& vault_dir,
-      DiskUsage max_disk_usage);
+      DiskUsage max_disk_usage, MoveProgressFunctor on_move_progress = nullptr);
+  // As above for several vaults in a single request, without progress reports for moves.  The
+  // returned futures are in the order of 'vaults'.
+  VaultFutures TakeOwnershipBatch(const std::vector<VaultOwnership>& vaults);
 
 #ifdef USE_VLOGGING
   std::future<std::unique_ptr<passport::PmidAndSigner>> StartVault(
@@ -75,6 +107,31 @@ class ClientInterface {
       const boost::filesystem::path& vault_dir, DiskUsage max_disk_usage);
 #endif
 
+  // Starts a vault in each of 'vault_dirs' with a single request.  The VaultManager prepares the
+  // vaults concurrently and records them in its config file together.  The returned futures are
+  // in the order of 'vault_dirs'.
+#ifdef USE_VLOGGING
+  VaultFutures StartVaults(const std::vector<boost::filesystem::path>& vault_dirs,
+                           DiskUsage max_disk_usage, const std::string& vlog_session_id);
+#else
+  VaultFutures StartVaults(const std::vector<boost::filesystem::path>& vault_dirs,
+                           DiskUsage max_disk_usage);
+#endif
+
+  // Reports whether the vault is running, or e.g. backing off after crashing.
+  std::future<VaultStatus> GetVaultStatus(const NonEmptyString& label);
+
+  // Replaces the vault's CPU, memory and IO limits without restarting it.  The future holds the
+  // limits now in force, or an error if they couldn't be applied (e.g. where cgroup v2 is
+  // unavailable).
+  std::future<VaultResourceLimits> SetVaultResourceLimits(const NonEmptyString& label,
+                                                          const VaultResourceLimits& limits);
+
+  // Returns the vault's recent CPU, memory, IO and file descriptor usage, oldest sample first.  The
+  // VaultManager samples each vault every few seconds; the vector is empty on platforms where it
+  // can't.
+  std::future<std::vector<VaultResourceSample>> GetVaultResourceUsage(const NonEmptyString& label);
+
 #ifdef TESTING
   // This function sets up global variables specifying:
   // * the desired TCP listening port of the VaultManager (VM)
@@ -102,6 +159,18 @@ class ClientInterface {
       const boost::filesystem::path& vault_dir, DiskUsage max_disk_usage, int pmid_list_index);
 #endif
 
+  // 'pmid_list_indices' must be empty, in which case the vaults' keys are generated as usual, or
+  // the same size as 'vault_dirs'.
+#ifdef USE_VLOGGING
+  VaultFutures StartVaults(const std::vector<boost::filesystem::path>& vault_dirs,
+                           DiskUsage max_disk_usage, const std::string& vlog_session_id,
+                           bool send_hostname_to_visualiser_server,
+                           const std::vector<int>& pmid_list_indices);
+#else
+  VaultFutures StartVaults(const std::vector<boost::filesystem::path>& vault_dirs,
+                           DiskUsage max_disk_usage, const std::vector<int>& pmid_list_indices);
+#endif
+
   // Used by tool to indicate that it is satisfied the new network (or connected network) is stable.
   void MarkNetworkAsStable();
 
@@ -110,28 +179,48 @@ class ClientInterface {
 #endif
 
  private:
+  // Same as CorrelationId in config.h, which isn't a public header.
+  typedef uint32_t CorrelationId;
+  // Vault requests are matched to responses by label (see detail::PromiseAndTimer).
   typedef detail::PromiseAndTimer<std::unique_ptr<passport::PmidAndSigner>, VaultStartedResponse>
       VaultRequest;
 
   std::shared_ptr<tcp::Connection> ConnectToVaultManager();
+  // Returns false if there's no usable ticket, or the VaultManager rejects it.
+  bool ResumeSession(const asymm::PlainText& challenge);
   std::future<std::unique_ptr<passport::PmidAndSigner>> AddVaultRequest(
       const NonEmptyString& label);
+  VaultFutures SendStartVaultsRequest(std::vector<StartVaultRequest> requests);
   void HandleReceivedMessage(tcp::Message&& message);
+  // (Re)starts the timeout for 'request'.
+  void WaitForVaultRequest(const NonEmptyString& label, std::shared_ptr<VaultRequest> request);
   void HandleVaultRunningResponse(VaultRunningResponse&& vault_running_response);
+  void HandleMoveChunkstoreProgress(MoveChunkstoreProgress&& progress);
+  void HandleVaultStatusResponse(CorrelationId correlation_id,
+                                 VaultStatusResponse&& vault_status_response);
+  void HandleSetVaultResourceLimitsResponse(CorrelationId correlation_id,
+                                            SetVaultResourceLimitsResponse&& response);
+  void HandleVaultResourceUsageResponse(CorrelationId correlation_id,
+                                        VaultResourceUsageResponse&& response);
 #ifdef TESTING
   void HandleNetworkStableResponse();
 #endif
-  void InvokeCallBack(Challenge&& challenge, std::function<void(Challenge&&)>& callback);
+  void HandleChallenge(CorrelationId correlation_id, Challenge&& challenge);
   void HandleLogMessage(LogMessage&& log_message);
+  void HandleSessionTicket(CorrelationId correlation_id, SessionTicket&& session_ticket);
 
   const passport::Maid kMaid_;
   std::mutex mutex_;
-  std::function<void(Challenge&&)> on_challenge_;
+  // Agreed with the VaultManager during validation; vaults' keys sent to us are encrypted with it.
+  crypto::AES256Key session_key_;
   std::promise<void> network_stable_;
   std::once_flag network_stable_flag_;
   std::map<NonEmptyString, std::shared_ptr<VaultRequest>> ongoing_vault_requests_;
+  std::map<NonEmptyString, MoveProgressFunctor> move_progress_functors_;
   AsioService asio_service_;
   asio::io_service::strand strand_;
+  // All other requests are matched to their responses by correlation ID.
+  std::shared_ptr<RpcMultiplexer> rpcs_;
   std::shared_ptr<tcp::Connection> tcp_connection_;
   // We need to ensure the connection is closed in the event of the constructor throwing, or the
   // asio_service destructor will hang.
@@ -23,11 +23,14 @@
 #include <cstdint>
 #include <functional>
 #include <future>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 
 #include "asio/io_service_strand.hpp"
+#include "asio/steady_timer.hpp"
+#include "boost/filesystem/path.hpp"
 
 #include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/on_scope_exit.h"
@@ -41,15 +44,24 @@ namespace maidsafe {
 
 namespace vault_manager {
 
+struct MaxDiskUsageUpdate;
+struct MoveChunkstoreRequest;
+class RpcMultiplexer;
 struct VaultStartedResponse;
 
 class VaultInterface {
  public:
+  typedef std::function<void(const boost::filesystem::path& new_vault_dir,
+                             const std::function<void()>& copy_remaining)> MoveChunkstoreFunctor;
+  typedef std::function<void(DiskUsage max_disk_usage)> MaxDiskUsageFunctor;
+  typedef uint64_t SubscriptionId;
+
   VaultInterface(const VaultInterface&) = delete;
   VaultInterface(VaultInterface&&) = delete;
   VaultInterface& operator=(VaultInterface) = delete;
 
   explicit VaultInterface(tcp::Port vault_manager_port);
+  ~VaultInterface();
 
   VaultConfig GetConfiguration();
 
@@ -58,6 +70,29 @@ class VaultInterface {
 
   void SendJoined();
 
+  // Heartbeats are sent to the VaultManager every few seconds from this object's own thread, and a
+  // vault which stops sending them is restarted.  If set, 'progress_probe' is called before each
+  // heartbeat and its result (e.g. a count of requests handled) is included.  It should be cheap,
+  // but may deliberately block if the vault is wedged (say, by briefly taking the vault's main
+  // lock), so that a deadlocked vault stops heartbeating even though this thread is still free.
+  void SetProgressProbe(std::function<uint64_t()> progress_probe);
+
+  // Lets the vault's chunkstore be moved without restarting it.  The functor is called on a
+  // separate thread once the VaultManager has copied the chunkstore to 'new_vault_dir'.  It must
+  // stop the vault writing to its current directory, call 'copy_remaining' (which copies whatever
+  // changed since, and throws on failure), then switch to 'new_vault_dir' and resume.  If it
+  // throws, the vault must still be using its old directory.  Without a functor, the VaultManager
+  // moves the chunkstore by restarting the vault.
+  void SetMoveChunkstoreFunctor(MoveChunkstoreFunctor functor);
+
+  // The VaultManager can change some of the vault's configuration while it runs (currently just
+  // its maximum disk usage), and GetConfiguration always returns the latest values.  A subscriber's
+  // functor is called with the current value soon after subscribing, then with each new value.
+  // All calls are made on this object's own thread, so functors should return promptly.  Once
+  // Unsubscribe returns, the functor is no longer called unless it's running at the time.
+  SubscriptionId SubscribeToMaxDiskUsage(MaxDiskUsageFunctor functor);
+  void Unsubscribe(SubscriptionId subscription_id);
+
 #ifdef TESTING
   void KillConnection();
   void SendInvalidMessage();
@@ -65,23 +100,44 @@ class VaultInterface {
 #endif
 
  private:
+  // Same as CorrelationId in config.h, which isn't a public header.
+  typedef uint32_t CorrelationId;
+
   void HandleReceivedMessage(tcp::Message&& message);
   void OnConnectionClosed();
 
-  void HandleVaultStartedResponse(VaultStartedResponse&& vault_started_response);
+  void HandleVaultStartedResponse(CorrelationId correlation_id,
+                                  VaultStartedResponse&& vault_started_response);
   void HandleVaultShutdownRequest();
+  void HandleMoveChunkstoreRequest(MoveChunkstoreRequest&& move_chunkstore_request);
+  void HandleMaxDiskUsageUpdate(MaxDiskUsageUpdate&& max_disk_usage_update);
+  void NotifyMaxDiskUsage(SubscriptionId subscription_id);
+  void ScheduleHeartbeat();
 
   std::promise<int> exit_code_promise_;
   std::once_flag exit_code_flag_;
   tcp::Port vault_manager_port_;
-  std::function<void(VaultStartedResponse&&)> on_vault_started_response_;
+  // Guards vault_config_ once it's set, and the subscriptions.
+  std::mutex config_mutex_;
   std::unique_ptr<VaultConfig> vault_config_;
+  SubscriptionId next_subscription_id_;
+  std::map<SubscriptionId, MaxDiskUsageFunctor> max_disk_usage_subscriptions_;
   AsioService asio_service_;
   asio::io_service::strand strand_;
+  std::shared_ptr<RpcMultiplexer> rpcs_;
   std::shared_ptr<tcp::Connection> tcp_connection_;
   // We need to ensure the connection is closed in the event of the constructor throwing, or the
   // asio_service destructor will hang.
   on_scope_exit connection_closer_;
+  std::mutex progress_probe_mutex_;
+  std::function<uint64_t()> progress_probe_;
+  uint64_t heartbeat_sequence_;
+  asio::steady_timer heartbeat_timer_;
+  std::mutex chunkstore_mutex_;
+  MoveChunkstoreFunctor move_chunkstore_functor_;
+  boost::filesystem::path chunkstore_dir_;
+  // Destroyed first, so waits for any ongoing move to finish while the connection is still open.
+  std::future<void> chunkstore_move_;
 };
 
 }  // namespace vault_manager
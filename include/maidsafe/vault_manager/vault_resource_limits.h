@@ -0,0 +1,54 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_VAULT_RESOURCE_LIMITS_H_
+#define MAIDSAFE_VAULT_MANAGER_VAULT_RESOURCE_LIMITS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "boost/optional.hpp"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Limits applied to a vault through its own cgroup.  These are only enforced on Linux with cgroup
+// v2, and only if the VaultManager's cgroup has been delegated to it.  Unset fields mean no limit,
+// or the default weight.
+struct VaultResourceLimits {
+  VaultResourceLimits() : cpu_weight(), memory_high(), memory_max(), io_weight(), io_max() {}
+
+  // Share of CPU time relative to the other vaults when the CPU is contended, in [1, 10000].
+  boost::optional<uint32_t> cpu_weight;
+  // Memory use in bytes above which the vault is throttled and its memory aggressively reclaimed.
+  boost::optional<uint64_t> memory_high;
+  // Memory use in bytes beyond which the vault is killed.
+  boost::optional<uint64_t> memory_max;
+  // Share of block IO relative to the other vaults when a device is contended, in [1, 10000].
+  boost::optional<uint32_t> io_weight;
+  // Per-device limits in the format of the cgroup v2 "io.max" file, e.g. "8:16 wbps=1048576".
+  std::vector<std::string> io_max;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_VAULT_RESOURCE_LIMITS_H_
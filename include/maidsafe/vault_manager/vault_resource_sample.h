@@ -0,0 +1,57 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_VAULT_RESOURCE_SAMPLE_H_
+#define MAIDSAFE_VAULT_MANAGER_VAULT_RESOURCE_SAMPLE_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// A snapshot of a vault process's resource usage, as sampled periodically by the VaultManager.
+// CPU time and IO are cumulative for the process, so rates are given by the difference between
+// consecutive samples.  They start again from zero if the vault is restarted, which shows as a
+// change in 'process_id'.
+struct VaultResourceSample {
+  VaultResourceSample()
+      : time(),
+        process_id(0),
+        cpu_time(0),
+        resident_bytes(0),
+        read_bytes(0),
+        write_bytes(0),
+        open_files(0) {}
+
+  std::chrono::system_clock::time_point time;
+  uint64_t process_id;
+  // User plus system time.
+  std::chrono::milliseconds cpu_time;
+  uint64_t resident_bytes;
+  // Bytes actually fetched from or sent to storage, i.e. excluding page cache hits.
+  uint64_t read_bytes, write_bytes;
+  uint32_t open_files;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_VAULT_RESOURCE_SAMPLE_H_
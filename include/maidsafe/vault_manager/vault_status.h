@@ -0,0 +1,47 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_VAULT_STATUS_H_
+#define MAIDSAFE_VAULT_MANAGER_VAULT_STATUS_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// A vault's lifecycle state as seen by the VaultManager.
+struct VaultStatus {
+  enum class State : int32_t { kStarting, kRunning, kStopping, kBackingOff };
+
+  VaultStatus() : state(State::kStarting), recent_failures(0), time_until_restart(0) {}
+
+  State state;
+  // Number of recent unexpected exits.  This decays over time, so a vault which has been stable for
+  // a while has a count of zero even if it has crashed in the past.
+  int recent_failures;
+  // If 'state' is kBackingOff, the time until the VaultManager next tries to restart the vault.
+  std::chrono::milliseconds time_until_restart;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_VAULT_STATUS_H_
@@ -18,6 +18,8 @@
 
 #include "maidsafe/vault_manager/client_connections.h"
 
+#include <algorithm>
+
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/on_scope_exit.h"
@@ -28,19 +30,28 @@ namespace maidsafe {
 
 namespace vault_manager {
 
+namespace {
+
+std::string IndexKey(const ClientConnections::MaidName& maid_name) {
+  return maid_name.value.string();
+}
+
+}  // unnamed namespace
+
 ClientConnections::ClientConnections(asio::io_service& io_service)
-    : io_service_(io_service), unvalidated_clients_(), clients_() {}
+    : io_service_(io_service), mutex_(), unvalidated_clients_(), clients_(), maid_index_() {}
 
 std::shared_ptr<ClientConnections> ClientConnections::MakeShared(asio::io_service& io_service) {
   return std::shared_ptr<ClientConnections>{new ClientConnections{io_service}};
 }
 
 ClientConnections::~ClientConnections() {
-  assert(unvalidated_clients_.empty() && clients_.empty());
+  assert(unvalidated_clients_.empty() && clients_.empty() && maid_index_.empty());
 }
 
 void ClientConnections::Add(tcp::ConnectionPtr connection, const asymm::PlainText& challenge) {
-  assert(clients_.find(connection) == std::end(clients_));
+  std::lock_guard<std::mutex> lock{mutex_};
+  assert(clients_.find(connection.get()) == std::end(clients_));
   TimerPtr timer{std::make_shared<Timer>(io_service_, kRpcTimeout)};
   timer->async_wait([=](const std::error_code& error_code) {
     if (!error_code || error_code != asio::error::operation_aborted) {
@@ -48,63 +59,89 @@ void ClientConnections::Add(tcp::ConnectionPtr connection, const asymm::PlainTex
       connection->Close();
     }
   });
-  bool result{unvalidated_clients_.emplace(connection, std::make_pair(challenge, timer)).second};
+  bool result{unvalidated_clients_.emplace(connection.get(),
+                                           UnvalidatedClient{connection, challenge, timer}).second};
   assert(result);
   static_cast<void>(result);
 }
 
 void ClientConnections::Validate(tcp::ConnectionPtr connection, const passport::PublicMaid& maid,
-                                 const asymm::Signature& signature) {
-  auto itr(unvalidated_clients_.find(connection));
-  if (itr == std::end(unvalidated_clients_)) {
-    LOG(kError) << "Unvalidated Client TCP connection not found.";
-    BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::connection_not_found));
-  }
+                                 const asymm::Signature& signature,
+                                 const crypto::AES256Key& session_key) {
+  asymm::PlainText challenge{GetChallenge(connection)};
+  on_scope_exit cleanup{[connection] { connection->Close(); }};
 
-  on_scope_exit cleanup{[this, itr] { itr->first->Close(); }};
-
-  if (asymm::CheckSignature(itr->second.first, signature, maid.public_key())) {
+  if (asymm::CheckSignature(challenge, signature, maid.public_key())) {
     LOG(kSuccess) << "Client " << DebugId(maid.name().value) << " TCP connection validated.";
   } else {
     LOG(kError) << "Client TCP connection validation failed.";
     BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_signature));
   }
 
-  bool result{clients_.emplace(connection, maid.name()).second};
-  unvalidated_clients_.erase(itr);
+  AddValidated(connection, maid.name(), session_key);
   cleanup.Release();
+}
+
+asymm::PlainText ClientConnections::GetChallenge(tcp::ConnectionPtr connection) const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto itr(unvalidated_clients_.find(connection.get()));
+  if (itr == std::end(unvalidated_clients_)) {
+    LOG(kError) << "Unvalidated Client TCP connection not found.";
+    BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::connection_not_found));
+  }
+  return itr->second.challenge;
+}
+
+void ClientConnections::ValidateResumed(tcp::ConnectionPtr connection, const MaidName& maid_name,
+                                        const crypto::AES256Key& session_key) {
+  AddValidated(connection, maid_name, session_key);
+  LOG(kSuccess) << "Client " << DebugId(maid_name.value) << " TCP connection resumed.";
+}
+
+void ClientConnections::AddValidated(tcp::ConnectionPtr connection, const MaidName& maid_name,
+                                     const crypto::AES256Key& session_key) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  // The connection may have closed while the client's answer was being checked.
+  auto itr(unvalidated_clients_.find(connection.get()));
+  if (itr == std::end(unvalidated_clients_))
+    BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::connection_not_found));
+  bool result{clients_.emplace(connection.get(),
+                               Client{connection, maid_name, session_key}).second};
+  maid_index_[IndexKey(maid_name)].push_back(connection);
+  unvalidated_clients_.erase(itr);
   assert(result);
   static_cast<void>(result);
 }
 
 bool ClientConnections::Remove(tcp::ConnectionPtr connection) {
-  auto itr(clients_.find(connection));
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto itr(clients_.find(connection.get()));
   if (itr != std::end(clients_)) {
+    auto index_itr(maid_index_.find(IndexKey(itr->second.maid_name)));
+    assert(index_itr != std::end(maid_index_));
+    auto& connections(index_itr->second);
+    connections.erase(std::remove(std::begin(connections), std::end(connections), connection),
+                      std::end(connections));
+    if (connections.empty())
+      maid_index_.erase(index_itr);
     clients_.erase(itr);
     return true;
   }
 
-  auto unvalidated_itr(unvalidated_clients_.find(connection));
-  if (unvalidated_itr != std::end(unvalidated_clients_)) {
-    unvalidated_clients_.erase(unvalidated_itr);
-    return true;
-  }
-
-  return false;
+  return unvalidated_clients_.erase(connection.get()) != 0;
 }
 
 void ClientConnections::CloseAll() {
-  for (auto connection : unvalidated_clients_)
-    connection.first->Close();
-  for (auto connection : clients_)
-    connection.first->Close();
+  // Closed without holding the lock, in case closing calls back into this object.
+  for (auto connection : GetAll())
+    connection->Close();
 }
 
 ClientConnections::MaidName ClientConnections::FindValidated(tcp::ConnectionPtr connection) const {
-  auto itr(clients_.find(connection));
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto itr(clients_.find(connection.get()));
   if (itr == std::end(clients_)) {
-    auto unvalidated_itr(unvalidated_clients_.find(connection));
-    if (unvalidated_itr == std::end(unvalidated_clients_)) {
+    if (unvalidated_clients_.count(connection.get()) == 0) {
       LOG(kError) << "Client TCP connection not found.";
       BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::connection_not_found));
     } else {
@@ -112,30 +149,44 @@ ClientConnections::MaidName ClientConnections::FindValidated(tcp::ConnectionPtr
       BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::unvalidated_client));
     }
   }
-  return itr->second;
+  return itr->second.maid_name;
 }
 
 tcp::ConnectionPtr ClientConnections::FindValidated(MaidName maid_name) const {
-  auto itr(std::find_if(std::begin(clients_), std::end(clients_),
-                        [&maid_name](const std::pair<tcp::ConnectionPtr, MaidName> client) {
-    return client.second == maid_name;
-  }));
-  if (itr == std::end(clients_)) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto itr(maid_index_.find(IndexKey(maid_name)));
+  if (itr == std::end(maid_index_)) {
     LOG(kWarning) << "Client TCP connection not found.";
     BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::connection_not_found));
   }
-  return itr->first;
+  return itr->second.back();
+}
+
+crypto::AES256Key ClientConnections::FindSessionKey(tcp::ConnectionPtr connection) const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto itr(clients_.find(connection.get()));
+  if (itr == std::end(clients_)) {
+    LOG(kWarning) << "Validated Client TCP connection not found.";
+    BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::connection_not_found));
+  }
+  return itr->second.session_key;
 }
 
 std::vector<tcp::ConnectionPtr> ClientConnections::GetAll() const {
   std::vector<tcp::ConnectionPtr> all_connections;
-  for (auto connection : clients_)
-    all_connections.push_back(connection.first);
-  for (auto connection : unvalidated_clients_)
-    all_connections.push_back(connection.first);
+  ForEach([&](const tcp::ConnectionPtr& connection) { all_connections.push_back(connection); });
   return all_connections;
 }
 
+void ClientConnections::ForEach(
+    const std::function<void(const tcp::ConnectionPtr&)>& functor) const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (const auto& client : clients_)
+    functor(client.second.connection);
+  for (const auto& client : unvalidated_clients_)
+    functor(client.second.connection);
+}
+
 }  //  namespace vault_manager
 
 }  //  namespace maidsafe
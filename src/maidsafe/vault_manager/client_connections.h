@@ -19,13 +19,16 @@
 #ifndef MAIDSAFE_VAULT_MANAGER_CLIENT_CONNECTIONS_H_
 #define MAIDSAFE_VAULT_MANAGER_CLIENT_CONNECTIONS_H_
 
-#include <map>
+#include <functional>
 #include <memory>
-#include <utility>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "asio/io_service.hpp"
 
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/rsa.h"
 #include "maidsafe/passport/types.h"
 
@@ -35,27 +38,58 @@ namespace maidsafe {
 
 namespace vault_manager {
 
+// Thread-safe.  A client's signature is checked without holding the lock, so clients can be
+// validated concurrently.  Validated clients are indexed both by connection and by Maid name; a
+// Maid may have several connections.
 class ClientConnections {
  public:
   typedef passport::PublicMaid::Name MaidName;
   static std::shared_ptr<ClientConnections> MakeShared(asio::io_service& io_service);
   ~ClientConnections();
   void Add(tcp::ConnectionPtr connection, const asymm::PlainText& challenge);
+  // 'session_key' is the key agreed with the client for encrypting credentials sent to it on this
+  // connection.
   void Validate(tcp::ConnectionPtr connection, const passport::PublicMaid& maid,
-                const asymm::Signature& signature);
+                const asymm::Signature& signature, const crypto::AES256Key& session_key);
+  // For validating via a session ticket: the caller checks the client's answer to the connection's
+  // challenge, then marks it as validated.
+  asymm::PlainText GetChallenge(tcp::ConnectionPtr connection) const;
+  void ValidateResumed(tcp::ConnectionPtr connection, const MaidName& maid_name,
+                       const crypto::AES256Key& session_key);
   bool Remove(tcp::ConnectionPtr connection);
   void CloseAll();
   MaidName FindValidated(tcp::ConnectionPtr connection) const;
+  // Returns the Maid's most recently validated connection.
   tcp::ConnectionPtr FindValidated(MaidName maid_name) const;
+  crypto::AES256Key FindSessionKey(tcp::ConnectionPtr connection) const;
   std::vector<tcp::ConnectionPtr> GetAll() const;
+  // Calls 'functor' for every connection, validated or not.  The lock is held throughout, so
+  // 'functor' mustn't call back into this object.
+  void ForEach(const std::function<void(const tcp::ConnectionPtr&)>& functor) const;
 
  private:
   explicit ClientConnections(asio::io_service& io_service);
+  // Throws if the connection has closed meanwhile.
+  void AddValidated(tcp::ConnectionPtr connection, const MaidName& maid_name,
+                    const crypto::AES256Key& session_key);
 
   asio::io_service& io_service_;
-  std::map<tcp::ConnectionPtr, std::pair<asymm::PlainText, TimerPtr>,
-           std::owner_less<tcp::ConnectionPtr>> unvalidated_clients_;
-  std::map<tcp::ConnectionPtr, MaidName, std::owner_less<tcp::ConnectionPtr>> clients_;
+  mutable std::mutex mutex_;
+  struct UnvalidatedClient {
+    tcp::ConnectionPtr connection;
+    asymm::PlainText challenge;
+    TimerPtr timer;
+  };
+  struct Client {
+    tcp::ConnectionPtr connection;
+    MaidName maid_name;
+    crypto::AES256Key session_key;
+  };
+
+  std::unordered_map<const tcp::Connection*, UnvalidatedClient> unvalidated_clients_;
+  std::unordered_map<const tcp::Connection*, Client> clients_;
+  // Keyed by the Maid name's value, with connections in the order they were validated.
+  std::unordered_map<std::string, std::vector<tcp::ConnectionPtr>> maid_index_;
 };
 
 }  // namespace vault_manager
@@ -18,6 +18,9 @@
 
 #include "maidsafe/vault_manager/client_interface.h"
 
+#include <cassert>
+#include <chrono>
+
 #include "maidsafe/common/make_unique.h"
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/config.h"
@@ -25,36 +28,76 @@
 
 #include "maidsafe/vault_manager/config.h"
 #include "maidsafe/vault_manager/rpc_helper.h"
+#include "maidsafe/vault_manager/rpc_multiplexer.h"
+#include "maidsafe/vault_manager/session_tickets.h"
 #include "maidsafe/vault_manager/utils.h"
 #include "maidsafe/vault_manager/messages/challenge.h"
 #include "maidsafe/vault_manager/messages/challenge_response.h"
 #include "maidsafe/vault_manager/messages/log_message.h"
+#include "maidsafe/vault_manager/messages/move_chunkstore_progress.h"
 #include "maidsafe/vault_manager/messages/network_stable_request.h"
+#include "maidsafe/vault_manager/messages/resume_session_request.h"
+#include "maidsafe/vault_manager/messages/session_ticket.h"
 #include "maidsafe/vault_manager/messages/set_network_as_stable.h"
+#include "maidsafe/vault_manager/messages/set_vault_resource_limits_request.h"
+#include "maidsafe/vault_manager/messages/set_vault_resource_limits_response.h"
 #include "maidsafe/vault_manager/messages/start_vault_request.h"
+#include "maidsafe/vault_manager/messages/start_vaults_request.h"
+#include "maidsafe/vault_manager/messages/take_ownership_batch_request.h"
 #include "maidsafe/vault_manager/messages/take_ownership_request.h"
 #include "maidsafe/vault_manager/messages/validate_connection_request.h"
+#include "maidsafe/vault_manager/messages/vault_resource_usage_request.h"
+#include "maidsafe/vault_manager/messages/vault_resource_usage_response.h"
 #include "maidsafe/vault_manager/messages/vault_running_response.h"
+#include "maidsafe/vault_manager/messages/vault_status_request.h"
+#include "maidsafe/vault_manager/messages/vault_status_response.h"
 
 namespace maidsafe {
 
 namespace vault_manager {
 
+namespace {
+
+// Also the longest gap allowed between progress reports while a vault's chunkstore is moved.
+const std::chrono::seconds kVaultRequestTimeout(30);
+
+struct CachedSessionTicket {
+  std::string ticket, secret;
+  std::chrono::steady_clock::time_point expiry;
+};
+
+// Session tickets are kept for the life of the process, keyed by Maid name, so that later
+// ClientInterfaces can use them.
+std::mutex& SessionTicketsMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, CachedSessionTicket>& SessionTickets() {
+  static std::map<std::string, CachedSessionTicket> session_tickets;
+  return session_tickets;
+}
+
+}  // unnamed namespace
+
 ClientInterface::ClientInterface(const passport::Maid& maid)
     : kMaid_(maid),
       mutex_(),
-      on_challenge_(),
+      session_key_(),
       network_stable_(),
       network_stable_flag_(),
       asio_service_(1),
       strand_(asio_service_.service()),
+      rpcs_(RpcMultiplexer::MakeShared(asio_service_.service())),
       tcp_connection_(ConnectToVaultManager()),
       connection_closer_([&] { tcp_connection_->Close(); }) {
-  Send(tcp_connection_, ValidateConnectionRequest());
-  auto challenge = SetResponseCallback<std::unique_ptr<asymm::PlainText>, Challenge>(
-                       on_challenge_, asio_service_.service(), mutex_).get();
-  Send(tcp_connection_, ChallengeResponse(passport::PublicMaid(kMaid_),
-                                          asymm::Sign(*challenge, kMaid_.private_key())));
+  auto challenge_request(rpcs_->Add<std::unique_ptr<asymm::PlainText>>());
+  Send(tcp_connection_, ValidateConnectionRequest(), challenge_request.first);
+  std::unique_ptr<asymm::PlainText> challenge{challenge_request.second.get()};
+  if (!ResumeSession(*challenge)) {
+    Send(tcp_connection_, ChallengeResponse(passport::PublicMaid(kMaid_),
+                                            asymm::Sign(*challenge, kMaid_.private_key())));
+  }
 }
 
 ClientInterface::~ClientInterface() {
@@ -87,13 +130,70 @@ std::shared_ptr<tcp::Connection> ClientInterface::ConnectToVaultManager() {
   BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::failed_to_connect));
 }
 
+bool ClientInterface::ResumeSession(const asymm::PlainText& challenge) {
+  std::string maid_name{kMaid_.name().value.string()};
+  CachedSessionTicket session_ticket;
+  {
+    std::lock_guard<std::mutex> lock{SessionTicketsMutex()};
+    auto itr(SessionTickets().find(maid_name));
+    if (itr == std::end(SessionTickets()))
+      return false;
+    if (itr->second.expiry <= std::chrono::steady_clock::now()) {
+      SessionTickets().erase(itr);
+      return false;
+    }
+    session_ticket = itr->second;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    session_key_ = ResumedSessionKey(session_ticket.secret, challenge);
+  }
+  // Answered by a new SessionTicket if accepted, or by the challenge again if not.
+  auto resume_request(rpcs_->Add<bool>());
+  Send(tcp_connection_,
+       ResumeSessionRequest(session_ticket.ticket, SessionProof(session_ticket.secret, challenge)),
+       resume_request.first);
+  bool result{false};
+  try {
+    result = resume_request.second.get();
+  } catch (const std::exception& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+  }
+  if (!result) {
+    LOG(kInfo) << "Session ticket not accepted; signing challenge instead.";
+    std::lock_guard<std::mutex> lock{SessionTicketsMutex()};
+    auto itr(SessionTickets().find(maid_name));
+    if (itr != std::end(SessionTickets()) && itr->second.ticket == session_ticket.ticket)
+      SessionTickets().erase(itr);
+  }
+  return result;
+}
+
 std::future<std::unique_ptr<passport::PmidAndSigner>> ClientInterface::TakeOwnership(
     const NonEmptyString& label, const boost::filesystem::path& vault_dir,
-    DiskUsage max_disk_usage) {
+    DiskUsage max_disk_usage, MoveProgressFunctor on_move_progress) {
+  if (on_move_progress) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    move_progress_functors_[label] = std::move(on_move_progress);
+  }
   Send(tcp_connection_, TakeOwnershipRequest(label, vault_dir, max_disk_usage));
   return AddVaultRequest(label);
 }
 
+ClientInterface::VaultFutures ClientInterface::TakeOwnershipBatch(
+    const std::vector<VaultOwnership>& vaults) {
+  std::vector<TakeOwnershipRequest> requests;
+  VaultFutures futures;
+  for (const auto& vault : vaults) {
+    requests.emplace_back(vault.label, vault.vault_dir, vault.max_disk_usage);
+    futures.push_back(AddVaultRequest(vault.label));
+  }
+  if (!requests.empty())
+    Send(tcp_connection_, TakeOwnershipBatchRequest(std::move(requests)));
+  return futures;
+}
+
 #ifdef USE_VLOGGING
 std::future<std::unique_ptr<passport::PmidAndSigner>> ClientInterface::StartVault(
     const boost::filesystem::path& vault_dir, DiskUsage max_disk_usage,
@@ -113,10 +213,72 @@ std::future<std::unique_ptr<passport::PmidAndSigner>> ClientInterface::StartVaul
 }
 #endif
 
+#ifdef USE_VLOGGING
+ClientInterface::VaultFutures ClientInterface::StartVaults(
+    const std::vector<boost::filesystem::path>& vault_dirs, DiskUsage max_disk_usage,
+    const std::string& vlog_session_id) {
+  std::vector<StartVaultRequest> requests;
+  for (const auto& vault_dir : vault_dirs) {
+    requests.emplace_back(NonEmptyString{GenerateLabel()}, vault_dir, max_disk_usage);
+    requests.back().vlog_session_id = vlog_session_id;
+  }
+  return SendStartVaultsRequest(std::move(requests));
+}
+#else
+ClientInterface::VaultFutures ClientInterface::StartVaults(
+    const std::vector<boost::filesystem::path>& vault_dirs, DiskUsage max_disk_usage) {
+  std::vector<StartVaultRequest> requests;
+  for (const auto& vault_dir : vault_dirs)
+    requests.emplace_back(NonEmptyString{GenerateLabel()}, vault_dir, max_disk_usage);
+  return SendStartVaultsRequest(std::move(requests));
+}
+#endif
+
+std::future<VaultStatus> ClientInterface::GetVaultStatus(const NonEmptyString& label) {
+  auto request(rpcs_->Add<VaultStatus>());
+  Send(tcp_connection_, VaultStatusRequest(label), request.first);
+  return std::move(request.second);
+}
+
+std::future<VaultResourceLimits> ClientInterface::SetVaultResourceLimits(
+    const NonEmptyString& label, const VaultResourceLimits& limits) {
+  auto request(rpcs_->Add<VaultResourceLimits>());
+  Send(tcp_connection_, SetVaultResourceLimitsRequest(label, limits), request.first);
+  return std::move(request.second);
+}
+
+std::future<std::vector<VaultResourceSample>> ClientInterface::GetVaultResourceUsage(
+    const NonEmptyString& label) {
+  auto request(rpcs_->Add<std::vector<VaultResourceSample>>());
+  Send(tcp_connection_, VaultResourceUsageRequest(label), request.first);
+  return std::move(request.second);
+}
+
 std::future<std::unique_ptr<passport::PmidAndSigner>> ClientInterface::AddVaultRequest(
     const NonEmptyString& label) {
   std::shared_ptr<VaultRequest> request(
-      std::make_shared<VaultRequest>(asio_service_.service(), std::chrono::seconds(30)));
+      std::make_shared<VaultRequest>(asio_service_.service(), kVaultRequestTimeout));
+  WaitForVaultRequest(label, request);
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  ongoing_vault_requests_.insert(std::make_pair(label, request));
+  return request->promise.get_future();
+}
+
+ClientInterface::VaultFutures ClientInterface::SendStartVaultsRequest(
+    std::vector<StartVaultRequest> requests) {
+  VaultFutures futures;
+  if (requests.empty())
+    return futures;
+  // Register the requests before sending, since a response may arrive before the rest are.
+  for (const auto& request : requests)
+    futures.push_back(AddVaultRequest(request.vault_label));
+  Send(tcp_connection_, StartVaultsRequest(std::move(requests)));
+  return futures;
+}
+
+void ClientInterface::WaitForVaultRequest(const NonEmptyString& label,
+                                          std::shared_ptr<VaultRequest> request) {
   request->timer.async_wait([request, label, this](const std::error_code& ec) {
     if (ec && ec == asio::error::operation_aborted)
       return;
@@ -127,25 +289,40 @@ std::future<std::unique_ptr<passport::PmidAndSigner>> ClientInterface::AddVaultR
     else
       request->SetException(MakeError(VaultManagerErrors::timed_out));
     ongoing_vault_requests_.erase(label);
+    move_progress_functors_.erase(label);
   });
-
-  std::lock_guard<std::mutex> lock{mutex_};
-  ongoing_vault_requests_.insert(std::make_pair(label, request));
-  return request->promise.get_future();
 }
 
 void ClientInterface::HandleReceivedMessage(tcp::Message&& message) {
   try {
     InputVectorStream binary_input_stream(std::move(message));
     MessageTag tag(static_cast<MessageTag>(-1));
-    Parse(binary_input_stream, tag);
+    CorrelationId correlation_id(0);
+    Parse(binary_input_stream, tag, correlation_id);
     switch (tag) {
       case MessageTag::kChallenge:
-        InvokeCallBack(Parse<Challenge>(binary_input_stream), on_challenge_);
+        HandleChallenge(correlation_id, Parse<Challenge>(binary_input_stream));
+        break;
+      case MessageTag::kSessionTicket:
+        HandleSessionTicket(correlation_id, Parse<SessionTicket>(binary_input_stream));
         break;
       case MessageTag::kVaultRunningResponse:
         HandleVaultRunningResponse(Parse<VaultRunningResponse>(binary_input_stream));
         break;
+      case MessageTag::kMoveChunkstoreProgress:
+        HandleMoveChunkstoreProgress(Parse<MoveChunkstoreProgress>(binary_input_stream));
+        break;
+      case MessageTag::kVaultStatusResponse:
+        HandleVaultStatusResponse(correlation_id, Parse<VaultStatusResponse>(binary_input_stream));
+        break;
+      case MessageTag::kSetVaultResourceLimitsResponse:
+        HandleSetVaultResourceLimitsResponse(
+            correlation_id, Parse<SetVaultResourceLimitsResponse>(binary_input_stream));
+        break;
+      case MessageTag::kVaultResourceUsageResponse:
+        HandleVaultResourceUsageResponse(correlation_id,
+                                         Parse<VaultResourceUsageResponse>(binary_input_stream));
+        break;
 #ifdef TESTING
       case MessageTag::kNetworkStableResponse:
         HandleNetworkStableResponse();
@@ -167,8 +344,13 @@ void ClientInterface::HandleVaultRunningResponse(VaultRunningResponse&& vault_ru
   std::unique_ptr<passport::PmidAndSigner> pmid_and_signer;
   std::unique_ptr<maidsafe_error> error;
   if (vault_running_response.vault_keys) {
+    crypto::AES256Key session_key;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      session_key = session_key_;
+    }
     pmid_and_signer = maidsafe::make_unique<passport::PmidAndSigner>(
-        *vault_running_response.vault_keys->pmid_and_signer);
+        vault_running_response.vault_keys->Decrypt(session_key));
   } else if (vault_running_response.error) {
     error = maidsafe::make_unique<maidsafe_error>(*vault_running_response.error);
     LOG(kError) << "Got error for vault label: " << label.string() << "   Error: " << error->what();
@@ -177,6 +359,7 @@ void ClientInterface::HandleVaultRunningResponse(VaultRunningResponse&& vault_ru
   }
 
   std::lock_guard<std::mutex> lock{mutex_};
+  move_progress_functors_.erase(label);
   auto itr = ongoing_vault_requests_.find(label);
   if (ongoing_vault_requests_.end() != itr) {
     if (pmid_and_signer)
@@ -191,22 +374,101 @@ void ClientInterface::HandleVaultRunningResponse(VaultRunningResponse&& vault_ru
   }
 }
 
+void ClientInterface::HandleMoveChunkstoreProgress(MoveChunkstoreProgress&& progress) {
+  MoveProgressFunctor on_move_progress;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    // The move is still making progress, so restart the timeout.
+    auto itr(ongoing_vault_requests_.find(progress.vault_label));
+    if (itr != std::end(ongoing_vault_requests_)) {
+      itr->second->timer.expires_from_now(kVaultRequestTimeout);
+      WaitForVaultRequest(progress.vault_label, itr->second);
+    }
+    auto functor_itr(move_progress_functors_.find(progress.vault_label));
+    if (functor_itr != std::end(move_progress_functors_))
+      on_move_progress = functor_itr->second;
+  }
+  if (!on_move_progress)
+    return;
+  try {
+    on_move_progress(progress.bytes_copied, progress.total_bytes);
+  } catch (const std::exception& e) {
+    LOG(kError) << "Error executing move progress functor: " << boost::diagnostic_information(e);
+  }
+}
+
+void ClientInterface::HandleVaultStatusResponse(CorrelationId correlation_id,
+                                                VaultStatusResponse&& vault_status_response) {
+  bool pending{vault_status_response.status
+                   ? rpcs_->SetValue(correlation_id, VaultStatus(*vault_status_response.status))
+                   : rpcs_->SetException(correlation_id, *vault_status_response.error)};
+  if (!pending) {
+    LOG(kWarning) << "No pending status request for vault "
+                  << vault_status_response.vault_label.string();
+  }
+}
+
+void ClientInterface::HandleSetVaultResourceLimitsResponse(
+    CorrelationId correlation_id, SetVaultResourceLimitsResponse&& response) {
+  bool pending{response.limits ? rpcs_->SetValue(correlation_id, std::move(*response.limits))
+                               : rpcs_->SetException(correlation_id, *response.error)};
+  if (!pending) {
+    LOG(kWarning) << "No pending resource limits request for vault "
+                  << response.vault_label.string();
+  }
+}
+
+void ClientInterface::HandleVaultResourceUsageResponse(CorrelationId correlation_id,
+                                                       VaultResourceUsageResponse&& response) {
+  bool pending{response.samples ? rpcs_->SetValue(correlation_id, std::move(*response.samples))
+                                : rpcs_->SetException(correlation_id, *response.error)};
+  if (!pending) {
+    LOG(kWarning) << "No pending resource usage request for vault "
+                  << response.vault_label.string();
+  }
+}
+
 #ifdef TESTING
 void ClientInterface::HandleNetworkStableResponse() {
   std::call_once(network_stable_flag_, [&] { network_stable_.set_value(); });
 }
 #endif
 
-void ClientInterface::InvokeCallBack(Challenge&& challenge,
-                                     std::function<void(Challenge&&)>& callback) {
-  if (callback)
-    callback(std::move(challenge));
-  else
-    LOG(kWarning) << "Call back not available";
+void ClientInterface::HandleChallenge(CorrelationId correlation_id, Challenge&& challenge) {
+  // Either the answer to our ValidateConnectionRequest, or a sign that the session ticket in our
+  // ResumeSessionRequest was rejected.
+  if (!rpcs_->SetValue(correlation_id, detail::GetValue(challenge)) &&
+      !rpcs_->SetValue(correlation_id, false)) {
+    LOG(kWarning) << "Unexpected challenge.";
+  }
 }
 
 void ClientInterface::HandleLogMessage(LogMessage&& log_message) { LOG(kInfo) << log_message.data; }
 
+void ClientInterface::HandleSessionTicket(CorrelationId correlation_id,
+                                          SessionTicket&& session_ticket) {
+  std::string secret;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    // Absent if we resumed with a ticket, in which case the key was derived in ResumeSession.
+    if (session_ticket.encrypted_session_key) {
+      session_key_ = crypto::AES256Key{
+          asymm::Decrypt(*session_ticket.encrypted_session_key, kMaid_.private_key()).string()};
+    }
+    secret = session_ticket.Secret(session_key_);
+  }
+  {
+    std::lock_guard<std::mutex> lock{SessionTicketsMutex()};
+    CachedSessionTicket& cached(SessionTickets()[kMaid_.name().value.string()]);
+    cached.ticket = std::move(session_ticket.ticket);
+    cached.secret = std::move(secret);
+    cached.expiry =
+        std::chrono::steady_clock::now() + std::chrono::seconds(session_ticket.lifetime);
+  }
+  // Only correlated if it's the answer to a ResumeSessionRequest.
+  rpcs_->SetValue(correlation_id, true);
+}
+
 #ifdef TESTING
 void ClientInterface::SetTestEnvironment(tcp::Port test_vault_manager_port,
                                          boost::filesystem::path test_env_root_dir,
@@ -250,6 +512,37 @@ std::future<std::unique_ptr<passport::PmidAndSigner>> ClientInterface::StartVaul
 }
 #endif
 
+#ifdef USE_VLOGGING
+ClientInterface::VaultFutures ClientInterface::StartVaults(
+    const std::vector<boost::filesystem::path>& vault_dirs, DiskUsage max_disk_usage,
+    const std::string& vlog_session_id, bool send_hostname_to_visualiser_server,
+    const std::vector<int>& pmid_list_indices) {
+  assert(pmid_list_indices.empty() || vault_dirs.size() == pmid_list_indices.size());
+  std::vector<StartVaultRequest> requests;
+  for (std::size_t i(0); i != vault_dirs.size(); ++i) {
+    requests.emplace_back(NonEmptyString{GenerateLabel()}, vault_dirs[i], max_disk_usage);
+    requests.back().vlog_session_id = vlog_session_id;
+    requests.back().send_hostname_to_visualiser_server = send_hostname_to_visualiser_server;
+    if (!pmid_list_indices.empty())
+      requests.back().pmid_list_index = pmid_list_indices[i];
+  }
+  return SendStartVaultsRequest(std::move(requests));
+}
+#else
+ClientInterface::VaultFutures ClientInterface::StartVaults(
+    const std::vector<boost::filesystem::path>& vault_dirs, DiskUsage max_disk_usage,
+    const std::vector<int>& pmid_list_indices) {
+  assert(pmid_list_indices.empty() || vault_dirs.size() == pmid_list_indices.size());
+  std::vector<StartVaultRequest> requests;
+  for (std::size_t i(0); i != vault_dirs.size(); ++i) {
+    requests.emplace_back(NonEmptyString{GenerateLabel()}, vault_dirs[i], max_disk_usage);
+    if (!pmid_list_indices.empty())
+      requests.back().pmid_list_index = pmid_list_indices[i];
+  }
+  return SendStartVaultsRequest(std::move(requests));
+}
+#endif
+
 void ClientInterface::MarkNetworkAsStable() { Send(tcp_connection_, SetNetworkAsStable()); }
 
 std::future<void> ClientInterface::WaitForStableNetwork() {
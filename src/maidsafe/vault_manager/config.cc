@@ -24,10 +24,35 @@ namespace vault_manager {
 
 const std::string kConfigFilename("vault_manager_config.dat");
 const std::string kBootstrapFilename("bootstrap.dat");
+const std::string kKeyPoolFilename("vault_manager_key_pool.dat");
 
 const std::chrono::seconds kRpcTimeout(2);
+const std::chrono::milliseconds kRpcTimeoutResolution(50);
 const std::chrono::seconds kVaultStopTimeout(10);
+const std::size_t kMaxConcurrentVaultStops(8);
+const std::chrono::milliseconds kVaultStopInterval(100);
+const std::chrono::seconds kVaultStartTimeout(30);
+const std::chrono::seconds kVaultHeartbeatInterval(2);
+const std::chrono::seconds kVaultHeartbeatWarningTimeout(6);
+const std::chrono::seconds kVaultHeartbeatShutdownTimeout(10);
+const std::chrono::seconds kVaultHeartbeatTerminateTimeout(15);
 const int kMaxVaultRestarts(5);
+const std::chrono::milliseconds kInitialRestartDelay(1000);
+const std::chrono::milliseconds kMaxRestartDelay(10 * 60 * 1000);
+const std::chrono::minutes kRestartBudgetHalfLife(10);
+const uint32_t kDefaultVaultCpuWeight(100);
+const uint32_t kDefaultVaultIoWeight(100);
+const std::chrono::seconds kResourceSampleInterval(10);
+const std::size_t kResourceSampleCount(180);
+const uint64_t kChunkstoreCopyRate(64 * 1024 * 1024);
+const std::chrono::seconds kChunkstoreMoveProgressInterval(1);
+const std::chrono::seconds kDiskQuotaInterval(60);
+const uint64_t kDiskReservePercent(10);
+const std::chrono::seconds kSessionTicketLifetime(600);
+const std::size_t kKeyPoolSize(4);
+const int kMaxPmidPublishAttempts(5);
+const std::size_t kMaxConfigJournalRecords(64);
+const std::chrono::milliseconds kConfigWriteCoalescingWindow(10);
 
 }  // namespace vault_manager
 
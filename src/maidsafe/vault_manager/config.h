@@ -20,6 +20,7 @@
 #define MAIDSAFE_VAULT_MANAGER_CONFIG_H_
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -36,19 +37,72 @@ namespace vault_manager {
 
 typedef asio::steady_timer Timer;
 typedef std::shared_ptr<Timer> TimerPtr;
+// Every message starts with its MessageTag and a CorrelationId.  A response echoes the ID of the
+// request it answers; messages which aren't part of an RPC carry 0.
+typedef uint32_t CorrelationId;
 
 extern const std::string kConfigFilename;
 extern const std::string kBootstrapFilename;
+extern const std::string kKeyPoolFilename;
 extern const std::chrono::seconds kRpcTimeout;
+// Pending RPCs' timeouts are checked every kRpcTimeoutResolution (see RpcMultiplexer).
+extern const std::chrono::milliseconds kRpcTimeoutResolution;
 extern const std::chrono::seconds kVaultStopTimeout;
+// Defaults for ProcessManager::StopAll.  With these, stopping 100 vaults normally takes around 10s,
+// well inside systemd's default 90s stop timeout.
+extern const std::size_t kMaxConcurrentVaultStops;
+extern const std::chrono::milliseconds kVaultStopInterval;
+extern const std::chrono::seconds kVaultStartTimeout;
+// Running vaults send a heartbeat every kVaultHeartbeatInterval.  If none arrives for the given
+// timeouts, the VaultManager logs a warning, then asks the vault to stop, then terminates it (after
+// which it's restarted as though it had crashed).
+extern const std::chrono::seconds kVaultHeartbeatInterval;
+extern const std::chrono::seconds kVaultHeartbeatWarningTimeout;
+extern const std::chrono::seconds kVaultHeartbeatShutdownTimeout;
+extern const std::chrono::seconds kVaultHeartbeatTerminateTimeout;
+// A vault which exits unexpectedly is restarted after a delay which starts at zero and then doubles
+// from kInitialRestartDelay up to kMaxRestartDelay with each further failure.  Once it has failed
+// more than kMaxVaultRestarts times recently, it's only retried every kMaxRestartDelay.  Failures
+// are forgotten with a half-life of kRestartBudgetHalfLife.
 extern const int kMaxVaultRestarts;
+extern const std::chrono::milliseconds kInitialRestartDelay;
+extern const std::chrono::milliseconds kMaxRestartDelay;
+extern const std::chrono::minutes kRestartBudgetHalfLife;
+// Weights given to each new vault's cgroup (see VaultResourceLimits).  All vaults together share
+// the machine equally with the VaultManager itself under contention.
+extern const uint32_t kDefaultVaultCpuWeight;
+extern const uint32_t kDefaultVaultIoWeight;
+// Each running vault's resource usage is sampled every kResourceSampleInterval, and the most recent
+// kResourceSampleCount samples (30 minutes' worth by default) are kept.
+extern const std::chrono::seconds kResourceSampleInterval;
+extern const std::size_t kResourceSampleCount;
+// When a vault's chunkstore is moved, the bulk copy made while the vault keeps running is limited
+// to kChunkstoreCopyRate bytes per second, and the owner is sent progress every
+// kChunkstoreMoveProgressInterval.
+extern const uint64_t kChunkstoreCopyRate;
+extern const std::chrono::seconds kChunkstoreMoveProgressInterval;
+// Every kDiskQuotaInterval, the space on each filesystem is shared out afresh between the vaults
+// on it, keeping kDiskReservePercent of the filesystem free (see ComputeDiskQuotas).
+extern const std::chrono::seconds kDiskQuotaInterval;
+extern const uint64_t kDiskReservePercent;
+// How long a client may resume its session with a SessionTicket instead of signing a challenge.
+extern const std::chrono::seconds kSessionTicketLifetime;
+// Number of PmidAndSigners kept pre-generated for new vaults.
+extern const std::size_t kKeyPoolSize;
+extern const int kMaxPmidPublishAttempts;
+extern const std::size_t kMaxConfigJournalRecords;
+extern const std::chrono::milliseconds kConfigWriteCoalescingWindow;
 
 DEFINE_OSTREAMABLE_ENUM_VALUES(
     MessageTag, std::uint8_t,
     (ValidateConnectionRequest)(Challenge)(ChallengeResponse)(StartVaultRequest)(
         TakeOwnershipRequest)(VaultRunningResponse)(VaultStarted)(VaultStartedResponse)(
         VaultShutdownRequest)(MaxDiskUsageUpdate)(JoinedNetwork)(LogMessage)(SetNetworkAsStable)(
-        NetworkStableRequest)(NetworkStableResponse))
+        NetworkStableRequest)(NetworkStableResponse)(VaultStatusRequest)(VaultStatusResponse)(
+        SetVaultResourceLimitsRequest)(SetVaultResourceLimitsResponse)(VaultResourceUsageRequest)(
+        VaultResourceUsageResponse)(VaultHeartbeat)(MoveChunkstoreRequest)(
+        MoveChunkstoreResponse)(MoveChunkstoreProgress)(SessionTicket)(ResumeSessionRequest)(
+        StartVaultsRequest)(TakeOwnershipBatchRequest))
 
 }  // namespace vault_manager
 
@@ -19,11 +19,14 @@
 #ifndef MAIDSAFE_VAULT_MANAGER_CONFIG_FILE_H_
 #define MAIDSAFE_VAULT_MANAGER_CONFIG_FILE_H_
 
+#include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "maidsafe/common/config.h"
 #include "maidsafe/common/crypto.h"
+#include "maidsafe/common/error.h"
 #include "maidsafe/common/serialisation/types/boost_filesystem.h"
 
 #include "maidsafe/vault_manager/config.h"
@@ -60,34 +63,48 @@ struct ConfigFile {
     return *this;
   };
 
+  // Unversioned (version 0) files have the vault count straight after the key and IV.  Later
+  // versions write kVersionMarker there instead, followed by the version and then the count.
+  // Version 2 added each vault's NUMA node.
+  static const std::size_t kVersionMarker = static_cast<std::size_t>(-1);
+  static const std::uint32_t kVersion = 2;
+
   template <typename Archive>
   void load(Archive& archive) {
     std::size_t vault_count(0);
+    std::uint32_t version(0);
     archive(symm_key, symm_iv, vault_count);
+    if (vault_count == kVersionMarker)
+      archive(version, vault_count);
+    if (version > kVersion)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
     for (std::size_t i(0); i < vault_count; ++i) {
       VaultInfo vault;
-      crypto::CipherText encrypted_pmid, encrypted_anpmid;
+      // Each vault's record holds its immutable encrypted keys followed by its mutable fields.  The
+      // keys are left encrypted; 'pmid_and_signer' is set by the caller via DecryptVaultKeys.
+      auto encrypted_keys(std::make_shared<EncryptedVaultKeys>());
       bool has_owner_name(false);
-      archive(encrypted_pmid, encrypted_anpmid, vault.vault_dir, vault.label, vault.max_disk_usage,
-              has_owner_name);
-      vault.pmid_and_signer = std::make_shared<passport::PmidAndSigner>(
-          std::make_pair(passport::DecryptPmid(encrypted_pmid, symm_key, symm_iv),
-                         passport::DecryptAnpmid(encrypted_anpmid, symm_key, symm_iv)));
+      archive(*encrypted_keys, vault.vault_dir, vault.label, vault.max_disk_usage, has_owner_name);
       if (has_owner_name)
         archive(vault.owner_name);
+      if (version >= 2)
+        archive(vault.numa_node);
+      vault.encrypted_keys = std::move(encrypted_keys);
+      vaults.push_back(std::move(vault));
     }
   }
 
   template <typename Archive>
   void save(Archive& archive) const {
-    archive(symm_key, symm_iv, vaults.size());
+    std::size_t version_marker(kVersionMarker);
+    std::uint32_t version(kVersion);
+    archive(symm_key, symm_iv, version_marker, version, vaults.size());
     for (const auto& vault : vaults) {
-      archive(passport::EncryptPmid(vault.pmid_and_signer->first, symm_key, symm_iv),
-              passport::EncryptAnpmid(vault.pmid_and_signer->second, symm_key, symm_iv),
-              vault.vault_dir, vault.label, vault.max_disk_usage,
-              vault.owner_name->IsInitialised());
+      archive(*EncryptVaultKeys(vault, symm_key, symm_iv), vault.vault_dir, vault.label,
+              vault.max_disk_usage, vault.owner_name->IsInitialised());
       if (vault.owner_name->IsInitialised())
         archive(vault.owner_name);
+      archive(vault.numa_node);
     }
   }
 
@@ -96,6 +113,113 @@ struct ConfigFile {
   std::vector<VaultInfo> vaults;
 };
 
+// A single change to the set of vaults, appended to the config journal.  Replaying the journal on
+// top of the config file yields the current set of vaults.  kAdd and kUpdate both replace any
+// existing record with the same label, so replaying a record more than once is harmless.  Vaults
+// are never removed from the config file.
+struct ConfigJournalRecord {
+  enum class Type : int32_t { kAdd, kUpdate };
+
+  // As for ConfigFile, unversioned records start with the type, while later versions write
+  // kVersionMarker there, followed by the version and then the type.  Version 1 added the vault's
+  // NUMA node.
+  static const int32_t kVersionMarker = -1;
+  static const std::uint32_t kVersion = 1;
+
+  ConfigJournalRecord() = default;
+
+  ConfigJournalRecord(const ConfigJournalRecord&) = delete;
+
+  ConfigJournalRecord(ConfigJournalRecord&& other) MAIDSAFE_NOEXCEPT
+      : type(std::move(other.type)),
+        label(std::move(other.label)),
+        encrypted_keys(std::move(other.encrypted_keys)),
+        vault_dir(std::move(other.vault_dir)),
+        max_disk_usage(std::move(other.max_disk_usage)),
+        owner_name(std::move(other.owner_name)),
+        numa_node(std::move(other.numa_node)) {}
+
+  ConfigJournalRecord(Type type_in, const VaultInfo& vault, const crypto::AES256Key& symm_key,
+                      const crypto::AES256InitialisationVector& symm_iv)
+      : type(type_in),
+        label(vault.label),
+        encrypted_keys(EncryptVaultKeys(vault, symm_key, symm_iv)),
+        vault_dir(vault.vault_dir),
+        max_disk_usage(vault.max_disk_usage),
+        owner_name(vault.owner_name),
+        numa_node(vault.numa_node) {}
+
+  ~ConfigJournalRecord() = default;
+
+  ConfigJournalRecord& operator=(const ConfigJournalRecord&) = delete;
+
+  ConfigJournalRecord& operator=(ConfigJournalRecord&& other) MAIDSAFE_NOEXCEPT {
+    type = std::move(other.type);
+    label = std::move(other.label);
+    encrypted_keys = std::move(other.encrypted_keys);
+    vault_dir = std::move(other.vault_dir);
+    max_disk_usage = std::move(other.max_disk_usage);
+    owner_name = std::move(other.owner_name);
+    numa_node = std::move(other.numa_node);
+    return *this;
+  };
+
+  // The returned vault's keys are left encrypted; see DecryptVaultKeys.
+  VaultInfo ToVaultInfo() const {
+    VaultInfo vault;
+    vault.encrypted_keys = encrypted_keys;
+    vault.vault_dir = vault_dir;
+    vault.label = label;
+    vault.max_disk_usage = max_disk_usage;
+    vault.owner_name = owner_name;
+    vault.numa_node = numa_node;
+    return vault;
+  }
+
+  template <typename Archive>
+  void load(Archive& archive) {
+    int32_t type_or_marker(0);
+    std::uint32_t version(0);
+    archive(type_or_marker);
+    if (type_or_marker == kVersionMarker)
+      archive(version, type_or_marker);
+    if (version > kVersion || (type_or_marker != static_cast<int32_t>(Type::kAdd) &&
+                               type_or_marker != static_cast<int32_t>(Type::kUpdate))) {
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    }
+    type = static_cast<Type>(type_or_marker);
+    archive(label);
+    bool has_owner_name(false);
+    auto keys(std::make_shared<EncryptedVaultKeys>());
+    archive(*keys, vault_dir, max_disk_usage, has_owner_name);
+    encrypted_keys = std::move(keys);
+    if (has_owner_name)
+      archive(owner_name);
+    numa_node = -1;
+    if (version >= 1)
+      archive(numa_node);
+  }
+
+  template <typename Archive>
+  void save(Archive& archive) const {
+    int32_t version_marker(kVersionMarker);
+    std::uint32_t version(kVersion);
+    archive(version_marker, version, static_cast<int32_t>(type), label);
+    archive(*encrypted_keys, vault_dir, max_disk_usage, owner_name->IsInitialised());
+    if (owner_name->IsInitialised())
+      archive(owner_name);
+    archive(numa_node);
+  }
+
+  Type type;
+  NonEmptyString label;
+  std::shared_ptr<const EncryptedVaultKeys> encrypted_keys;
+  boost::filesystem::path vault_dir;
+  DiskUsage max_disk_usage;
+  passport::PublicMaid::Name owner_name;
+  int32_t numa_node;
+};
+
 }  // namespace vault_manager
 
 }  // namespace maidsafe
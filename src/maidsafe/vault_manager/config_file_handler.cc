@@ -18,16 +18,26 @@
 
 #include "maidsafe/vault_manager/config_file_handler.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
 #include <string>
+#include <thread>
+#include <utility>
 
 #include "boost/filesystem/operations.hpp"
 
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/make_unique.h"
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/serialisation/serialisation.h"
 #include "maidsafe/passport/passport.h"
 
+#include "maidsafe/vault_manager/config.h"
 #include "maidsafe/vault_manager/config_file.h"
 #include "maidsafe/vault_manager/utils.h"
 #include "maidsafe/vault_manager/vault_info.h"
@@ -49,39 +59,139 @@ ConfigFile ParseConfigFile(const fs::path& config_file_path, std::mutex& mutex)
   return ConvertFromString<ConfigFile>(content);
 }
 
-crypto::AES256Key InitialiseKey(const fs::path& config_file_path, std::mutex& mutex) {
+std::unique_ptr<ConfigFile> ParseConfigFileIfExists(const fs::path& config_file_path,
+                                                     std::mutex& mutex) {
   boost::system::error_code error_code;
   if (!fs::exists(config_file_path, error_code) ||
       error_code.value() == boost::system::errc::no_such_file_or_directory) {
-    return crypto::AES256Key{RandomString(crypto::AES256_KeySize)};
+    return nullptr;
   }
-  ConfigFile config{ParseConfigFile(config_file_path, mutex)};
-  return config.symm_key;
+  return maidsafe::make_unique<ConfigFile>(ParseConfigFile(config_file_path, mutex));
 }
 
-crypto::AES256InitialisationVector InitialiseIv(const fs::path& config_file_path,
-                                                std::mutex& mutex) {
+crypto::AES256Key InitialiseKey(const std::unique_ptr<ConfigFile>& config) {
+  return config ? config->symm_key : crypto::AES256Key{RandomString(crypto::AES256_KeySize)};
+}
+
+crypto::AES256InitialisationVector InitialiseIv(const std::unique_ptr<ConfigFile>& config) {
+  return config ? config->symm_iv
+                : crypto::AES256InitialisationVector{RandomString(crypto::AES256_IVSize)};
+}
+
+// Decrypts the vaults' keys, spreading the work across all cores.
+void DecryptAllVaultKeys(const std::vector<VaultInfo*>& vaults,
+                         const crypto::AES256Key& symm_key,
+                         const crypto::AES256InitialisationVector& symm_iv) {
+  std::size_t thread_count{std::min<std::size_t>(
+      vaults.size(), std::max<std::size_t>(1U, std::thread::hardware_concurrency()))};
+  std::vector<std::future<void>> decryptions;
+  for (std::size_t thread_index(0); thread_index < thread_count; ++thread_index) {
+    decryptions.emplace_back(std::async(std::launch::async, [&, thread_index] {
+      for (std::size_t i(thread_index); i < vaults.size(); i += thread_count) {
+        vaults[i]->pmid_and_signer =
+            DecryptVaultKeys(*vaults[i]->encrypted_keys, symm_key, symm_iv);
+      }
+    }));
+  }
+  // Wait for all of them before rethrowing any error, since they reference 'vaults'.
+  for (auto& decryption : decryptions)
+    decryption.wait();
+  for (auto& decryption : decryptions)
+    decryption.get();
+}
+
+const std::size_t kJournalRecordSizeBytes(4);
+
+fs::path GetJournalFilePath(const fs::path& config_file_path) {
+  fs::path journal_file_path{config_file_path};
+  journal_file_path += ".journal";
+  return journal_file_path;
+}
+
+// Each journal record is prefixed with its size as a 4-byte big-endian integer.
+std::string FrameJournalRecord(const ConfigJournalRecord& record) {
+  std::string serialised_record{ConvertToString(record)};
+  std::string framed_record(kJournalRecordSizeBytes, '\0');
+  uint32_t size{static_cast<uint32_t>(serialised_record.size())};
+  for (std::size_t i(0); i < kJournalRecordSizeBytes; ++i)
+    framed_record[i] = static_cast<char>((size >> (8 * (kJournalRecordSizeBytes - 1 - i))) & 0xFF);
+  return framed_record + serialised_record;
+}
+
+// Returns all complete records.  A torn or corrupt tail (e.g. from a crash mid-append) is dropped,
+// and the journal is rewritten without it so that subsequent appends aren't lost behind it.
+std::vector<ConfigJournalRecord> ReadJournal(const fs::path& journal_file_path,
+                                             std::mutex& mutex) {
+  std::vector<ConfigJournalRecord> records;
+  std::lock_guard<std::mutex> lock{mutex};
   boost::system::error_code error_code;
-  if (!fs::exists(config_file_path, error_code) ||
-      error_code.value() == boost::system::errc::no_such_file_or_directory) {
-    return crypto::AES256InitialisationVector{RandomString(crypto::AES256_IVSize)};
+  if (!fs::exists(journal_file_path, error_code) ||
+      fs::file_size(journal_file_path, error_code) == 0 || error_code) {
+    return records;
+  }
+
+  std::string content{ReadFile(journal_file_path).string()};
+  std::size_t offset{0};
+  while (content.size() - offset >= kJournalRecordSizeBytes) {
+    uint32_t size{0};
+    for (std::size_t i(0); i < kJournalRecordSizeBytes; ++i)
+      size = (size << 8) | static_cast<unsigned char>(content[offset + i]);
+    if (size == 0 || content.size() - offset - kJournalRecordSizeBytes < size)
+      break;
+    try {
+      records.emplace_back(ConvertFromString<ConfigJournalRecord>(
+          content.substr(offset + kJournalRecordSizeBytes, size)));
+    } catch (const std::exception& e) {
+      LOG(kWarning) << "Failed to parse config journal record: "
+                    << boost::diagnostic_information(e);
+      break;
+    }
+    offset += kJournalRecordSizeBytes + size;
   }
-  ConfigFile config{ParseConfigFile(config_file_path, mutex)};
-  return config.symm_iv;
+
+  if (offset != content.size()) {
+    LOG(kWarning) << "Dropping " << content.size() - offset << " trailing bytes from "
+                  << journal_file_path;
+    if (!WriteFileAtomically(journal_file_path, content.substr(0, offset))) {
+      LOG(kError) << "Failed to truncate config journal " << journal_file_path;
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    }
+  }
+  return records;
 }
 
 }  // unnamed namespace
 
 ConfigFileHandler::ConfigFileHandler(fs::path config_file_path)
     : config_file_path_(std::move(config_file_path)),
+      journal_file_path_(GetJournalFilePath(config_file_path_)),
       mutex_(),
-      kSymmKey_(InitialiseKey(config_file_path_, mutex_)),
-      kSymmIv_(InitialiseIv(config_file_path_, mutex_)) {
+      vaults_(),
+      journal_record_count_(0),
+      initial_config_(ParseConfigFileIfExists(config_file_path_, mutex_)),
+      kSymmKey_(InitialiseKey(initial_config_)),
+      kSymmIv_(InitialiseIv(initial_config_)),
+      pending_changes_mutex_(),
+      pending_changes_cond_var_(),
+      pending_changes_(),
+      stop_writer_(false),
+      writer_() {
   boost::system::error_code error_code;
   if (!fs::exists(config_file_path_, error_code) ||
       error_code.value() == boost::system::errc::no_such_file_or_directory) {
     CreateConfigFile();
   }
+  writer_ = std::thread{[this] { Run(); }};
+}
+
+ConfigFileHandler::~ConfigFileHandler() {
+  {
+    std::lock_guard<std::mutex> lock{pending_changes_mutex_};
+    stop_writer_ = true;
+  }
+  pending_changes_cond_var_.notify_one();
+  if (writer_.joinable())
+    writer_.join();
 }
 
 void ConfigFileHandler::CreateConfigFile() {
@@ -97,26 +207,186 @@ void ConfigFileHandler::CreateConfigFile() {
   }
 
   std::lock_guard<std::mutex> lock{mutex_};
-  if (!WriteFile(config_file_path_, ConvertToString(config))) {
+  if (!WriteFileAtomically(config_file_path_, ConvertToString(config))) {
     LOG(kError) << "Failed to create config file " << config_file_path_;
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
   }
+  // Any journal left over from a previous config file was encrypted with a different key.
+  fs::remove(journal_file_path_, error_code);
   LOG(kInfo) << "Created config file " << config_file_path_;
 }
 
-std::vector<VaultInfo> ConfigFileHandler::ReadConfigFile() const {
-  ConfigFile config{ParseConfigFile(config_file_path_, mutex_)};
+std::vector<VaultInfo> ConfigFileHandler::ReadConfigFile() {
+  // The config file was already parsed by the constructor unless it has just been created.
+  ConfigFile config{initial_config_ ? std::move(*initial_config_)
+                                    : ParseConfigFile(config_file_path_, mutex_)};
+  initial_config_.reset();
   assert(config.symm_key == kSymmKey_ && config.symm_iv == kSymmIv_);
-  return config.vaults;
+  std::vector<ConfigJournalRecord> records{ReadJournal(journal_file_path_, mutex_)};
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  vaults_.clear();
+  for (auto& vault : config.vaults) {
+    NonEmptyString label{vault.label};
+    vaults_[label] = std::move(vault);
+  }
+  for (const auto& record : records)
+    vaults_[record.label] = record.ToVaultInfo();
+  journal_record_count_ = records.size();
+
+  // Only decrypt the keys of the latest record for each vault.
+  std::vector<VaultInfo*> vaults_to_decrypt;
+  for (auto& vault : vaults_)
+    vaults_to_decrypt.push_back(&vault.second);
+  DecryptAllVaultKeys(vaults_to_decrypt, kSymmKey_, kSymmIv_);
+
+  std::vector<VaultInfo> vaults;
+  for (const auto& vault : vaults_)
+    vaults.push_back(vault.second);
+  return vaults;
 }
 
-void ConfigFileHandler::WriteConfigFile(std::vector<VaultInfo> vaults) const {
-  ConfigFile config(kSymmKey_, kSymmIv_, std::move(vaults));
+std::future<void> ConfigFileHandler::AddVault(const VaultInfo& vault) {
+  return Enqueue(ConfigJournalRecord::Type::kAdd, vault);
+}
+
+std::future<void> ConfigFileHandler::UpdateVault(const VaultInfo& vault) {
+  return Enqueue(ConfigJournalRecord::Type::kUpdate, vault);
+}
+
+std::future<void> ConfigFileHandler::UpdateVaults(const std::vector<VaultInfo>& vaults) {
+  return Enqueue(ConfigJournalRecord::Type::kUpdate, vaults);
+}
+
+std::future<void> ConfigFileHandler::Enqueue(ConfigJournalRecord::Type type, VaultInfo vault) {
+  // Don't keep the connection alive just because a change to its vault is queued.
+  vault.tcp_connection.reset();
+  PendingChange change{type, std::move(vault)};
+  std::future<void> committed{change.committed.get_future()};
+  {
+    std::lock_guard<std::mutex> lock{pending_changes_mutex_};
+    assert(!stop_writer_);
+    pending_changes_.push_back(std::move(change));
+  }
+  pending_changes_cond_var_.notify_one();
+  return committed;
+}
+
+std::future<void> ConfigFileHandler::Enqueue(ConfigJournalRecord::Type type,
+                                             std::vector<VaultInfo> vaults) {
+  auto committed(std::make_shared<std::vector<std::future<void>>>());
+  {
+    std::lock_guard<std::mutex> lock{pending_changes_mutex_};
+    assert(!stop_writer_);
+    for (auto& vault : vaults) {
+      vault.tcp_connection.reset();
+      PendingChange change{type, std::move(vault)};
+      committed->push_back(change.committed.get_future());
+      pending_changes_.push_back(std::move(change));
+    }
+  }
+  pending_changes_cond_var_.notify_one();
+  return std::async(std::launch::deferred, [committed] {
+    for (auto& change_committed : *committed)
+      change_committed.get();
+  });
+}
+
+void ConfigFileHandler::Run() {
+  for (;;) {
+    std::vector<PendingChange> changes;
+    {
+      std::unique_lock<std::mutex> lock{pending_changes_mutex_};
+      pending_changes_cond_var_.wait(
+          lock, [this] { return stop_writer_ || !pending_changes_.empty(); });
+      if (pending_changes_.empty())
+        return;
+      // Give the rest of this burst a chance to join the commit.  When stopping, just flush.
+      pending_changes_cond_var_.wait_for(lock, kConfigWriteCoalescingWindow,
+                                         [this] { return stop_writer_; });
+      changes.swap(pending_changes_);
+    }
+    Commit(std::move(changes));
+  }
+}
+
+void ConfigFileHandler::Commit(std::vector<PendingChange> changes) {
   std::lock_guard<std::mutex> lock{mutex_};
-  if (!WriteFile(config_file_path_, ConvertToString(config))) {
-    LOG(kError) << "Failed to write config file " << config_file_path_;
+  // Encryption failures only affect the change concerned; the rest are still committed.
+  std::string framed_records;
+  std::vector<PendingChange*> framed_changes;
+  for (auto& change : changes) {
+    try {
+      ReuseEncryptedKeys(change.vault);
+      change.vault.encrypted_keys = EncryptVaultKeys(change.vault, kSymmKey_, kSymmIv_);
+      framed_records += FrameJournalRecord(
+          ConfigJournalRecord{change.type, change.vault, kSymmKey_, kSymmIv_});
+      framed_changes.push_back(&change);
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to create config journal record: " << boost::diagnostic_information(e);
+      change.committed.set_exception(std::current_exception());
+    }
+  }
+  if (framed_changes.empty())
+    return;
+
+  try {
+    AppendToJournal(framed_records, framed_changes.size());
+  } catch (const std::exception&) {
+    for (auto change : framed_changes)
+      change->committed.set_exception(std::current_exception());
+    return;
+  }
+  for (auto change : framed_changes) {
+    vaults_[change->vault.label] = change->vault;
+    change->committed.set_value();
+  }
+  LOG(kVerbose) << "Committed " << framed_changes.size() << " config change(s)";
+  CompactIfRequired();
+}
+
+void ConfigFileHandler::ReuseEncryptedKeys(VaultInfo& vault) const {
+  if (vault.encrypted_keys)
+    return;
+  auto itr(vaults_.find(vault.label));
+  if (itr != std::end(vaults_) && itr->second.encrypted_keys &&
+      itr->second.pmid_and_signer->first.name() == vault.pmid_and_signer->first.name()) {
+    vault.encrypted_keys = itr->second.encrypted_keys;
+  }
+}
+
+void ConfigFileHandler::AppendToJournal(const std::string& framed_records,
+                                        std::size_t record_count) {
+  if (!AppendToFileDurably(journal_file_path_, framed_records)) {
+    LOG(kError) << "Failed to append to config journal " << journal_file_path_;
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
   }
+  journal_record_count_ += record_count;
+}
+
+void ConfigFileHandler::CompactIfRequired() {
+  if (journal_record_count_ <= vaults_.size() + kMaxConfigJournalRecords)
+    return;
+
+  std::vector<VaultInfo> vaults;
+  for (const auto& vault : vaults_)
+    vaults.push_back(vault.second);
+  ConfigFile config(kSymmKey_, kSymmIv_, std::move(vaults));
+  if (!WriteFileAtomically(config_file_path_, ConvertToString(config))) {
+    // The journal is still intact, so nothing has been lost.  Try again on the next change.
+    LOG(kError) << "Failed to compact config file " << config_file_path_;
+    return;
+  }
+  // If we crash before the journal is removed, replaying it on top of the new config file is
+  // harmless since its records are idempotent.
+  boost::system::error_code error_code;
+  fs::remove(journal_file_path_, error_code);
+  if (error_code) {
+    LOG(kError) << "Failed to remove config journal " << journal_file_path_ << ": "
+                << error_code.message();
+  }
+  journal_record_count_ = 0;
+  LOG(kVerbose) << "Compacted config file " << config_file_path_;
 }
 
 }  // namespace vault_manager
@@ -19,25 +19,52 @@
 #ifndef MAIDSAFE_VAULT_MANAGER_CONFIG_FILE_HANDLER_H_
 #define MAIDSAFE_VAULT_MANAGER_CONFIG_FILE_HANDLER_H_
 
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "boost/filesystem/path.hpp"
 
 #include "maidsafe/common/crypto.h"
+#include "maidsafe/common/types.h"
 #include "maidsafe/passport/types.h"
 
+#include "maidsafe/vault_manager/config_file.h"
+#include "maidsafe/vault_manager/vault_info.h"
+
 namespace maidsafe {
 
 namespace vault_manager {
 
-struct VaultInfo;
-
+// Persists the set of vaults as a config file plus an append-only journal of per-vault changes.
+// Each change costs one journal record (one vault's worth of encryption and a single durable
+// append).  Once the journal grows beyond the number of vaults plus kMaxConfigJournalRecords, it
+// is compacted by atomically rewriting the config file and then clearing the journal.
+//
+// Changes are written by a dedicated thread.  Changes queued within kConfigWriteCoalescingWindow
+// of the first one in a burst are committed together with a single durable append.
 class ConfigFileHandler {
  public:
   explicit ConfigFileHandler(boost::filesystem::path config_file_path);
-  std::vector<VaultInfo> ReadConfigFile() const;
-  void WriteConfigFile(std::vector<VaultInfo> vaults) const;
+  // Commits any queued changes before returning.
+  ~ConfigFileHandler();
+  // Reads the config file and replays the journal on top of it.  The vaults' keys are decrypted
+  // in parallel once the replay is complete.
+  std::vector<VaultInfo> ReadConfigFile();
+  // These queue a change and return without blocking.  The returned future becomes ready once the
+  // change is on disk, or holds the error if it couldn't be written.  Both replace any existing
+  // entry with the same label.
+  std::future<void> AddVault(const VaultInfo& vault);
+  std::future<void> UpdateVault(const VaultInfo& vault);
+  // As UpdateVault, but the changes are queued together so that they're committed with a single
+  // durable append.  The returned future is ready once all are on disk, or holds the first error.
+  std::future<void> UpdateVaults(const std::vector<VaultInfo>& vaults);
   const crypto::AES256Key& SymmKey() const { return kSymmKey_; }
   const crypto::AES256InitialisationVector& SymmIv() const { return kSymmIv_; }
 
@@ -46,12 +73,40 @@ class ConfigFileHandler {
   ConfigFileHandler(ConfigFileHandler&&) = delete;
   ConfigFileHandler operator=(ConfigFileHandler) = delete;
 
-  void CreateConfigFile();
+  struct PendingChange {
+    PendingChange(ConfigJournalRecord::Type type_in, VaultInfo vault_in)
+        : type(type_in), vault(std::move(vault_in)), committed() {}
+    PendingChange(PendingChange&& other)
+        : type(other.type), vault(std::move(other.vault)), committed(std::move(other.committed)) {}
+    ConfigJournalRecord::Type type;
+    VaultInfo vault;
+    std::promise<void> committed;
+  };
 
-  boost::filesystem::path config_file_path_;
+  void CreateConfigFile();
+  std::future<void> Enqueue(ConfigJournalRecord::Type type, VaultInfo vault);
+  std::future<void> Enqueue(ConfigJournalRecord::Type type, std::vector<VaultInfo> vaults);
+  void Run();
+  void Commit(std::vector<PendingChange> changes);
+  // Takes the cached ciphertext of the vault's keys from 'vaults_' if 'vault' doesn't have it.
+  // Must be called with 'mutex_' locked.
+  void ReuseEncryptedKeys(VaultInfo& vault) const;
+  void AppendToJournal(const std::string& framed_records, std::size_t record_count);
+  void CompactIfRequired();
+
+  boost::filesystem::path config_file_path_, journal_file_path_;
   mutable std::mutex mutex_;
+  std::map<NonEmptyString, VaultInfo> vaults_;
+  std::size_t journal_record_count_;
+  // Holds the config file parsed on construction until ReadConfigFile consumes it.
+  std::unique_ptr<ConfigFile> initial_config_;
   const crypto::AES256Key kSymmKey_;
   const crypto::AES256InitialisationVector kSymmIv_;
+  std::mutex pending_changes_mutex_;
+  std::condition_variable pending_changes_cond_var_;
+  std::vector<PendingChange> pending_changes_;
+  bool stop_writer_;
+  std::thread writer_;
 };
 
 }  // namespace vault_manager
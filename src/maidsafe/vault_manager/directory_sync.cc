@@ -0,0 +1,363 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/directory_sync.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef MAIDSAFE_LINUX
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/on_scope_exit.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+const std::size_t kCopyChunkSize(1 << 20);
+// Files are copied to a temporary name then renamed, so a partial copy is never mistaken for a
+// complete one.
+const std::string kPartialSuffix(".partial");
+// Filesystems only update modification times every clock tick (or worse, e.g. FAT's two seconds),
+// so a file modified this close to a scan may be modified again without its time changing.
+const std::chrono::seconds kWriteTimeGranularity(2);
+
+// Modification times are compared in nanoseconds since the epoch.  Only Linux provides them at
+// better than one-second resolution.
+typedef int64_t WriteTime;
+
+struct FileDetails {
+  uint64_t size;
+  WriteTime last_write_time;
+};
+
+// Relative path to details for every regular file under 'root', plus every directory.
+struct Tree {
+  std::map<fs::path, FileDetails> files;
+  std::set<fs::path> directories;
+};
+
+fs::path RelativePath(const fs::path& root, const fs::path& path) {
+  fs::path relative;
+  auto path_itr(path.begin());
+  for (auto root_itr(root.begin()); root_itr != root.end() && path_itr != path.end(); ++root_itr)
+    ++path_itr;
+  for (; path_itr != path.end(); ++path_itr)
+    relative /= *path_itr;
+  return relative;
+}
+
+void ThrowIoError(const fs::path& path, const std::string& action) {
+  LOG(kError) << "Failed to " << action << ' ' << path << ": " << std::strerror(errno);
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+}
+
+WriteTime Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+WriteTime LastWriteTime(const fs::path& path) {
+#ifdef MAIDSAFE_LINUX
+  struct stat details;
+  if (stat(path.c_str(), &details) != 0)
+    ThrowIoError(path, "get details of");
+  return static_cast<WriteTime>(details.st_mtim.tv_sec) * 1000000000 + details.st_mtim.tv_nsec;
+#else
+  return static_cast<WriteTime>(fs::last_write_time(path)) * 1000000000;
+#endif
+}
+
+void SetLastWriteTime(const fs::path& path, WriteTime last_write_time) {
+#ifdef MAIDSAFE_LINUX
+  timespec times[2];
+  times[0].tv_sec = 0;
+  times[0].tv_nsec = UTIME_OMIT;  // i.e. leave the access time alone.
+  times[1].tv_sec = static_cast<time_t>(last_write_time / 1000000000);
+  times[1].tv_nsec = static_cast<long>(last_write_time % 1000000000);  // NOLINT (long)
+  if (utimensat(AT_FDCWD, path.c_str(), times, 0) != 0)
+    ThrowIoError(path, "set modification time of");
+#else
+  fs::last_write_time(path, static_cast<std::time_t>(last_write_time / 1000000000));
+#endif
+}
+
+Tree Scan(const fs::path& root) {
+  Tree tree;
+  for (fs::recursive_directory_iterator itr(root), end; itr != end; ++itr) {
+    fs::file_status status{itr->symlink_status()};
+    if (fs::is_directory(status)) {
+      tree.directories.insert(RelativePath(root, itr->path()));
+    } else if (fs::is_regular_file(status)) {
+      tree.files.emplace(RelativePath(root, itr->path()),
+                         FileDetails{fs::file_size(itr->path()), LastWriteTime(itr->path())});
+    }
+  }
+  return tree;
+}
+
+class Throttle {
+ public:
+  explicit Throttle(uint64_t max_bytes_per_second)
+      : max_bytes_per_second_(max_bytes_per_second),
+        start_(std::chrono::steady_clock::now()),
+        bytes_(0) {}
+
+  void Consume(uint64_t bytes) {
+    if (max_bytes_per_second_ == 0)
+      return;
+    bytes_ += bytes;
+    std::this_thread::sleep_until(
+        start_ + std::chrono::microseconds(bytes_ * 1000000 / max_bytes_per_second_));
+  }
+
+ private:
+  const uint64_t max_bytes_per_second_;
+  const std::chrono::steady_clock::time_point start_;
+  uint64_t bytes_;
+};
+
+class Progress {
+ public:
+  Progress(const SyncProgressFunctor& on_progress, uint64_t total)
+      : on_progress_(on_progress), done_(0), total_(total) {}
+
+  bool Add(uint64_t bytes) {
+    done_ += bytes;
+    return !on_progress_ || on_progress_(std::min(done_, total_), total_);
+  }
+
+ private:
+  const SyncProgressFunctor& on_progress_;
+  uint64_t done_;
+  const uint64_t total_;
+};
+
+// Returns false if cancelled.
+bool StreamFile(const fs::path& source, const fs::path& target, Throttle& throttle,
+                Progress& progress) {
+  std::ifstream input(source.string(), std::ios::binary);
+  std::ofstream output(target.string(), std::ios::binary | std::ios::trunc);
+  if (!input || !output)
+    ThrowIoError(source, "open for copying");
+  std::vector<char> buffer(kCopyChunkSize);
+  while (input) {
+    input.read(buffer.data(), buffer.size());
+    std::streamsize count{input.gcount()};
+    if (count == 0)
+      break;
+    if (!output.write(buffer.data(), count))
+      ThrowIoError(target, "write");
+    throttle.Consume(static_cast<uint64_t>(count));
+    if (!progress.Add(static_cast<uint64_t>(count)))
+      return false;
+  }
+  if (input.bad())
+    ThrowIoError(source, "read");
+  output.close();
+  if (!output)
+    ThrowIoError(target, "write");
+  return true;
+}
+
+#ifdef MAIDSAFE_LINUX
+enum class CopyResult { kDone, kCancelled, kUnsupported };
+
+CopyResult CopyInKernel(const fs::path& source, const fs::path& target, Throttle& throttle,
+                        Progress& progress) {
+  int input{open(source.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (input < 0)
+    ThrowIoError(source, "open");
+  on_scope_exit close_input([input] { close(input); });
+  int output{open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)};
+  if (output < 0)
+    ThrowIoError(target, "create");
+  on_scope_exit close_output([output] { close(output); });
+
+#ifdef FICLONE
+  // A clone shares the source's extents, so costs no IO and isn't throttled.
+  if (ioctl(output, FICLONE, input) == 0)
+    return progress.Add(fs::file_size(source)) ? CopyResult::kDone : CopyResult::kCancelled;
+#endif
+#ifdef SYS_copy_file_range
+  bool copied_any{false};
+  for (;;) {
+    ssize_t count{syscall(SYS_copy_file_range, input, nullptr, output, nullptr, kCopyChunkSize,
+                          0U)};
+    if (count < 0) {
+      if (!copied_any && (errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+                          errno == EOPNOTSUPP || errno == EPERM)) {
+        return CopyResult::kUnsupported;
+      }
+      ThrowIoError(source, "copy");
+    }
+    if (count == 0)
+      return CopyResult::kDone;
+    copied_any = true;
+    throttle.Consume(static_cast<uint64_t>(count));
+    if (!progress.Add(static_cast<uint64_t>(count)))
+      return CopyResult::kCancelled;
+  }
+#else
+  return CopyResult::kUnsupported;
+#endif
+}
+#endif
+
+// Returns false if cancelled.
+bool CopyFile(const fs::path& source, const fs::path& target, WriteTime last_write_time,
+              Throttle& throttle, Progress& progress) {
+  fs::path partial{target.string() + kPartialSuffix};
+  bool done{false};
+  on_scope_exit remove_partial([&] {
+    if (!done) {
+      boost::system::error_code ignored_ec;
+      fs::remove(partial, ignored_ec);
+    }
+  });
+#ifdef MAIDSAFE_LINUX
+  CopyResult result{CopyInKernel(source, partial, throttle, progress)};
+  if (result == CopyResult::kCancelled)
+    return false;
+  if (result == CopyResult::kUnsupported && !StreamFile(source, partial, throttle, progress))
+    return false;
+#else
+  if (!StreamFile(source, partial, throttle, progress))
+    return false;
+#endif
+  SetLastWriteTime(partial, last_write_time);
+  fs::rename(partial, target);
+  done = true;
+  return true;
+}
+
+// Returns true if 'path' is 'root' or lies under it.  Both must be canonical.
+bool IsWithin(const fs::path& path, const fs::path& root) {
+  auto path_itr(path.begin());
+  for (auto root_itr(root.begin()); root_itr != root.end(); ++root_itr, ++path_itr) {
+    if (path_itr == path.end() || *path_itr != *root_itr)
+      return false;
+  }
+  return true;
+}
+
+}  // unnamed namespace
+
+bool DirectoriesOverlap(const fs::path& lhs, const fs::path& rhs) {
+  auto canonical = [](const fs::path& path) {
+    fs::path result{fs::weakly_canonical(fs::absolute(path))};
+    // A trailing separator leaves a final "." element.
+    return result.filename() == "." ? result.parent_path() : result;
+  };
+  fs::path canonical_lhs{canonical(lhs)}, canonical_rhs{canonical(rhs)};
+  return IsWithin(canonical_lhs, canonical_rhs) || IsWithin(canonical_rhs, canonical_lhs);
+}
+
+bool SyncDirectory(const fs::path& source, const fs::path& target, uint64_t max_bytes_per_second,
+                   const SyncProgressFunctor& on_progress) {
+  try {
+    if (DirectoriesOverlap(source, target)) {
+      LOG(kError) << "Can't sync " << source << " to " << target
+                  << " since one contains the other.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+    }
+    // Each copy is stamped with its source's time as at the scan, so if the source changes after
+    // that, the next sync copies it again.  A source modified too recently to be sure its time
+    // would change again is stamped with a time it can't have, so the next sync copies it anyway.
+    WriteTime latest_reliable_time{
+        Now() - std::chrono::duration_cast<std::chrono::nanoseconds>(kWriteTimeGranularity)
+                    .count()};
+    Tree source_tree{Scan(source)};
+    fs::create_directories(target);
+    Tree target_tree{Scan(target)};
+
+    // Remove anything in the target which is no longer in the source, deepest paths first.
+    for (auto itr(target_tree.files.rbegin()); itr != target_tree.files.rend(); ++itr) {
+      if (source_tree.files.count(itr->first) == 0U)
+        fs::remove(target / itr->first);
+    }
+    for (auto itr(target_tree.directories.rbegin()); itr != target_tree.directories.rend();
+         ++itr) {
+      if (source_tree.directories.count(*itr) == 0U)
+        fs::remove_all(target / *itr);
+    }
+    for (const auto& directory : source_tree.directories)
+      fs::create_directories(target / directory);
+
+    std::vector<std::pair<fs::path, FileDetails>> to_copy;
+    uint64_t total{0};
+    for (const auto& file : source_tree.files) {
+      auto existing(target_tree.files.find(file.first));
+      if (existing != std::end(target_tree.files) && existing->second.size == file.second.size &&
+          existing->second.last_write_time == file.second.last_write_time) {
+        continue;
+      }
+      to_copy.push_back(file);
+      total += file.second.size;
+    }
+
+    Throttle throttle{max_bytes_per_second};
+    Progress progress{on_progress, total};
+    if (!progress.Add(0))
+      return false;
+    for (const auto& file : to_copy) {
+      boost::system::error_code ec;
+      // The source may have been removed since the scan, in which case the next sync removes it
+      // from the target too.
+      if (!fs::exists(source / file.first, ec))
+        continue;
+      WriteTime stamp{file.second.last_write_time < latest_reliable_time
+                          ? file.second.last_write_time
+                          : 0};
+      if (!CopyFile(source / file.first, target / file.first, stamp, throttle, progress))
+        return false;
+    }
+    return true;
+  } catch (const fs::filesystem_error& error) {
+    LOG(kError) << "Failed to sync " << source << " to " << target << ": " << error.what();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -0,0 +1,57 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_DIRECTORY_SYNC_H_
+#define MAIDSAFE_VAULT_MANAGER_DIRECTORY_SYNC_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "boost/filesystem/path.hpp"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Called with the bytes copied so far and the total to be copied.  Returning false cancels.
+typedef std::function<bool(uint64_t, uint64_t)> SyncProgressFunctor;
+
+// Makes 'target' a copy of the regular files and directories under 'source', removing anything in
+// 'target' which isn't in 'source'.  Files already in 'target' with the same size and modification
+// time (to the nanosecond where the platform allows) are skipped, so a second pass only copies what
+// changed since the first, plus any file modified within a couple of seconds of the first pass
+// starting, whose time might not have changed if it was modified again.  This lets a directory
+// which is still being written to be copied in bulk, then brought up to date quickly once writing
+// has stopped.  Throws if either of 'source' and 'target' contains the other.
+//
+// Each file is cloned (reflinked) where the filesystem supports it, else copied in-kernel via
+// copy_file_range, else streamed.  Copying (but not cloning) is limited to 'max_bytes_per_second'
+// where that's non-zero.  'on_progress' may be null.  Returns false if cancelled, and throws on
+// error.  In either case, files copied so far are left in 'target'.
+bool SyncDirectory(const boost::filesystem::path& source, const boost::filesystem::path& target,
+                   uint64_t max_bytes_per_second, const SyncProgressFunctor& on_progress);
+
+// Returns true if 'lhs' and 'rhs' are the same directory or either lies under the other, once
+// symlinks, "." and ".." are resolved.  Neither need exist.  SyncDirectory throws for such a pair.
+bool DirectoriesOverlap(const boost::filesystem::path& lhs, const boost::filesystem::path& rhs);
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_DIRECTORY_SYNC_H_
@@ -0,0 +1,127 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/disk_quota.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#ifndef MAIDSAFE_WIN32
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+uint64_t Clamp(uint64_t level, const VaultDiskUsage& vault) {
+  uint64_t ceiling{vault.limit == 0 ? std::numeric_limits<uint64_t>::max() : vault.limit};
+  uint64_t floor{std::min(vault.used, ceiling)};
+  return std::min(std::max(level, floor), ceiling);
+}
+
+uint64_t Total(uint64_t level, const std::vector<const VaultDiskUsage*>& vaults) {
+  uint64_t total{0};
+  for (const auto& vault : vaults)
+    total += Clamp(level, *vault);
+  return total;
+}
+
+}  // unnamed namespace
+
+std::map<std::string, uint64_t> ComputeDiskQuotas(
+    const std::vector<VaultDiskUsage>& vaults,
+    const std::map<uint64_t, FilesystemSpace>& filesystems) {
+  std::map<std::string, uint64_t> quotas;
+  for (const auto& filesystem : filesystems) {
+    std::vector<const VaultDiskUsage*> sharing;
+    uint64_t used{0};
+    for (const auto& vault : vaults) {
+      if (vault.filesystem == filesystem.first) {
+        sharing.push_back(&vault);
+        used += vault.used;
+      }
+    }
+    if (sharing.empty())
+      continue;
+
+    uint64_t reserve{filesystem.second.capacity / 100 * kDiskReservePercent};
+    uint64_t budget{used + (filesystem.second.available > reserve
+                                ? filesystem.second.available - reserve
+                                : 0)};
+    // Find the highest common level which fits within the budget once each vault's level is
+    // clamped to its own bounds.
+    uint64_t low{0}, high{budget};
+    while (low < high) {
+      uint64_t middle{low + (high - low + 1) / 2};
+      if (Total(middle, sharing) <= budget)
+        low = middle;
+      else
+        high = middle - 1;
+    }
+    for (const auto& vault : sharing)
+      quotas[vault->label] = Clamp(low, *vault);
+  }
+  return quotas;
+}
+
+uint64_t DirectorySize(const fs::path& directory) {
+  uint64_t size{0};
+  boost::system::error_code ec;
+  for (fs::recursive_directory_iterator itr(directory), end; itr != end; itr.increment(ec)) {
+    if (ec)
+      break;
+    if (fs::is_regular_file(itr->symlink_status())) {
+      // The vault may remove files while they're being counted.
+      uint64_t file_size{fs::file_size(itr->path(), ec)};
+      if (!ec)
+        size += file_size;
+    }
+  }
+  return size;
+}
+
+uint64_t FilesystemId(const fs::path& path) {
+#ifdef MAIDSAFE_WIN32
+  return std::hash<std::string>()(fs::canonical(path).root_name().string());
+#else
+  struct stat status;
+  if (stat(path.c_str(), &status) != 0) {
+    LOG(kWarning) << "Failed to stat " << path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  return static_cast<uint64_t>(status.st_dev);
+#endif
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
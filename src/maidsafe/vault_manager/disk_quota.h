@@ -0,0 +1,64 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_DISK_QUOTA_H_
+#define MAIDSAFE_VAULT_MANAGER_DISK_QUOTA_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+struct VaultDiskUsage {
+  std::string label;
+  // Identifies the filesystem holding the vault's directory (see FilesystemId).
+  uint64_t filesystem;
+  uint64_t used;
+  // The most the vault's owner allows it to use, or 0 for no limit.
+  uint64_t limit;
+};
+
+struct FilesystemSpace {
+  uint64_t capacity;
+  uint64_t available;
+};
+
+// Shares out the space on each filesystem between the vaults on it, returning each vault's quota
+// keyed by label.  The space which vaults may use in total is what they already use plus what's
+// available, less kDiskReservePercent of the filesystem's capacity.  That's divided as evenly as
+// possible, except that no vault gets more than its limit (the remainder going to the others) or
+// less than it already uses.
+std::map<std::string, uint64_t> ComputeDiskQuotas(
+    const std::vector<VaultDiskUsage>& vaults,
+    const std::map<uint64_t, FilesystemSpace>& filesystems);
+
+// These block while reading from disk, and throw on error.
+uint64_t DirectorySize(const boost::filesystem::path& directory);
+uint64_t FilesystemId(const boost::filesystem::path& path);
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_DISK_QUOTA_H_
@@ -0,0 +1,227 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/key_pool.h"
+
+#ifdef MAIDSAFE_WIN32
+#include <windows.h>
+#elif defined(MAIDSAFE_LINUX)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+
+#include "maidsafe/vault_manager/utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+struct KeyPoolFile {
+  KeyPoolFile() = default;
+  KeyPoolFile(const KeyPoolFile&) = delete;
+  KeyPoolFile(KeyPoolFile&& other) MAIDSAFE_NOEXCEPT
+      : encrypted_keys(std::move(other.encrypted_keys)) {}
+  ~KeyPoolFile() = default;
+  KeyPoolFile& operator=(const KeyPoolFile&) = delete;
+  KeyPoolFile& operator=(KeyPoolFile&& other) MAIDSAFE_NOEXCEPT {
+    encrypted_keys = std::move(other.encrypted_keys);
+    return *this;
+  }
+
+  template <typename Archive>
+  void load(Archive& archive) {
+    std::size_t key_count(0);
+    archive(key_count);
+    for (std::size_t i(0); i < key_count; ++i) {
+      crypto::CipherText encrypted_pmid, encrypted_anpmid;
+      archive(encrypted_pmid, encrypted_anpmid);
+      encrypted_keys.emplace_back(std::move(encrypted_pmid), std::move(encrypted_anpmid));
+    }
+  }
+
+  template <typename Archive>
+  void save(Archive& archive) const {
+    archive(encrypted_keys.size());
+    for (const auto& encrypted_key : encrypted_keys)
+      archive(encrypted_key.first, encrypted_key.second);
+  }
+
+  std::vector<std::pair<crypto::CipherText, crypto::CipherText>> encrypted_keys;
+};
+
+void LowerThreadPriority() {
+#ifdef MAIDSAFE_WIN32
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(MAIDSAFE_LINUX)
+  // Nice values apply per-thread on Linux.
+  if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19) != 0)
+    LOG(kWarning) << "Failed to lower priority of key generation thread.";
+#endif
+}
+
+}  // unnamed namespace
+
+KeyPool::PooledKeys::PooledKeys(passport::PmidAndSigner keys_in, const crypto::AES256Key& symm_key,
+                                const crypto::AES256InitialisationVector& symm_iv)
+    : keys(std::move(keys_in)),
+      encrypted_pmid(passport::EncryptPmid(keys.first, symm_key, symm_iv)),
+      encrypted_anpmid(passport::EncryptAnpmid(keys.second, symm_key, symm_iv)) {}
+
+KeyPool::PooledKeys::PooledKeys(passport::PmidAndSigner keys_in,
+                                crypto::CipherText encrypted_pmid_in,
+                                crypto::CipherText encrypted_anpmid_in)
+    : keys(std::move(keys_in)),
+      encrypted_pmid(std::move(encrypted_pmid_in)),
+      encrypted_anpmid(std::move(encrypted_anpmid_in)) {}
+
+KeyPool::KeyPool(fs::path pool_file_path, crypto::AES256Key symm_key,
+                 crypto::AES256InitialisationVector symm_iv, std::size_t target_size)
+    : kPoolFilePath_(std::move(pool_file_path)),
+      kSymmKey_(std::move(symm_key)),
+      kSymmIv_(std::move(symm_iv)),
+      kTargetSize_(target_size),
+      mutex_(),
+      condition_(),
+      keys_(),
+      stop_(false),
+      generator_() {
+  Load();
+  generator_ = std::thread([this] { Run(); });
+}
+
+KeyPool::~KeyPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  condition_.notify_one();
+  generator_.join();
+}
+
+passport::PmidAndSigner KeyPool::Get(std::shared_ptr<const EncryptedVaultKeys>* encrypted_keys) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (!keys_.empty()) {
+      PooledKeys pooled_keys{std::move(keys_.front())};
+      keys_.pop_front();
+      try {
+        Persist();
+        condition_.notify_one();
+        if (encrypted_keys) {
+          auto pooled_encrypted_keys(std::make_shared<EncryptedVaultKeys>());
+          pooled_encrypted_keys->encrypted_pmid = std::move(pooled_keys.encrypted_pmid);
+          pooled_encrypted_keys->encrypted_anpmid = std::move(pooled_keys.encrypted_anpmid);
+          *encrypted_keys = std::move(pooled_encrypted_keys);
+        }
+        return std::move(pooled_keys.keys);
+      } catch (const std::exception& e) {
+        // The key is still on disk, so it mustn't be handed out.  Keep it pooled and fall back to
+        // generating a fresh one.
+        LOG(kError) << boost::diagnostic_information(e);
+        keys_.push_front(std::move(pooled_keys));
+      }
+    }
+  }
+  condition_.notify_one();
+  LOG(kInfo) << "Key pool empty; generating PmidAndSigner on demand.";
+  return passport::CreatePmidAndSigner();
+}
+
+std::size_t KeyPool::Size() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return keys_.size();
+}
+
+void KeyPool::Run() {
+  LowerThreadPriority();
+  std::unique_lock<std::mutex> lock{mutex_};
+  for (;;) {
+    condition_.wait(lock, [this] { return stop_ || keys_.size() < kTargetSize_; });
+    if (stop_)
+      return;
+    lock.unlock();
+    try {
+      PooledKeys pooled_keys{passport::CreatePmidAndSigner(), kSymmKey_, kSymmIv_};
+      lock.lock();
+      keys_.push_back(std::move(pooled_keys));
+      Persist();
+      LOG(kVerbose) << "Key pool now holds " << keys_.size() << " PmidAndSigners.";
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to refill key pool: " << boost::diagnostic_information(e);
+      if (!lock.owns_lock())
+        lock.lock();
+      condition_.wait_for(lock, std::chrono::seconds(10), [this] { return stop_; });
+    }
+  }
+}
+
+void KeyPool::Load() {
+  boost::system::error_code error_code;
+  if (!fs::exists(kPoolFilePath_, error_code))
+    return;
+  try {
+    KeyPoolFile pool_file{ConvertFromString<KeyPoolFile>(ReadFile(kPoolFilePath_).string())};
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (auto& encrypted_key : pool_file.encrypted_keys) {
+      passport::PmidAndSigner keys{
+          std::make_pair(passport::DecryptPmid(encrypted_key.first, kSymmKey_, kSymmIv_),
+                         passport::DecryptAnpmid(encrypted_key.second, kSymmKey_, kSymmIv_))};
+      keys_.emplace_back(std::move(keys), std::move(encrypted_key.first),
+                         std::move(encrypted_key.second));
+    }
+    LOG(kInfo) << "Loaded " << keys_.size() << " PmidAndSigners from " << kPoolFilePath_;
+  } catch (const std::exception& e) {
+    LOG(kWarning) << "Discarding unreadable key pool " << kPoolFilePath_ << ": "
+                  << boost::diagnostic_information(e);
+    std::lock_guard<std::mutex> lock{mutex_};
+    keys_.clear();
+  }
+}
+
+void KeyPool::Persist() const {
+  KeyPoolFile pool_file;
+  for (const auto& pooled_keys : keys_)
+    pool_file.encrypted_keys.emplace_back(pooled_keys.encrypted_pmid, pooled_keys.encrypted_anpmid);
+  if (!WriteFileAtomically(kPoolFilePath_, ConvertToString(pool_file))) {
+    LOG(kError) << "Failed to write key pool file " << kPoolFilePath_;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -0,0 +1,91 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_KEY_POOL_H_
+#define MAIDSAFE_VAULT_MANAGER_KEY_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/passport/passport.h"
+
+#include "maidsafe/vault_manager/vault_info.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Keeps a number of pre-generated PmidAndSigners ready for new vaults, so that starting a vault
+// doesn't have to wait for RSA key generation.  The pool is refilled by a single low-priority
+// background thread and is held encrypted on disk so that it survives restarts.  A key is removed
+// from the file before it's handed out, so no key can ever be given to two vaults.
+class KeyPool {
+ public:
+  KeyPool(boost::filesystem::path pool_file_path, crypto::AES256Key symm_key,
+          crypto::AES256InitialisationVector symm_iv, std::size_t target_size);
+  ~KeyPool();
+
+  // Returns a pooled PmidAndSigner if one is available, otherwise generates one on the calling
+  // thread.  Either way, the pool is topped up in the background.  Since the pool is encrypted with
+  // the config file's key, a pooled key's ciphertext is also returned via 'encrypted_keys' if it's
+  // non-null, saving the config file handler from encrypting it again.
+  passport::PmidAndSigner Get(std::shared_ptr<const EncryptedVaultKeys>* encrypted_keys = nullptr);
+  std::size_t Size() const;
+
+ private:
+  KeyPool(const KeyPool&) = delete;
+  KeyPool(KeyPool&&) = delete;
+  KeyPool& operator=(KeyPool) = delete;
+
+  struct PooledKeys {
+    PooledKeys(passport::PmidAndSigner keys_in, const crypto::AES256Key& symm_key,
+               const crypto::AES256InitialisationVector& symm_iv);
+    PooledKeys(passport::PmidAndSigner keys_in, crypto::CipherText encrypted_pmid_in,
+               crypto::CipherText encrypted_anpmid_in);
+    passport::PmidAndSigner keys;
+    crypto::CipherText encrypted_pmid, encrypted_anpmid;
+  };
+
+  void Run();
+  void Load();
+  // Must be called with 'mutex_' locked.
+  void Persist() const;
+
+  const boost::filesystem::path kPoolFilePath_;
+  const crypto::AES256Key kSymmKey_;
+  const crypto::AES256InitialisationVector kSymmIv_;
+  const std::size_t kTargetSize_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<PooledKeys> keys_;
+  bool stop_;
+  std::thread generator_;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_KEY_POOL_H_
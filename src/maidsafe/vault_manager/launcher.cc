@@ -0,0 +1,397 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/launcher.h"
+
+#ifndef MAIDSAFE_WIN32
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+#ifdef MAIDSAFE_LINUX
+#include <sched.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef MAIDSAFE_APPLE
+#include <crt_externs.h>
+#else
+extern "C" char** environ;
+#endif
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/on_scope_exit.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+char** Environment() {
+#ifdef MAIDSAFE_APPLE
+  return *_NSGetEnviron();
+#else
+  return environ;
+#endif
+}
+
+// Used where the process couldn't be placed in its cgroup as it was created.
+void MoveToCgroup(pid_t pid, int cgroup_fd) {
+  int procs_fd{openat(cgroup_fd, "cgroup.procs", O_WRONLY | O_CLOEXEC)};
+  std::string process_id{std::to_string(pid)};
+  if (procs_fd < 0 ||
+      write(procs_fd, process_id.data(), process_id.size()) !=
+          static_cast<ssize_t>(process_id.size())) {
+    LOG(kWarning) << "Failed to move process " << pid << " into its cgroup: "
+                  << std::strerror(errno);
+  }
+  if (procs_fd >= 0)
+    close(procs_fd);
+}
+
+// posix_spawn avoids copying the manager's page tables (glibc implements it with
+// clone(CLONE_VM | CLONE_VFORK)), and reports a failure to exec as an error here rather than as an
+// exit of the child.
+process::ProcessId PosixSpawn(const std::vector<std::string>& args, int cgroup_fd) {
+  std::vector<char*> argv;
+  argv.reserve(args.size() + 1);
+  for (const auto& arg : args)
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  argv.push_back(nullptr);
+
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  on_scope_exit destroy_attributes([&] { posix_spawnattr_destroy(&attributes); });
+  bool placed_in_cgroup{false};
+#ifdef POSIX_SPAWN_SETCGROUP
+  // glibc 2.35 and later can create the process directly in the cgroup via CLONE_INTO_CGROUP.
+  if (cgroup_fd >= 0 && posix_spawnattr_setcgroup_np(&attributes, cgroup_fd) == 0 &&
+      posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETCGROUP) == 0) {
+    placed_in_cgroup = true;
+  }
+#endif
+
+  pid_t pid{0};
+  int result{posix_spawn(&pid, argv[0], nullptr, &attributes, argv.data(), Environment())};
+  if (placed_in_cgroup && (result == ENOSYS || result == EINVAL || result == EOPNOTSUPP)) {
+    // The kernel doesn't support CLONE_INTO_CGROUP (it needs Linux 5.7).
+    placed_in_cgroup = false;
+    posix_spawnattr_setflags(&attributes, 0);
+    result = posix_spawn(&pid, argv[0], nullptr, &attributes, argv.data(), Environment());
+  }
+  if (result != 0) {
+    LOG(kError) << "Failed to spawn " << args[0] << ": " << std::strerror(result);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  }
+  if (cgroup_fd >= 0 && !placed_in_cgroup)
+    MoveToCgroup(pid, cgroup_fd);
+  return static_cast<process::ProcessId>(pid);
+}
+
+void CheckArgs(const std::vector<std::string>& args) {
+  if (args.empty() || args.front().empty()) {
+    LOG(kError) << "No executable to launch.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+}
+
+class PosixSpawnLauncher : public Launcher {
+ public:
+  process::ProcessId Launch(const std::vector<std::string>& args, int cgroup_fd) override {
+    CheckArgs(args);
+    return PosixSpawn(args, cgroup_fd);
+  }
+};
+
+#ifdef MAIDSAFE_LINUX
+
+// A request is the executable path followed by the arguments, each terminated by '\0', optionally
+// accompanied by a cgroup descriptor (as SCM_RIGHTS).  The reply is a SpawnResult.
+const std::size_t kMaxSpawnRequestSize(64 * 1024);
+const std::size_t kMaxSpawnArgs(256);
+
+struct SpawnResult {
+  int32_t error;
+  int64_t pid;
+};
+
+struct SpawnHelper {
+  SpawnHelper() : mutex(), socket_fd(-1), pid(0) {}
+  std::mutex mutex;
+  int socket_fd;
+  pid_t pid;
+};
+
+SpawnHelper& GetSpawnHelper() {
+  static SpawnHelper spawn_helper;
+  return spawn_helper;
+}
+
+// The remaining functions in this namespace run in the helper.  Since the manager may already have
+// other threads when the helper is forked, they only use async-signal-safe calls.
+
+SpawnResult CloneAndExec(char** argv, int cgroup_fd) {
+  SpawnResult result{0, 0};
+  int error_pipe[2];
+  if (pipe2(error_pipe, O_CLOEXEC) != 0) {
+    result.error = errno;
+    return result;
+  }
+  // CLONE_PARENT makes the new process a child of the manager rather than of the helper, so the
+  // manager's SIGCHLD and pidfd handling applies as usual.  The helper's address space is tiny, so
+  // duplicating it is cheap.
+  long pid{syscall(SYS_clone, CLONE_PARENT | SIGCHLD, nullptr, nullptr, nullptr, nullptr)};
+  if (pid == 0) {
+    // Writing "0" moves the writing process, so the vault never runs outside its cgroup.
+    if (cgroup_fd >= 0) {
+      int procs_fd{openat(cgroup_fd, "cgroup.procs", O_WRONLY)};
+      if (procs_fd >= 0) {
+        ssize_t ignored{write(procs_fd, "0", 1)};
+        static_cast<void>(ignored);
+        close(procs_fd);
+      }
+    }
+    execve(argv[0], argv, Environment());
+    int exec_error{errno};
+    ssize_t ignored{write(error_pipe[1], &exec_error, sizeof(exec_error))};
+    static_cast<void>(ignored);
+    _exit(127);
+  }
+  int clone_error{errno};
+  close(error_pipe[1]);
+  if (pid < 0) {
+    result.error = clone_error;
+  } else {
+    // The write end is closed by a successful exec without anything having been written.
+    int exec_error{0};
+    ssize_t size{0};
+    while ((size = read(error_pipe[0], &exec_error, sizeof(exec_error))) < 0 && errno == EINTR) {
+    }
+    if (size == static_cast<ssize_t>(sizeof(exec_error)))
+      result.error = exec_error;
+    else
+      result.pid = pid;
+  }
+  close(error_pipe[0]);
+  return result;
+}
+
+// Returns the size of the request, or -1 if the manager has closed its end.  'cgroup_fd' is set to
+// the received descriptor, or -1.
+ssize_t ReceiveSpawnRequest(int socket_fd, char* request, std::size_t max_size, int& cgroup_fd) {
+  iovec io_vector{request, max_size};
+  union {
+    cmsghdr header;
+    char buffer[CMSG_SPACE(sizeof(int))];
+  } control;
+  msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &io_vector;
+  message.msg_iovlen = 1;
+  message.msg_control = control.buffer;
+  message.msg_controllen = sizeof(control.buffer);
+  cgroup_fd = -1;
+  ssize_t size{0};
+  while ((size = recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR) {
+  }
+  if (size <= 0)
+    return -1;
+  cmsghdr* control_header{CMSG_FIRSTHDR(&message)};
+  if (control_header && control_header->cmsg_level == SOL_SOCKET &&
+      control_header->cmsg_type == SCM_RIGHTS) {
+    std::memcpy(&cgroup_fd, CMSG_DATA(control_header), sizeof(cgroup_fd));
+  }
+  return size;
+}
+
+void ServeSpawnRequests(int socket_fd) {
+  static char request[kMaxSpawnRequestSize];
+  char* argv[kMaxSpawnArgs + 1];
+  for (;;) {
+    int cgroup_fd{-1};
+    ssize_t size{ReceiveSpawnRequest(socket_fd, request, sizeof(request) - 1, cgroup_fd)};
+    if (size < 0)
+      _exit(0);
+    request[size] = '\0';
+    std::size_t argc{0};
+    for (char* arg{request}; arg < request + size && argc < kMaxSpawnArgs;
+         arg += std::strlen(arg) + 1) {
+      argv[argc++] = arg;
+    }
+    argv[argc] = nullptr;
+
+    SpawnResult result{EINVAL, 0};
+    if (argc != 0)
+      result = CloneAndExec(argv, cgroup_fd);
+    if (cgroup_fd >= 0)
+      close(cgroup_fd);
+    while (send(socket_fd, &result, sizeof(result), MSG_NOSIGNAL) < 0 && errno == EINTR) {
+    }
+  }
+}
+
+// Back in the manager.
+
+class SpawnHelperLauncher : public Launcher {
+ public:
+  process::ProcessId Launch(const std::vector<std::string>& args, int cgroup_fd) override {
+    CheckArgs(args);
+    std::string request;
+    for (const auto& arg : args) {
+      request += arg;
+      request += '\0';
+    }
+    if (args.size() > kMaxSpawnArgs || request.size() >= kMaxSpawnRequestSize) {
+      LOG(kError) << "Command line for " << args.front() << " is too long for the spawn helper.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+    }
+
+    SpawnHelper& spawn_helper(GetSpawnHelper());
+    std::lock_guard<std::mutex> lock{spawn_helper.mutex};
+    if (spawn_helper.socket_fd < 0)
+      return PosixSpawn(args, cgroup_fd);
+    SpawnResult result{0, 0};
+    if (!Exchange(spawn_helper.socket_fd, request, cgroup_fd, result)) {
+      LOG(kWarning) << "Spawn helper has failed (" << std::strerror(errno)
+                    << "); launching vaults directly from now on.";
+      close(spawn_helper.socket_fd);
+      spawn_helper.socket_fd = -1;
+      return PosixSpawn(args, cgroup_fd);
+    }
+    if (result.error != 0) {
+      LOG(kError) << "Failed to spawn " << args.front() << ": " << std::strerror(result.error);
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+    }
+    return static_cast<process::ProcessId>(result.pid);
+  }
+
+ private:
+  static bool Exchange(int socket_fd, const std::string& request, int cgroup_fd,
+                       SpawnResult& result) {
+    iovec io_vector{const_cast<char*>(request.data()), request.size()};
+    union {
+      cmsghdr header;
+      char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &io_vector;
+    message.msg_iovlen = 1;
+    if (cgroup_fd >= 0) {
+      message.msg_control = control.buffer;
+      message.msg_controllen = sizeof(control.buffer);
+      cmsghdr* control_header{CMSG_FIRSTHDR(&message)};
+      control_header->cmsg_level = SOL_SOCKET;
+      control_header->cmsg_type = SCM_RIGHTS;
+      control_header->cmsg_len = CMSG_LEN(sizeof(cgroup_fd));
+      std::memcpy(CMSG_DATA(control_header), &cgroup_fd, sizeof(cgroup_fd));
+    }
+    ssize_t size{0};
+    while ((size = sendmsg(socket_fd, &message, MSG_NOSIGNAL)) < 0 && errno == EINTR) {
+    }
+    if (size != static_cast<ssize_t>(request.size()))
+      return false;
+    while ((size = recv(socket_fd, &result, sizeof(result), 0)) < 0 && errno == EINTR) {
+    }
+    if (size == 0)
+      errno = EPIPE;
+    return size == static_cast<ssize_t>(sizeof(result));
+  }
+};
+
+#endif  // MAIDSAFE_LINUX
+
+}  // unnamed namespace
+
+std::unique_ptr<Launcher> MakeLauncher() {
+#ifdef MAIDSAFE_LINUX
+  SpawnHelper& spawn_helper(GetSpawnHelper());
+  std::lock_guard<std::mutex> lock{spawn_helper.mutex};
+  if (spawn_helper.socket_fd >= 0)
+    return std::unique_ptr<Launcher>{new SpawnHelperLauncher};
+#endif
+  return std::unique_ptr<Launcher>{new PosixSpawnLauncher};
+}
+
+bool StartSpawnHelper() {
+#ifdef MAIDSAFE_LINUX
+  SpawnHelper& spawn_helper(GetSpawnHelper());
+  std::lock_guard<std::mutex> lock{spawn_helper.mutex};
+  if (spawn_helper.socket_fd >= 0)
+    return true;
+
+  // SOCK_SEQPACKET preserves message boundaries, and SOCK_CLOEXEC stops vaults inheriting either
+  // end.
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0) {
+    LOG(kError) << "Failed to create spawn helper socket: " << std::strerror(errno);
+    return false;
+  }
+  pid_t manager_pid{getpid()};
+  pid_t pid{fork()};
+  if (pid < 0) {
+    LOG(kError) << "Failed to fork spawn helper: " << std::strerror(errno);
+    close(sockets[0]);
+    close(sockets[1]);
+    return false;
+  }
+  if (pid == 0) {
+    close(sockets[0]);
+    // Don't outlive the manager.
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != manager_pid)
+      _exit(0);
+    ServeSpawnRequests(sockets[1]);
+  }
+  close(sockets[1]);
+  spawn_helper.socket_fd = sockets[0];
+  spawn_helper.pid = pid;
+  LOG(kInfo) << "Started spawn helper with process ID " << pid;
+  return true;
+#else
+  return false;
+#endif
+}
+
+process::ProcessId SpawnHelperProcessId() {
+#ifdef MAIDSAFE_LINUX
+  SpawnHelper& spawn_helper(GetSpawnHelper());
+  std::lock_guard<std::mutex> lock{spawn_helper.mutex};
+  return static_cast<process::ProcessId>(spawn_helper.pid);
+#else
+  return 0;
+#endif
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_WIN32
@@ -0,0 +1,67 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_LAUNCHER_H_
+#define MAIDSAFE_VAULT_MANAGER_LAUNCHER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/process.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+#ifndef MAIDSAFE_WIN32
+
+// Creates vault processes without calling fork(), which copies the caller's page tables and so
+// gets slower, and briefly commits more memory, the more the manager has mapped.
+class Launcher {
+ public:
+  virtual ~Launcher() {}
+  // Runs the executable 'args[0]' with arguments 'args' and the manager's environment, returning
+  // the ID of the new process.  The new process is always a child of the manager.  If 'cgroup_fd'
+  // isn't -1, it's a descriptor for the cgroup directory which the new process is placed in before
+  // it executes.  Throws if the executable can't be run.
+  virtual process::ProcessId Launch(const std::vector<std::string>& args, int cgroup_fd) = 0;
+};
+
+// Returns a launcher which uses the spawn helper if StartSpawnHelper has succeeded, otherwise one
+// which uses posix_spawn directly.  If the helper dies, the returned launcher falls back to
+// posix_spawn.
+std::unique_ptr<Launcher> MakeLauncher();
+
+// Forks a minimal helper process which launches vaults on the manager's behalf, so that launch
+// cost doesn't depend on the size of the manager at all.  This should be called as early as
+// possible in main, while the manager is still small.  The helper uses clone(CLONE_PARENT), so
+// vaults are still children of the manager.  Only supported on Linux; returns false elsewhere or
+// if the helper can't be started.
+bool StartSpawnHelper();
+
+// Returns the spawn helper's process ID, or 0 if it hasn't been started.
+process::ProcessId SpawnHelperProcessId();
+
+#endif
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_LAUNCHER_H_
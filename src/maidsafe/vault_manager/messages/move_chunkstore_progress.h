@@ -0,0 +1,71 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+#ifndef MAIDSAFE_VAULT_MANAGER_MESSAGES_MOVE_CHUNKSTORE_PROGRESS_H_
+#define MAIDSAFE_VAULT_MANAGER_MESSAGES_MOVE_CHUNKSTORE_PROGRESS_H_
+
+#include <cstdint>
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/types.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// VaultManager to Client.  Sent periodically while copying a vault's chunkstore to the directory
+// given in a TakeOwnershipRequest.
+struct MoveChunkstoreProgress {
+  static const MessageTag tag = MessageTag::kMoveChunkstoreProgress;
+
+  MoveChunkstoreProgress() = default;
+  MoveChunkstoreProgress(const MoveChunkstoreProgress&) = delete;
+  MoveChunkstoreProgress(MoveChunkstoreProgress&& other) MAIDSAFE_NOEXCEPT
+      : vault_label(std::move(other.vault_label)),
+        bytes_copied(std::move(other.bytes_copied)),
+        total_bytes(std::move(other.total_bytes)) {}
+  MoveChunkstoreProgress(NonEmptyString vault_label_in, uint64_t bytes_copied_in,
+                         uint64_t total_bytes_in)
+      : vault_label(std::move(vault_label_in)),
+        bytes_copied(bytes_copied_in),
+        total_bytes(total_bytes_in) {}
+  ~MoveChunkstoreProgress() = default;
+  MoveChunkstoreProgress& operator=(const MoveChunkstoreProgress&) = delete;
+  MoveChunkstoreProgress& operator=(MoveChunkstoreProgress&& other) MAIDSAFE_NOEXCEPT {
+    vault_label = std::move(other.vault_label);
+    bytes_copied = std::move(other.bytes_copied);
+    total_bytes = std::move(other.total_bytes);
+    return *this;
+  };
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(vault_label, bytes_copied, total_bytes);
+  }
+
+  NonEmptyString vault_label;
+  uint64_t bytes_copied;
+  uint64_t total_bytes;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_MESSAGES_MOVE_CHUNKSTORE_PROGRESS_H_
@@ -0,0 +1,61 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+#ifndef MAIDSAFE_VAULT_MANAGER_MESSAGES_MOVE_CHUNKSTORE_REQUEST_H_
+#define MAIDSAFE_VAULT_MANAGER_MESSAGES_MOVE_CHUNKSTORE_REQUEST_H_
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/config.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// VaultManager to Vault.  Sent once the VaultManager has copied the vault's chunkstore to
+// 'new_vault_dir'.  The vault should copy across anything changed since, then switch to it.
+struct MoveChunkstoreRequest {
+  static const MessageTag tag = MessageTag::kMoveChunkstoreRequest;
+
+  MoveChunkstoreRequest() = default;
+  MoveChunkstoreRequest(const MoveChunkstoreRequest&) = delete;
+  MoveChunkstoreRequest(MoveChunkstoreRequest&& other) MAIDSAFE_NOEXCEPT
+      : new_vault_dir(std::move(other.new_vault_dir)) {}
+  explicit MoveChunkstoreRequest(boost::filesystem::path new_vault_dir_in)
+      : new_vault_dir(std::move(new_vault_dir_in)) {}
+  ~MoveChunkstoreRequest() = default;
+  MoveChunkstoreRequest& operator=(const MoveChunkstoreRequest&) = delete;
+  MoveChunkstoreRequest& operator=(MoveChunkstoreRequest&& other) MAIDSAFE_NOEXCEPT {
+    new_vault_dir = std::move(other.new_vault_dir);
+    return *this;
+  };
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(new_vault_dir);
+  }
+
+  boost::filesystem::path new_vault_dir;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_MESSAGES_MOVE_CHUNKSTORE_REQUEST_H_
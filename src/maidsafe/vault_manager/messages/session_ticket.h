@@ -0,0 +1,92 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+#ifndef MAIDSAFE_VAULT_MANAGER_MESSAGES_SESSION_TICKET_H_
+#define MAIDSAFE_VAULT_MANAGER_MESSAGES_SESSION_TICKET_H_
+
+#include <cstdint>
+#include <string>
+
+#include "boost/optional.hpp"
+#include "cereal/types/boost_optional.hpp"
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// VaultManager to Client.  Sent once the client's connection has been validated.  The client can
+// present 'ticket' on a later connection (see ResumeSessionRequest) within 'lifetime' seconds.
+// The ticket's secret is encrypted under the connection's session key.  If the connection was
+// validated by signing a challenge, that session key is sent along with it, encrypted to the
+// client's Maid; if it was validated with a previous ticket, the client derives the key itself.
+struct SessionTicket {
+  static const MessageTag tag = MessageTag::kSessionTicket;
+
+  SessionTicket() = default;
+  SessionTicket(const SessionTicket&) = delete;
+  SessionTicket(SessionTicket&& other) MAIDSAFE_NOEXCEPT
+      : ticket(std::move(other.ticket)),
+        secret_iv(std::move(other.secret_iv)),
+        encrypted_secret(std::move(other.encrypted_secret)),
+        encrypted_session_key(std::move(other.encrypted_session_key)),
+        lifetime(std::move(other.lifetime)) {}
+  SessionTicket(std::string ticket_in, const std::string& secret,
+                const crypto::AES256Key& session_key, uint32_t lifetime_in)
+      : ticket(std::move(ticket_in)),
+        secret_iv(RandomString(crypto::AES256_IVSize)),
+        encrypted_secret(crypto::SymmEncrypt(crypto::PlainText{secret}, session_key, secret_iv)),
+        encrypted_session_key(),
+        lifetime(lifetime_in) {}
+  ~SessionTicket() = default;
+  SessionTicket& operator=(const SessionTicket&) = delete;
+  SessionTicket& operator=(SessionTicket&& other) MAIDSAFE_NOEXCEPT {
+    ticket = std::move(other.ticket);
+    secret_iv = std::move(other.secret_iv);
+    encrypted_secret = std::move(other.encrypted_secret);
+    encrypted_session_key = std::move(other.encrypted_session_key);
+    lifetime = std::move(other.lifetime);
+    return *this;
+  };
+
+  std::string Secret(const crypto::AES256Key& session_key) const {
+    return crypto::SymmDecrypt(encrypted_secret, session_key, secret_iv).string();
+  }
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(ticket, secret_iv, encrypted_secret, encrypted_session_key, lifetime);
+  }
+
+  std::string ticket;
+  crypto::AES256InitialisationVector secret_iv;
+  crypto::CipherText encrypted_secret;
+  boost::optional<asymm::CipherText> encrypted_session_key;
+  uint32_t lifetime;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_MESSAGES_SESSION_TICKET_H_
@@ -0,0 +1,82 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_MESSAGES_SET_VAULT_RESOURCE_LIMITS_REQUEST_H_
+#define MAIDSAFE_VAULT_MANAGER_MESSAGES_SET_VAULT_RESOURCE_LIMITS_REQUEST_H_
+
+#include "boost/optional.hpp"
+#include "cereal/types/boost_optional.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/vector.hpp"
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/types.h"
+
+#include "maidsafe/vault_manager/config.h"
+#include "maidsafe/vault_manager/vault_resource_limits.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Also used by SetVaultResourceLimitsResponse.
+template <typename Archive>
+void serialize(Archive& archive, VaultResourceLimits& limits) {
+  archive(limits.cpu_weight, limits.memory_high, limits.memory_max, limits.io_weight,
+          limits.io_max);
+}
+
+// Client to VaultManager
+struct SetVaultResourceLimitsRequest {
+  static const MessageTag tag = MessageTag::kSetVaultResourceLimitsRequest;
+
+  SetVaultResourceLimitsRequest() = default;
+
+  SetVaultResourceLimitsRequest(const SetVaultResourceLimitsRequest&) = delete;
+
+  SetVaultResourceLimitsRequest(SetVaultResourceLimitsRequest&& other) MAIDSAFE_NOEXCEPT
+      : vault_label(std::move(other.vault_label)), limits(std::move(other.limits)) {}
+
+  SetVaultResourceLimitsRequest(NonEmptyString vault_label_in, VaultResourceLimits limits_in)
+      : vault_label(std::move(vault_label_in)), limits(std::move(limits_in)) {}
+
+  ~SetVaultResourceLimitsRequest() = default;
+
+  SetVaultResourceLimitsRequest& operator=(const SetVaultResourceLimitsRequest&) = delete;
+
+  SetVaultResourceLimitsRequest& operator=(SetVaultResourceLimitsRequest&& other)
+      MAIDSAFE_NOEXCEPT {
+    vault_label = std::move(other.vault_label);
+    limits = std::move(other.limits);
+    return *this;
+  };
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(vault_label, limits);
+  }
+
+  NonEmptyString vault_label;
+  VaultResourceLimits limits;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_MESSAGES_SET_VAULT_RESOURCE_LIMITS_REQUEST_H_
@@ -0,0 +1,89 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_MESSAGES_SET_VAULT_RESOURCE_LIMITS_RESPONSE_H_
+#define MAIDSAFE_VAULT_MANAGER_MESSAGES_SET_VAULT_RESOURCE_LIMITS_RESPONSE_H_
+
+#include "boost/optional.hpp"
+#include "cereal/types/boost_optional.hpp"
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/types.h"
+
+#include "maidsafe/vault_manager/config.h"
+#include "maidsafe/vault_manager/vault_resource_limits.h"
+#include "maidsafe/vault_manager/messages/set_vault_resource_limits_request.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// VaultManager to Client.  Holds the limits now in force, or the reason they couldn't be applied.
+struct SetVaultResourceLimitsResponse {
+  static const MessageTag tag = MessageTag::kSetVaultResourceLimitsResponse;
+
+  SetVaultResourceLimitsResponse() = default;
+
+  SetVaultResourceLimitsResponse(const SetVaultResourceLimitsResponse&) = delete;
+
+  SetVaultResourceLimitsResponse(SetVaultResourceLimitsResponse&& other) MAIDSAFE_NOEXCEPT
+      : vault_label(std::move(other.vault_label)),
+        limits(std::move(other.limits)),
+        error(std::move(other.error)) {}
+
+  SetVaultResourceLimitsResponse(NonEmptyString vault_label_in, VaultResourceLimits limits_in)
+      : vault_label(std::move(vault_label_in)), limits(std::move(limits_in)), error() {}
+
+  SetVaultResourceLimitsResponse(NonEmptyString vault_label_in, maidsafe_error error_in)
+      : vault_label(std::move(vault_label_in)), limits(), error(std::move(error_in)) {}
+
+  ~SetVaultResourceLimitsResponse() = default;
+
+  SetVaultResourceLimitsResponse& operator=(const SetVaultResourceLimitsResponse&) = delete;
+
+  SetVaultResourceLimitsResponse& operator=(SetVaultResourceLimitsResponse&& other)
+      MAIDSAFE_NOEXCEPT {
+    vault_label = std::move(other.vault_label);
+    limits = std::move(other.limits);
+    error = std::move(other.error);
+    return *this;
+  };
+
+  template <typename Archive>
+  void load(Archive& archive) {
+    archive(vault_label, limits, error);
+    if ((limits && error) || (!limits && !error))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+
+  template <typename Archive>
+  void save(Archive& archive) const {
+    archive(vault_label, limits, error);
+  }
+
+  NonEmptyString vault_label;
+  boost::optional<VaultResourceLimits> limits;
+  boost::optional<maidsafe_error> error;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_MESSAGES_SET_VAULT_RESOURCE_LIMITS_RESPONSE_H_
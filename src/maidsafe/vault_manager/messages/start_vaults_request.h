@@ -0,0 +1,73 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_MANAGER_MESSAGES_START_VAULTS_REQUEST_H_
+#define MAIDSAFE_VAULT_MANAGER_MESSAGES_START_VAULTS_REQUEST_H_
+
+#include <vector>
+
+#include "cereal/types/vector.hpp"
+
+#include "maidsafe/common/config.h"
+
+#include "maidsafe/vault_manager/config.h"
+#include "maidsafe/vault_manager/messages/start_vault_request.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Client to VaultManager.  Each vault is answered by its own VaultRunningResponse, just as if it
+// had been requested by a StartVaultRequest, but the vaults are all recorded in the config file
+// together.
+struct StartVaultsRequest {
+  static const MessageTag tag = MessageTag::kStartVaultsRequest;
+
+  StartVaultsRequest() = default;
+
+  StartVaultsRequest(const StartVaultsRequest&) = delete;
+
+  StartVaultsRequest(StartVaultsRequest&& other) MAIDSAFE_NOEXCEPT
+      : vaults(std::move(other.vaults)) {}
+
+  explicit StartVaultsRequest(std::vector<StartVaultRequest> vaults_in)
+      : vaults(std::move(vaults_in)) {}
+
+  ~StartVaultsRequest() = default;
+
+  StartVaultsRequest& operator=(const StartVaultsRequest&) = delete;
+
+  StartVaultsRequest& operator=(StartVaultsRequest&& other) MAIDSAFE_NOEXCEPT {
+    vaults = std::move(other.vaults);
+    return *this;
+  };
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(vaults);
+  }
+
+  std::vector<StartVaultRequest> vaults;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_MESSAGES_START_VAULTS_REQUEST_H_
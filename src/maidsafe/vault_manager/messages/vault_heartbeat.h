@@ -0,0 +1,64 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_MESSAGES_VAULT_HEARTBEAT_H_
+#define MAIDSAFE_VAULT_MANAGER_MESSAGES_VAULT_HEARTBEAT_H_
+
+#include <cstdint>
+
+#include "maidsafe/common/config.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Vault to VaultManager.  'sequence' increases by one with each heartbeat; 'progress' is whatever
+// counter the vault reports via VaultInterface::SetProgressProbe (zero if it hasn't set one).
+struct VaultHeartbeat {
+  static const MessageTag tag = MessageTag::kVaultHeartbeat;
+
+  VaultHeartbeat() = default;
+  VaultHeartbeat(const VaultHeartbeat&) = delete;
+  VaultHeartbeat(VaultHeartbeat&& other) MAIDSAFE_NOEXCEPT : sequence(std::move(other.sequence)),
+                                                             progress(std::move(other.progress)) {}
+  VaultHeartbeat(uint64_t sequence_in, uint64_t progress_in)
+      : sequence(sequence_in), progress(progress_in) {}
+  ~VaultHeartbeat() = default;
+  VaultHeartbeat& operator=(const VaultHeartbeat&) = delete;
+  VaultHeartbeat& operator=(VaultHeartbeat&& other) MAIDSAFE_NOEXCEPT {
+    sequence = std::move(other.sequence);
+    progress = std::move(other.progress);
+    return *this;
+  };
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(sequence, progress);
+  }
+
+  uint64_t sequence;
+  uint64_t progress;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_MESSAGES_VAULT_HEARTBEAT_H_
@@ -0,0 +1,119 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_MESSAGES_VAULT_RESOURCE_USAGE_RESPONSE_H_
+#define MAIDSAFE_VAULT_MANAGER_MESSAGES_VAULT_RESOURCE_USAGE_RESPONSE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "boost/optional.hpp"
+#include "cereal/types/boost_optional.hpp"
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/types.h"
+
+#include "maidsafe/vault_manager/config.h"
+#include "maidsafe/vault_manager/vault_resource_sample.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// VaultManager to Client.  Holds the vault's recent resource usage samples, oldest first.
+struct VaultResourceUsageResponse {
+  static const MessageTag tag = MessageTag::kVaultResourceUsageResponse;
+
+  VaultResourceUsageResponse() = default;
+
+  VaultResourceUsageResponse(const VaultResourceUsageResponse&) = delete;
+
+  VaultResourceUsageResponse(VaultResourceUsageResponse&& other) MAIDSAFE_NOEXCEPT
+      : vault_label(std::move(other.vault_label)),
+        samples(std::move(other.samples)),
+        error(std::move(other.error)) {}
+
+  VaultResourceUsageResponse(NonEmptyString vault_label_in,
+                             std::vector<VaultResourceSample> samples_in)
+      : vault_label(std::move(vault_label_in)), samples(std::move(samples_in)), error() {}
+
+  VaultResourceUsageResponse(NonEmptyString vault_label_in, maidsafe_error error_in)
+      : vault_label(std::move(vault_label_in)), samples(), error(std::move(error_in)) {}
+
+  ~VaultResourceUsageResponse() = default;
+
+  VaultResourceUsageResponse& operator=(const VaultResourceUsageResponse&) = delete;
+
+  VaultResourceUsageResponse& operator=(VaultResourceUsageResponse&& other) MAIDSAFE_NOEXCEPT {
+    vault_label = std::move(other.vault_label);
+    samples = std::move(other.samples);
+    error = std::move(other.error);
+    return *this;
+  };
+
+  template <typename Archive>
+  void load(Archive& archive) {
+    bool has_samples(false);
+    archive(vault_label, has_samples);
+    if (has_samples) {
+      uint32_t count(0);
+      archive(count);
+      if (count > kResourceSampleCount)
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+      std::vector<VaultResourceSample> loaded(count);
+      for (auto& sample : loaded) {
+        int64_t time(0), cpu_time(0);
+        archive(time, sample.process_id, cpu_time, sample.resident_bytes, sample.read_bytes,
+                sample.write_bytes, sample.open_files);
+        sample.time = std::chrono::system_clock::time_point(std::chrono::milliseconds(time));
+        sample.cpu_time = std::chrono::milliseconds(cpu_time);
+      }
+      samples = std::move(loaded);
+    }
+    archive(error);
+    if ((samples && error) || (!samples && !error))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+
+  template <typename Archive>
+  void save(Archive& archive) const {
+    archive(vault_label, static_cast<bool>(samples));
+    if (samples) {
+      archive(static_cast<uint32_t>(samples->size()));
+      for (const auto& sample : *samples) {
+        archive(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    sample.time.time_since_epoch()).count()),
+                sample.process_id, static_cast<int64_t>(sample.cpu_time.count()),
+                sample.resident_bytes, sample.read_bytes, sample.write_bytes, sample.open_files);
+      }
+    }
+    archive(error);
+  }
+
+  NonEmptyString vault_label;
+  boost::optional<std::vector<VaultResourceSample>> samples;
+  boost::optional<maidsafe_error> error;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_MESSAGES_VAULT_RESOURCE_USAGE_RESPONSE_H_
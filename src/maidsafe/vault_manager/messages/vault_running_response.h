@@ -42,56 +42,52 @@ namespace vault_manager {
 struct VaultRunningResponse {
   static const MessageTag tag = MessageTag::kVaultRunningResponse;
 
+  // The vault's keys, encrypted under the client connection's session key (see SessionTickets),
+  // each with its own random IV.
   struct VaultKeys {
     VaultKeys() = default;
 
     VaultKeys(const VaultKeys&) = default;
 
     VaultKeys(VaultKeys&& other) MAIDSAFE_NOEXCEPT
-        : symm_key(std::move(other.symm_key)),
-          symm_iv(std::move(other.symm_iv)),
-          pmid_and_signer(std::move(other.pmid_and_signer)) {}
-
-    explicit VaultKeys(passport::PmidAndSigner pmid_and_signer_in)
-        : symm_key(RandomString(crypto::AES256_KeySize)),
-          symm_iv(RandomString(crypto::AES256_IVSize)),
-          pmid_and_signer(
-              std::make_shared<passport::PmidAndSigner>(std::move(pmid_and_signer_in))) {}
+        : pmid_iv(std::move(other.pmid_iv)),
+          anpmid_iv(std::move(other.anpmid_iv)),
+          encrypted_pmid(std::move(other.encrypted_pmid)),
+          encrypted_anpmid(std::move(other.encrypted_anpmid)) {}
+
+    VaultKeys(const passport::PmidAndSigner& pmid_and_signer, const crypto::AES256Key& session_key)
+        : pmid_iv(RandomString(crypto::AES256_IVSize)),
+          anpmid_iv(RandomString(crypto::AES256_IVSize)),
+          encrypted_pmid(passport::EncryptPmid(pmid_and_signer.first, session_key, pmid_iv)),
+          encrypted_anpmid(
+              passport::EncryptAnpmid(pmid_and_signer.second, session_key, anpmid_iv)) {}
 
     ~VaultKeys() = default;
 
     VaultKeys& operator=(const VaultKeys&) = default;
 
     VaultKeys& operator=(VaultKeys&& other) MAIDSAFE_NOEXCEPT {
-      symm_key = std::move(other.symm_key);
-      symm_iv = std::move(other.symm_iv);
-      pmid_and_signer = std::move(other.pmid_and_signer);
+      pmid_iv = std::move(other.pmid_iv);
+      anpmid_iv = std::move(other.anpmid_iv);
+      encrypted_pmid = std::move(other.encrypted_pmid);
+      encrypted_anpmid = std::move(other.encrypted_anpmid);
       return *this;
     };
 
-    template <typename Archive>
-    void load(Archive& archive) {
-      crypto::CipherText encrypted_anpmid, encrypted_pmid;
-      archive(symm_key, symm_iv, encrypted_anpmid, encrypted_pmid);
-      pmid_and_signer = std::make_shared<passport::PmidAndSigner>(
-          std::make_pair(passport::DecryptPmid(encrypted_pmid, symm_key, symm_iv),
-                         passport::DecryptAnpmid(encrypted_anpmid, symm_key, symm_iv)));
+    passport::PmidAndSigner Decrypt(const crypto::AES256Key& session_key) const {
+      return std::make_pair(passport::DecryptPmid(encrypted_pmid, session_key, pmid_iv),
+                            passport::DecryptAnpmid(encrypted_anpmid, session_key, anpmid_iv));
     }
 
     template <typename Archive>
-    void save(Archive& archive) const {
-      archive(symm_key, symm_iv,
-              passport::EncryptAnpmid(pmid_and_signer->second, symm_key, symm_iv),
-              passport::EncryptPmid(pmid_and_signer->first, symm_key, symm_iv));
+    void serialize(Archive& archive) {
+      archive(pmid_iv, anpmid_iv, encrypted_pmid, encrypted_anpmid);
     }
 
-    crypto::AES256Key symm_key;
-    crypto::AES256InitialisationVector symm_iv;
-    std::shared_ptr<passport::PmidAndSigner> pmid_and_signer;
+    crypto::AES256InitialisationVector pmid_iv, anpmid_iv;
+    crypto::CipherText encrypted_pmid, encrypted_anpmid;
   };
 
-
-
   VaultRunningResponse() = default;
 
   VaultRunningResponse(const VaultRunningResponse&) = delete;
@@ -103,8 +99,11 @@ struct VaultRunningResponse {
     ValidateOptions();
   }
 
-  VaultRunningResponse(NonEmptyString vault_label_in, passport::PmidAndSigner pmid_and_signer)
-      : vault_label(std::move(vault_label_in)), vault_keys(std::move(pmid_and_signer)), error() {}
+  VaultRunningResponse(NonEmptyString vault_label_in, const passport::PmidAndSigner& pmid_and_signer,
+                       const crypto::AES256Key& session_key)
+      : vault_label(std::move(vault_label_in)),
+        vault_keys(VaultKeys(pmid_and_signer, session_key)),
+        error() {}
 
   VaultRunningResponse(NonEmptyString vault_label_in, maidsafe_error error_in)
       : vault_label(std::move(vault_label_in)), vault_keys(), error(std::move(error_in)) {}
@@ -0,0 +1,106 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_MESSAGES_VAULT_STATUS_RESPONSE_H_
+#define MAIDSAFE_VAULT_MANAGER_MESSAGES_VAULT_STATUS_RESPONSE_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include "boost/optional.hpp"
+#include "cereal/types/boost_optional.hpp"
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/types.h"
+
+#include "maidsafe/vault_manager/config.h"
+#include "maidsafe/vault_manager/vault_status.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// VaultManager to Client
+struct VaultStatusResponse {
+  static const MessageTag tag = MessageTag::kVaultStatusResponse;
+
+  VaultStatusResponse() = default;
+
+  VaultStatusResponse(const VaultStatusResponse&) = delete;
+
+  VaultStatusResponse(VaultStatusResponse&& other) MAIDSAFE_NOEXCEPT
+      : vault_label(std::move(other.vault_label)),
+        status(std::move(other.status)),
+        error(std::move(other.error)) {}
+
+  VaultStatusResponse(NonEmptyString vault_label_in, VaultStatus status_in)
+      : vault_label(std::move(vault_label_in)), status(std::move(status_in)), error() {}
+
+  VaultStatusResponse(NonEmptyString vault_label_in, maidsafe_error error_in)
+      : vault_label(std::move(vault_label_in)), status(), error(std::move(error_in)) {}
+
+  ~VaultStatusResponse() = default;
+
+  VaultStatusResponse& operator=(const VaultStatusResponse&) = delete;
+
+  VaultStatusResponse& operator=(VaultStatusResponse&& other) MAIDSAFE_NOEXCEPT {
+    vault_label = std::move(other.vault_label);
+    status = std::move(other.status);
+    error = std::move(other.error);
+    return *this;
+  };
+
+  template <typename Archive>
+  void load(Archive& archive) {
+    bool has_status(false);
+    archive(vault_label, has_status);
+    if (has_status) {
+      VaultStatus vault_status;
+      int32_t recent_failures(0);
+      int64_t time_until_restart(0);
+      archive(vault_status.state, recent_failures, time_until_restart);
+      vault_status.recent_failures = recent_failures;
+      vault_status.time_until_restart = std::chrono::milliseconds(time_until_restart);
+      status = vault_status;
+    }
+    archive(error);
+    if ((status && error) || (!status && !error))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+
+  template <typename Archive>
+  void save(Archive& archive) const {
+    archive(vault_label, static_cast<bool>(status));
+    if (status) {
+      archive(status->state, static_cast<int32_t>(status->recent_failures),
+              static_cast<int64_t>(status->time_until_restart.count()));
+    }
+    archive(error);
+  }
+
+  NonEmptyString vault_label;
+  boost::optional<VaultStatus> status;
+  boost::optional<maidsafe_error> error;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_MESSAGES_VAULT_STATUS_RESPONSE_H_
@@ -0,0 +1,190 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/placement_engine.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#ifdef MAIDSAFE_LINUX
+#include <sched.h>
+#include <sys/types.h>
+#endif
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/log.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+// Parses a kernel CPU list, e.g. "0-3,8-11".
+std::vector<unsigned> ParseCpuList(const std::string& cpu_list) {
+  std::vector<unsigned> cpus;
+  std::istringstream ranges{cpu_list};
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    unsigned first(0), last(0);
+    char dash('\0');
+    std::istringstream range_stream{range};
+    if (!(range_stream >> first))
+      continue;
+    last = first;
+    if (range_stream >> dash && dash == '-')
+      range_stream >> last;
+    for (unsigned cpu(first); cpu <= last; ++cpu)
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+std::string ReadLine(const fs::path& path) {
+  std::ifstream file(path.string());
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+std::vector<PlacementEngine::Node> ReadTopology() {
+  std::vector<PlacementEngine::Node> nodes;
+  const fs::path node_root("/sys/devices/system/node");
+  boost::system::error_code ec;
+  for (fs::directory_iterator itr(node_root, ec); !ec && itr != fs::directory_iterator();
+       itr.increment(ec)) {
+    std::string name{itr->path().filename().string()};
+    if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+        !std::all_of(std::begin(name) + 4, std::end(name),
+                     [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; })) {
+      continue;
+    }
+    PlacementEngine::Node node{static_cast<int32_t>(std::stoi(name.substr(4))),
+                               ParseCpuList(ReadLine(itr->path() / "cpulist")), 0};
+    // Memory-only nodes can't run vaults.
+    if (!node.cpus.empty())
+      nodes.push_back(std::move(node));
+  }
+
+  if (nodes.empty()) {
+    PlacementEngine::Node node{0, ParseCpuList(ReadLine("/sys/devices/system/cpu/online")), 0};
+    if (node.cpus.empty()) {
+      for (unsigned cpu(0); cpu < std::max(1U, std::thread::hardware_concurrency()); ++cpu)
+        node.cpus.push_back(cpu);
+    }
+    nodes.push_back(std::move(node));
+  }
+  std::sort(std::begin(nodes), std::end(nodes),
+            [](const PlacementEngine::Node& lhs, const PlacementEngine::Node& rhs) {
+              return lhs.id < rhs.id;
+            });
+  return nodes;
+}
+
+}  // unnamed namespace
+
+PlacementEngine::PlacementEngine() : PlacementEngine(ReadTopology()) {
+  LOG(kInfo) << "Placing vaults across " << nodes_.size() << " NUMA node(s).";
+}
+
+PlacementEngine::PlacementEngine(std::vector<Node> nodes) : nodes_(std::move(nodes)) {}
+
+int32_t PlacementEngine::Place(int32_t preferred_node) {
+  auto itr(Find(preferred_node));
+  if (itr == std::end(nodes_)) {
+    // Compare vault_count / cpus.size() across nodes without dividing.
+    itr = std::min_element(std::begin(nodes_), std::end(nodes_),
+                           [](const Node& lhs, const Node& rhs) {
+                             return lhs.vault_count * rhs.cpus.size() <
+                                    rhs.vault_count * lhs.cpus.size();
+                           });
+  }
+  ++itr->vault_count;
+  return itr->id;
+}
+
+void PlacementEngine::Release(int32_t node) {
+  auto itr(Find(node));
+  if (itr != std::end(nodes_) && itr->vault_count != 0)
+    --itr->vault_count;
+}
+
+const PlacementEngine::Node* PlacementEngine::NodeToPin(int32_t node) const {
+  if (nodes_.size() < 2U)
+    return nullptr;
+  auto itr(std::find_if(std::begin(nodes_), std::end(nodes_),
+                        [node](const Node& candidate) { return candidate.id == node; }));
+  return itr == std::end(nodes_) ? nullptr : &*itr;
+}
+
+void PlacementEngine::SetAffinity(process::ProcessId process_id, int32_t node) const {
+#ifdef MAIDSAFE_LINUX
+  const Node* node_to_pin{NodeToPin(node)};
+  if (!node_to_pin)
+    return;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (unsigned cpu : node_to_pin->cpus) {
+    if (cpu < CPU_SETSIZE)
+      CPU_SET(cpu, &cpu_set);
+  }
+  if (sched_setaffinity(static_cast<pid_t>(process_id), sizeof(cpu_set), &cpu_set) != 0) {
+    LOG(kWarning) << "Failed to pin process " << process_id << " to NUMA node " << node << ": "
+                  << std::strerror(errno);
+  }
+#else
+  static_cast<void>(process_id);
+  static_cast<void>(node);
+#endif
+}
+
+std::vector<PlacementEngine::Node>::iterator PlacementEngine::Find(int32_t node) {
+  return std::find_if(std::begin(nodes_), std::end(nodes_),
+                      [node](const Node& candidate) { return candidate.id == node; });
+}
+
+std::string ToCpuList(const std::vector<unsigned>& cpus) {
+  std::string cpu_list;
+  for (auto itr(std::begin(cpus)); itr != std::end(cpus);) {
+    // Collapse each run of consecutive CPUs into a range.
+    auto run_end(std::next(itr));
+    while (run_end != std::end(cpus) && *run_end == *std::prev(run_end) + 1)
+      ++run_end;
+    if (!cpu_list.empty())
+      cpu_list += ',';
+    cpu_list += std::to_string(*itr);
+    if (std::prev(run_end) != itr)
+      cpu_list += '-' + std::to_string(*std::prev(run_end));
+    itr = run_end;
+  }
+  return cpu_list;
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -0,0 +1,72 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_PLACEMENT_ENGINE_H_
+#define MAIDSAFE_VAULT_MANAGER_PLACEMENT_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/process.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Spreads vaults across the host's NUMA nodes, pinning each to the CPUs (and, where cgroups allow,
+// the memory) of a single node so that its working set stays local.  The topology is read from
+// sysfs; where that's unavailable there's a single node holding every CPU, and nothing is pinned.
+// The class is not thread-safe.
+class PlacementEngine {
+ public:
+  struct Node {
+    int32_t id;
+    std::vector<unsigned> cpus;
+    std::size_t vault_count;
+  };
+
+  PlacementEngine();
+  // Uses the given topology rather than the host's.
+  explicit PlacementEngine(std::vector<Node> nodes);
+
+  // Returns 'preferred_node' if it's a node of this host (so that a vault lands where it was before
+  // a restart), otherwise the node with the fewest vaults per CPU.  The vault is counted against
+  // the returned node until Release is called.
+  int32_t Place(int32_t preferred_node);
+  void Release(int32_t node);
+  // Returns null if vaults on 'node' shouldn't be pinned, i.e. if the host has a single node.
+  const Node* NodeToPin(int32_t node) const;
+  // Restricts the process to the node's CPUs.  Only implemented on Linux.
+  void SetAffinity(process::ProcessId process_id, int32_t node) const;
+
+ private:
+  std::vector<Node>::iterator Find(int32_t node);
+
+  std::vector<Node> nodes_;
+};
+
+// Formats ascending 'cpus' as a kernel CPU list, e.g. "0-3,8-11".
+std::string ToCpuList(const std::vector<unsigned>& cpus);
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_PLACEMENT_ENGINE_H_
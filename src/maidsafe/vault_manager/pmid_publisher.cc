@@ -0,0 +1,196 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/pmid_publisher.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/nfs/client/maid_client.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+typedef decltype(std::declval<nfs_client::MaidClient&>().Put(
+    std::declval<const passport::PublicPmid&>())) PmidPutFuture;
+typedef decltype(std::declval<nfs_client::MaidClient&>().Put(
+    std::declval<const passport::PublicAnpmid&>())) AnpmidPutFuture;
+
+const std::chrono::milliseconds kInitialBackoff(500);
+const std::chrono::milliseconds kMaxBackoff(60000);
+
+// Doubles per attempt up to kMaxBackoff, with up to 50% added jitter so that failed requests don't
+// all retry at the same instant.
+std::chrono::milliseconds Backoff(int attempts) {
+  std::chrono::milliseconds backoff{kInitialBackoff * (1 << std::min(attempts - 1, 7))};
+  backoff = std::min(backoff, kMaxBackoff);
+  return backoff + std::chrono::milliseconds{RandomUint32() % (backoff.count() / 2 + 1)};
+}
+
+void Invoke(const PmidPublisher::OnPublished& on_published, maidsafe_error error) {
+  try {
+    on_published(std::move(error));
+  } catch (const std::exception& e) {
+    LOG(kError) << "Error executing on_published functor: " << boost::diagnostic_information(e);
+  }
+}
+
+}  // unnamed namespace
+
+PmidPublisher::PmidPublisher()
+    : mutex_(), condition_(), pending_(), stop_(false), client_(), thread_() {
+  thread_ = std::thread([this] { Run(); });
+}
+
+PmidPublisher::~PmidPublisher() { Stop(); }
+
+void PmidPublisher::Publish(std::shared_ptr<passport::PmidAndSigner> pmid_and_signer,
+                            bool retry_until_stored, OnPublished on_published) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (!stop_) {
+      Request request{std::move(pmid_and_signer), retry_until_stored, on_published, 0,
+                      std::chrono::steady_clock::now()};
+      pending_.push_back(std::move(request));
+      condition_.notify_one();
+      return;
+    }
+  }
+  LOG(kWarning) << "PmidPublisher has been stopped.";
+  Invoke(on_published, MakeError(CommonErrors::unable_to_handle_request));
+}
+
+void PmidPublisher::Stop() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  condition_.notify_one();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void PmidPublisher::Run() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (!stop_) {
+    if (pending_.empty()) {
+      condition_.wait(lock);
+      continue;
+    }
+
+    auto now(std::chrono::steady_clock::now());
+    auto next_due(std::min_element(std::begin(pending_), std::end(pending_),
+                                   [](const Request& lhs, const Request& rhs) {
+                                     return lhs.due < rhs.due;
+                                   })->due);
+    if (next_due > now) {
+      condition_.wait_until(lock, next_due);
+      continue;
+    }
+
+    auto not_due(std::partition(std::begin(pending_), std::end(pending_),
+                                [now](const Request& request) { return request.due > now; }));
+    std::vector<Request> batch{std::make_move_iterator(not_due),
+                               std::make_move_iterator(std::end(pending_))};
+    pending_.erase(not_due, std::end(pending_));
+
+    lock.unlock();
+    PublishBatch(std::move(batch));
+    lock.lock();
+  }
+  lock.unlock();
+
+  if (client_) {
+    client_->Stop();
+    client_.reset();
+  }
+}
+
+void PmidPublisher::PublishBatch(std::vector<Request> batch) {
+  std::vector<std::pair<PmidPutFuture, AnpmidPutFuture>> puts;
+  try {
+    if (!client_) {
+      client_ = nfs_client::MaidClient::MakeShared(
+          passport::MaidAndSigner{passport::CreateMaidAndSigner()});
+      LOG(kInfo) << "PmidPublisher connected to network.";
+    }
+    for (const auto& request : batch) {
+      puts.emplace_back(client_->Put(passport::PublicPmid{request.pmid_and_signer->first}),
+                        client_->Put(passport::PublicAnpmid{request.pmid_and_signer->second}));
+    }
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to send PmidAndSigner puts: " << boost::diagnostic_information(e);
+    const maidsafe_error* error(dynamic_cast<const maidsafe_error*>(&e));
+    for (auto& request : batch)
+      Retry(std::move(request), error ? *error : MakeError(CommonErrors::unknown));
+    if (client_) {
+      client_->Stop();
+      client_.reset();
+    }
+    return;
+  }
+
+  bool any_stored{false};
+  for (std::size_t i(0); i < batch.size(); ++i) {
+    try {
+      puts[i].first.get();
+      puts[i].second.get();
+      any_stored = true;
+      LOG(kSuccess) << "Put PmidAndSigner "
+                    << DebugId(batch[i].pmid_and_signer->first.name().value);
+      Invoke(batch[i].on_published, MakeError(CommonErrors::success));
+    } catch (const maidsafe_error& e) {
+      LOG(kError) << "Failed to put PmidAndSigner: " << boost::diagnostic_information(e);
+      Retry(std::move(batch[i]), e);
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to put PmidAndSigner: " << boost::diagnostic_information(e);
+      Retry(std::move(batch[i]), MakeError(CommonErrors::unknown));
+    }
+  }
+
+  if (!any_stored) {
+    client_->Stop();
+    client_.reset();
+  }
+}
+
+void PmidPublisher::Retry(Request request, const maidsafe_error& error) {
+  ++request.attempts;
+  if (!request.retry_until_stored && request.attempts >= kMaxPmidPublishAttempts) {
+    Invoke(request.on_published, error);
+    return;
+  }
+  auto backoff(Backoff(request.attempts));
+  LOG(kWarning) << "Retrying put of PmidAndSigner "
+                << DebugId(request.pmid_and_signer->first.name().value) << " in "
+                << backoff.count() << "ms";
+  request.due = std::chrono::steady_clock::now() + backoff;
+  std::lock_guard<std::mutex> lock{mutex_};
+  pending_.push_back(std::move(request));
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -0,0 +1,91 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_PMID_PUBLISHER_H_
+#define MAIDSAFE_VAULT_MANAGER_PMID_PUBLISHER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/passport/passport.h"
+
+namespace maidsafe {
+
+namespace nfs_client {
+
+class MaidClient;
+
+}  // namespace nfs_client
+
+namespace vault_manager {
+
+// Stores the PublicPmid and PublicAnpmid of new vaults on the network using a single long-lived
+// MaidClient.  Requests which arrive while a batch is in flight are collected and sent together
+// as the next batch, with all puts of a batch issued before any are waited on.  Failed requests are
+// retried with exponential backoff and jitter; the client is recreated only if a whole batch fails.
+class PmidPublisher {
+ public:
+  typedef std::function<void(maidsafe_error)> OnPublished;
+
+  PmidPublisher();
+  ~PmidPublisher();
+
+  // 'on_published' is invoked on the publisher's thread with CommonErrors::success once both keys
+  // are stored, or with the last error once kMaxPmidPublishAttempts have failed.  If
+  // 'retry_until_stored' is true, the request is retried until it succeeds or Stop() is called.
+  void Publish(std::shared_ptr<passport::PmidAndSigner> pmid_and_signer, bool retry_until_stored,
+               OnPublished on_published);
+  // Pending requests are dropped without their functors being invoked.
+  void Stop();
+
+ private:
+  PmidPublisher(const PmidPublisher&) = delete;
+  PmidPublisher(PmidPublisher&&) = delete;
+  PmidPublisher& operator=(PmidPublisher) = delete;
+
+  struct Request {
+    std::shared_ptr<passport::PmidAndSigner> pmid_and_signer;
+    bool retry_until_stored;
+    OnPublished on_published;
+    int attempts;
+    std::chrono::steady_clock::time_point due;
+  };
+
+  void Run();
+  void PublishBatch(std::vector<Request> batch);
+  void Retry(Request request, const maidsafe_error& error);
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<Request> pending_;
+  bool stop_;
+  std::shared_ptr<nfs_client::MaidClient> client_;
+  std::thread thread_;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_PMID_PUBLISHER_H_
@@ -19,12 +19,22 @@
 #include "maidsafe/vault_manager/process_manager.h"
 
 #include <algorithm>
+#include <cerrno>
+#include <iterator>
+#include <string>
+#include <thread>
 #include <type_traits>
 
-#ifdef MAIDSAFE_BSD
-extern "C" char** environ;
+#ifndef MAIDSAFE_WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+#ifdef MAIDSAFE_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
 #endif
 
+#ifdef MAIDSAFE_WIN32
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 4702)
@@ -34,6 +44,7 @@ extern "C" char** environ;
 #pragma warning(pop)
 #endif
 #include "boost/process/initializers.hpp"
+#endif
 #include "boost/process/mitigate.hpp"
 #include "boost/process/terminate.hpp"
 #include "boost/process/wait_for_exit.hpp"
@@ -45,6 +56,7 @@ extern "C" char** environ;
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/visualiser_log.h"
 
+#include "maidsafe/vault_manager/resource_sampler.h"
 #include "maidsafe/vault_manager/utils.h"
 #include "maidsafe/vault_manager/messages/vault_shutdown_request.h"
 
@@ -57,48 +69,63 @@ namespace vault_manager {
 
 namespace {
 
-bool ConnectionsEqual(const tcp::ConnectionPtr& lhs, const tcp::ConnectionPtr& rhs) {
-  return !lhs.owner_before(rhs) && !rhs.owner_before(lhs);
+std::string PmidKey(const VaultInfo& vault_info) {
+  return vault_info.pmid_and_signer->first.name().value.string();
 }
 
-void CheckNewVaultDoesntConflict(const VaultInfo& new_vault, const VaultInfo& existing_vault) {
-  if (new_vault.pmid_and_signer && existing_vault.pmid_and_signer &&
-      new_vault.pmid_and_signer->first.name() == existing_vault.pmid_and_signer->first.name()) {
-    LOG(kError) << "Vault process with Pmid "
-                << DebugId(new_vault.pmid_and_signer->first.name().value) << " already exists.";
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
-  }
-
-  if (new_vault.vault_dir == existing_vault.vault_dir) {
-    LOG(kError) << "Vault process with vault dir " << new_vault.vault_dir << " already exists.";
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
-  }
-
-  if (new_vault.label == existing_vault.label) {
-    LOG(kError) << "Vault process with label " << new_vault.label.string() << " already exists.";
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
-  }
+VaultResourceLimits DefaultResourceLimits() {
+  VaultResourceLimits limits;
+  limits.cpu_weight = kDefaultVaultCpuWeight;
+  limits.io_weight = kDefaultVaultIoWeight;
+  return limits;
+}
 
-  if (ConnectionsEqual(new_vault.tcp_connection, existing_vault.tcp_connection)) {
-    LOG(kError) << "Vault process with this tcp_connection already exists.";
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
-  }
+std::size_t MaxConcurrentStarts() {
+  return std::max<std::size_t>(2U, std::thread::hardware_concurrency());
 }
 
 }  // unnamed namespace
 
-ProcessManager::Child::Child(VaultInfo info, asio::io_service& io_service, int restarts)
+RetainedVaultState::RetainedVaultState()
+    : resource_limits(DefaultResourceLimits()), resource_samples(), restart_budget() {}
+
+ProcessManager::Shutdown::Shutdown(asio::io_service& io_service,
+                                   std::size_t max_concurrent_stops_in,
+                                   std::chrono::milliseconds interval_in,
+                                   StopProgressFunctor on_progress_in)
+    : max_concurrent_stops(std::max<std::size_t>(1U, max_concurrent_stops_in)),
+      interval(interval_in),
+      on_progress(std::move(on_progress_in)),
+      queue(),
+      stopped_count(0),
+      total(0),
+      next_stop_time(),
+      pacing_timer(io_service),
+      pacing_timer_armed(false),
+      all_stopped(),
+      all_stopped_future(all_stopped.get_future().share()) {}
+
+ProcessManager::Child::Child(VaultInfo info, asio::io_service& io_service)
     : info(std::move(info)),
       on_exit(),
       timer(maidsafe::make_unique<Timer>(io_service)),
-      restart_count(restarts),
+      restart_budget(),
+      restart_time(),
       process_args(),
+      resource_limits(DefaultResourceLimits()),
+      resource_samples(kResourceSampleCount),
+      last_heartbeat(),
+      heartbeat_progress(0),
+      heartbeat_state(HeartbeatState::kHealthy),
       status(ProcessStatus::kBeforeStarted),
 #ifdef MAIDSAFE_WIN32
       process(PROCESS_INFORMATION()),
       handle(io_service) {
 }
 #else
+#ifdef MAIDSAFE_LINUX
+      exit_watcher(),
+#endif
       process(0) {
 }
 #endif
@@ -107,14 +134,23 @@ ProcessManager::Child::Child(Child&& other)
     : info(std::move(other.info)),
       on_exit(std::move(other.on_exit)),
       timer(std::move(other.timer)),
-      restart_count(std::move(other.restart_count)),
+      restart_budget(std::move(other.restart_budget)),
+      restart_time(std::move(other.restart_time)),
       process_args(std::move(other.process_args)),
+      resource_limits(std::move(other.resource_limits)),
+      resource_samples(std::move(other.resource_samples)),
+      last_heartbeat(std::move(other.last_heartbeat)),
+      heartbeat_progress(std::move(other.heartbeat_progress)),
+      heartbeat_state(std::move(other.heartbeat_state)),
       status(std::move(other.status)),
 #ifdef MAIDSAFE_WIN32
       process(std::move(other.process)),
       handle(std::move(other.handle)) {
 }
 #else
+#ifdef MAIDSAFE_LINUX
+      exit_watcher(std::move(other.exit_watcher)),
+#endif
       process(std::move(other.process)) {
 }
 #endif
@@ -129,27 +165,53 @@ void swap(ProcessManager::Child& lhs, ProcessManager::Child& rhs) {
   swap(lhs.info, rhs.info);
   swap(lhs.on_exit, rhs.on_exit);
   swap(lhs.timer, rhs.timer);
-  swap(lhs.restart_count, rhs.restart_count);
+  swap(lhs.restart_budget, rhs.restart_budget);
+  swap(lhs.restart_time, rhs.restart_time);
   swap(lhs.process_args, rhs.process_args);
+  swap(lhs.resource_limits, rhs.resource_limits);
+  swap(lhs.resource_samples, rhs.resource_samples);
+  swap(lhs.last_heartbeat, rhs.last_heartbeat);
+  swap(lhs.heartbeat_progress, rhs.heartbeat_progress);
+  swap(lhs.heartbeat_state, rhs.heartbeat_state);
   swap(lhs.status, rhs.status);
   swap(lhs.process, rhs.process);
 #ifdef MAIDSAFE_WIN32
   swap(lhs.handle, rhs.handle);
 #endif
+#ifdef MAIDSAFE_LINUX
+  swap(lhs.exit_watcher, rhs.exit_watcher);
+#endif
 }
 
 
 
-ProcessManager::ProcessManager(asio::io_service& io_service, fs::path vault_executable_path,
+ProcessManager::ProcessManager(asio::io_service::strand& strand, fs::path vault_executable_path,
                                tcp::Port listening_port)
-    : io_service_(io_service),
+    : strand_(strand),
+      io_service_(strand.get_io_service()),
 #ifndef MAIDSAFE_WIN32
       signal_set_(io_service_, SIGCHLD),
 #endif
-      stop_all_flag_(),
+      resource_sample_timer_(io_service_),
+      heartbeat_timer_(io_service_),
+      shutdown_(),
       kListeningPort_(listening_port),
       kVaultExecutablePath_(vault_executable_path),
-      vaults_() {
+      cgroups_(),
+      placement_(),
+#ifndef MAIDSAFE_WIN32
+      launcher_(MakeLauncher()),
+#endif
+      vaults_(),
+      label_index_(),
+      pmid_index_(),
+      vault_dir_index_(),
+      connection_index_(),
+      process_id_index_(),
+      kMaxConcurrentStarts_(MaxConcurrentStarts()),
+      launch_queue_(),
+      starting_count_(0),
+      stopping_count_(0) {
   static_assert(std::is_same<ProcessId, process::ProcessId>::value,
                 "process::ProcessId is statically checked as being of suitable size for holding a "
                 "pid_t or DWORD, so vault_manager::ProcessId should use the same type.");
@@ -167,45 +229,95 @@ ProcessManager::ProcessManager(asio::io_service& io_service, fs::path vault_exec
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
   }
   InitSignalHandler();
+  ScheduleResourceSampling();
+  ScheduleHeartbeatCheck();
 }
 
 std::shared_ptr<ProcessManager> ProcessManager::MakeShared(
-    asio::io_service& io_service, boost::filesystem::path vault_executable_path,
+    asio::io_service::strand& strand, boost::filesystem::path vault_executable_path,
     tcp::Port listening_port) {
   return std::shared_ptr<ProcessManager>{
-      new ProcessManager{io_service, vault_executable_path, listening_port}};
+      new ProcessManager{strand, vault_executable_path, listening_port}};
 }
 
 ProcessManager::~ProcessManager() { assert(vaults_.empty()); }
 
-void ProcessManager::StopAll() {
-  std::call_once(stop_all_flag_, [this] {
-    for (const auto& vault : vaults_)
-      StopProcess(vault.info.tcp_connection);
-#ifndef MAIDSAFE_WIN32
-    std::error_code ignored_ec;
-    signal_set_.cancel(ignored_ec);
-#endif
-  });
-}
-
-void ProcessManager::StopAllWithInterval() {
-  int index(0);
-  std::call_once(stop_all_flag_, [this, &index] {
-    std::vector<tcp::ConnectionPtr> connections;
-    for (const auto& vault : vaults_)
-      connections.push_back(vault.info.tcp_connection);
-    for (const auto& connection : connections) {
-      ++index;
-      TLOG(kDefaultColour) << "stopping vault " << index << '\n';
-      StopProcess(connection);
-      Sleep(std::chrono::seconds(5));
+std::shared_future<void> ProcessManager::StopAll(std::size_t max_concurrent_stops,
+                                                 std::chrono::milliseconds interval,
+                                                 StopProgressFunctor on_progress) {
+  if (shutdown_)
+    return shutdown_->all_stopped_future;
+  shutdown_ = maidsafe::make_unique<Shutdown>(io_service_, max_concurrent_stops, interval,
+                                               std::move(on_progress));
+  EraseUnstarted();
+  for (const auto& vault : vaults_) {
+    if (vault.status != ProcessStatus::kStopping)
+      shutdown_->queue.push_back(vault.info.label);
+  }
+  shutdown_->total = vaults_.size();
+  LOG(kInfo) << "Stopping " << shutdown_->total << " vault(s)";
+  StopQueuedProcesses();
+  HandleStopAllProgress();
+  return shutdown_->all_stopped_future;
+}
+
+void ProcessManager::StopQueuedProcesses() {
+  while (!shutdown_->queue.empty() && stopping_count_ < shutdown_->max_concurrent_stops) {
+    auto now(std::chrono::steady_clock::now());
+    if (now < shutdown_->next_stop_time) {
+      if (!shutdown_->pacing_timer_armed) {
+        shutdown_->pacing_timer_armed = true;
+        shutdown_->pacing_timer.expires_at(shutdown_->next_stop_time);
+        shutdown_->pacing_timer.async_wait(
+            strand_.wrap([this](const std::error_code& error_code) {
+              if (error_code)
+                return;
+              shutdown_->pacing_timer_armed = false;
+              StopQueuedProcesses();
+            }));
+      }
+      return;
+    }
+
+    NonEmptyString label{shutdown_->queue.front()};
+    shutdown_->queue.pop_front();
+    auto index_itr(label_index_.find(label.string()));
+    // The vault may have exited or started stopping of its own accord since being queued.
+    if (index_itr == std::end(label_index_) ||
+        index_itr->second->status == ProcessStatus::kStopping) {
+      continue;
     }
+    RequestStop(index_itr->second, index_itr->second->on_exit);
+    shutdown_->next_stop_time = now + shutdown_->interval;
+  }
+}
+
+void ProcessManager::HandleStopAllProgress() {
+  shutdown_->stopped_count = shutdown_->total - vaults_.size();
+  if (shutdown_->on_progress) {
+    try {
+      shutdown_->on_progress(shutdown_->stopped_count, shutdown_->total);
+    } catch (const std::exception& e) {
+      LOG(kError) << "Error executing StopAll progress functor: "
+                  << boost::diagnostic_information(e);
+    }
+  }
+  if (!vaults_.empty()) {
+    StopQueuedProcesses();
+    return;
+  }
+  std::error_code ignored_ec;
+  shutdown_->pacing_timer.cancel(ignored_ec);
+  resource_sample_timer_.cancel(ignored_ec);
+  heartbeat_timer_.cancel(ignored_ec);
 #ifndef MAIDSAFE_WIN32
-    std::error_code ignored_ec;
-    signal_set_.cancel(ignored_ec);
+  // Terminated vaults are erased without waiting for their exit to be reaped, so reap any which
+  // have exited since the last SIGCHLD before no longer listening for it.
+  ReapExitedChildren();
+  signal_set_.cancel(ignored_ec);
 #endif
-  });
+  LOG(kInfo) << "All vaults stopped";
+  shutdown_->all_stopped.set_value();
 }
 
 std::vector<VaultInfo> ProcessManager::GetAll() const {
@@ -215,40 +327,180 @@ std::vector<VaultInfo> ProcessManager::GetAll() const {
   return all_vaults;
 }
 
-void ProcessManager::AddProcess(VaultInfo info, int restart_count) {
+VaultInfo ProcessManager::AddProcess(VaultInfo info, const RetainedVaultState& retained_state) {
+  if (shutdown_) {
+    LOG(kError) << "Can't add vault: all vaults are being stopped.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  }
   if (info.vault_dir.empty() || !info.label.IsInitialised() || !info.pmid_and_signer) {
     LOG(kError) << "Can't add vault: vault_dir path and/or vault label and/or Pmid is empty.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
   }
-  if (restart_count > kMaxVaultRestarts) {
-    LOG(kError) << "Can't add vault process - too many restarts.";
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  CheckNewVaultDoesntConflict(info);
+
+  // The vault is counted against its node from here, so undo that if it can't be added.
+  info.numa_node = placement_.Place(info.numa_node);
+  on_scope_exit release_placement{[this, &info] { placement_.Release(info.numa_node); }};
+  // emplace offers strong exception guarantee - only need to cover subsequent calls, for which
+  // Erase also releases the placement.
+  auto itr(vaults_.emplace(std::end(vaults_), info, io_service_));
+  release_placement.Release();
+  on_scope_exit strong_guarantee{[this, itr] { Erase(itr); }};
+  itr->resource_limits = retained_state.resource_limits;
+  for (const auto& sample : retained_state.resource_samples)
+    itr->resource_samples.push_back(sample);
+  itr->restart_budget = retained_state.restart_budget;
+  AddToIndices(itr);
+  cgroups_.Add(itr->info.label, itr->resource_limits);
+  // The cpuset also binds the vault's memory to the node, which affinity alone can't do.
+  if (const PlacementEngine::Node* node = placement_.NodeToPin(itr->info.numa_node))
+    cgroups_.SetCpuset(itr->info.label, ToCpuList(node->cpus), std::to_string(node->id));
+  if (starting_count_ < kMaxConcurrentStarts_ && launch_queue_.empty()) {
+    StartProcess(itr);
+  } else {
+    LOG(kInfo) << "Queueing start of vault " << itr->info.label.string() << " behind "
+               << launch_queue_.size() << " other(s).";
+    launch_queue_.push_back(itr);
   }
-  for (const auto& vault : vaults_)
-    CheckNewVaultDoesntConflict(info, vault.info);
-
-  // emplace offers strong exception guarantee - only need to cover subsequent calls.
-  auto itr(vaults_.emplace(std::end(vaults_), Child{info, io_service_, restart_count}));
-  on_scope_exit strong_guarantee{[this, itr] { vaults_.erase(itr); }};
-  StartProcess(itr);
   strong_guarantee.Release();
+  return itr->info;
+}
+
+void ProcessManager::LaunchQueuedProcesses() {
+  while (starting_count_ < kMaxConcurrentStarts_ && !launch_queue_.empty()) {
+    ChildItr itr(launch_queue_.front());
+    launch_queue_.pop_front();
+    try {
+      StartProcess(itr);
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to start queued vault " << itr->info.label.string() << ": "
+                  << boost::diagnostic_information(e);
+      Erase(itr);
+    }
+  }
+}
+
+void ProcessManager::SetStatus(ChildItr itr, ProcessStatus status) {
+  if (itr->status == ProcessStatus::kStarting)
+    --starting_count_;
+  else if (itr->status == ProcessStatus::kStopping)
+    --stopping_count_;
+  if (status == ProcessStatus::kStarting)
+    ++starting_count_;
+  else if (status == ProcessStatus::kStopping)
+    ++stopping_count_;
+  itr->status = status;
+}
+
+void ProcessManager::CheckNewVaultDoesntConflict(const VaultInfo& new_vault) const {
+  if (pmid_index_.count(PmidKey(new_vault)) != 0U) {
+    LOG(kError) << "Vault process with Pmid "
+                << DebugId(new_vault.pmid_and_signer->first.name().value) << " already exists.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
+  }
+
+  if (vault_dir_index_.count(new_vault.vault_dir.string()) != 0U) {
+    LOG(kError) << "Vault process with vault dir " << new_vault.vault_dir << " already exists.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
+  }
+
+  if (label_index_.count(new_vault.label.string()) != 0U) {
+    LOG(kError) << "Vault process with label " << new_vault.label.string() << " already exists.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
+  }
+
+  if (new_vault.tcp_connection && connection_index_.count(new_vault.tcp_connection.get()) != 0U) {
+    LOG(kError) << "Vault process with this tcp_connection already exists.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
+  }
+}
+
+void ProcessManager::AddToIndices(ChildItr itr) {
+  label_index_.emplace(itr->info.label.string(), itr);
+  pmid_index_.emplace(PmidKey(itr->info), itr);
+  vault_dir_index_.emplace(itr->info.vault_dir.string(), itr);
+  if (itr->info.tcp_connection)
+    connection_index_.emplace(itr->info.tcp_connection.get(), itr);
+}
+
+void ProcessManager::SetConnection(ChildItr itr, tcp::ConnectionPtr connection) {
+  if (itr->info.tcp_connection) {
+    auto index_itr(connection_index_.find(itr->info.tcp_connection.get()));
+    if (index_itr != std::end(connection_index_) && index_itr->second == itr)
+      connection_index_.erase(index_itr);
+  }
+  if (connection)
+    connection_index_[connection.get()] = itr;
+  itr->info.tcp_connection = std::move(connection);
+}
+
+void ProcessManager::Erase(ChildItr itr) {
+  // Only remove index entries which refer to this child, so a failed insertion into an index can't
+  // cause another child's entry to be removed.
+  auto erase_from = [itr](StringIndex& index, const std::string& key) {
+    auto index_itr(index.find(key));
+    if (index_itr != std::end(index) && index_itr->second == itr)
+      index.erase(index_itr);
+  };
+  erase_from(label_index_, itr->info.label.string());
+  erase_from(pmid_index_, PmidKey(itr->info));
+  erase_from(vault_dir_index_, itr->info.vault_dir.string());
+
+  if (itr->info.tcp_connection) {
+    auto connection_itr(connection_index_.find(itr->info.tcp_connection.get()));
+    if (connection_itr != std::end(connection_index_) && connection_itr->second == itr)
+      connection_index_.erase(connection_itr);
+  }
+
+  if (itr->status == ProcessStatus::kBeforeStarted) {
+    launch_queue_.erase(std::remove(std::begin(launch_queue_), std::end(launch_queue_), itr),
+                        std::end(launch_queue_));
+  } else if (itr->status != ProcessStatus::kBackingOff) {
+    auto process_id_itr(process_id_index_.find(GetProcessId(*itr)));
+    if (process_id_itr != std::end(process_id_index_) && process_id_itr->second == itr)
+      process_id_index_.erase(process_id_itr);
+  }
+
+  if (itr->status == ProcessStatus::kStarting)
+    --starting_count_;
+  else if (itr->status == ProcessStatus::kStopping)
+    --stopping_count_;
+  cgroups_.Remove(itr->info.label);
+  placement_.Release(itr->info.numa_node);
+  vaults_.erase(itr);
 }
 
 VaultInfo ProcessManager::HandleVaultStarted(tcp::ConnectionPtr connection, ProcessId process_id) {
-  auto itr(
-      std::find_if(std::begin(vaults_), std::end(vaults_), [this, process_id](const Child& vault) {
-        return GetProcessId(vault) == process_id;
-      }));
-  if (itr == std::end(vaults_)) {
-    LOG(kError) << "Failed to find vault with process ID " << process_id << " in child processes.";
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  auto itr(DoFind(process_id));
+  if (itr->status == ProcessStatus::kStopping) {
+    // StopAll got to this vault before it connected.  Leave the stop timer running.
+    SetConnection(itr, connection);
+    Send(connection, VaultShutdownRequest());
+    return itr->info;
   }
   itr->timer->cancel();
-  itr->info.tcp_connection = connection;
-  itr->status = ProcessStatus::kRunning;
+  SetConnection(itr, connection);
+  SetStatus(itr, ProcessStatus::kRunning);
+  itr->last_heartbeat = std::chrono::steady_clock::now();
+  itr->heartbeat_state = HeartbeatState::kHealthy;
+  LaunchQueuedProcesses();
   return itr->info;
 }
 
+void ProcessManager::HandleHeartbeat(tcp::ConnectionPtr connection, uint64_t sequence,
+                                     uint64_t progress) {
+  auto itr(DoFind(connection));
+  if (itr->heartbeat_state != HeartbeatState::kHealthy) {
+    LOG(kInfo) << "Vault " << itr->info.label.string() << " resumed heartbeating at sequence "
+               << sequence;
+  }
+  itr->last_heartbeat = std::chrono::steady_clock::now();
+  itr->heartbeat_progress = progress;
+  // Once asked to stop, the vault is left to exit and be restarted even if it recovers.
+  if (itr->heartbeat_state == HeartbeatState::kWarned)
+    itr->heartbeat_state = HeartbeatState::kHealthy;
+}
+
 void ProcessManager::AssignOwner(const NonEmptyString& label,
                                  const passport::PublicMaid::Name& owner_name,
                                  DiskUsage max_disk_usage) {
@@ -257,7 +509,20 @@ void ProcessManager::AssignOwner(const NonEmptyString& label,
   itr->info.max_disk_usage = max_disk_usage;
 }
 
-void ProcessManager::StartProcess(std::vector<Child>::iterator itr) {
+void ProcessManager::SetVaultDir(const NonEmptyString& label, const fs::path& vault_dir) {
+  auto itr(DoFind(label));
+  if (itr->info.vault_dir == vault_dir)
+    return;
+  if (vault_dir_index_.count(vault_dir.string()) != 0U) {
+    LOG(kError) << "Vault process with vault dir " << vault_dir << " already exists.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
+  }
+  vault_dir_index_.erase(itr->info.vault_dir.string());
+  itr->info.vault_dir = vault_dir;
+  vault_dir_index_.emplace(vault_dir.string(), itr);
+}
+
+void ProcessManager::StartProcess(ChildItr itr) {
   if (itr->status != ProcessStatus::kBeforeStarted) {
     LOG(kError) << "Process has already been started.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
@@ -265,18 +530,23 @@ void ProcessManager::StartProcess(std::vector<Child>::iterator itr) {
 
   std::vector<std::string> args{1, kVaultExecutablePath_.string()};
   args.emplace_back(std::to_string(kListeningPort_));
-  args.emplace_back("--log_folder " + (itr->info.vault_dir / "logs").string());
+  args.emplace_back("--log_folder");
+  args.emplace_back((itr->info.vault_dir / "logs").string());
   args.insert(std::end(args), std::begin(itr->process_args), std::end(itr->process_args));
 
   NonEmptyString label{itr->info.label};
+#ifdef MAIDSAFE_WIN32
   itr->process = bp::execute(bp::initializers::run_exe(kVaultExecutablePath_),
                              bp::initializers::set_cmd_line(process::ConstructCommandLine(args)),
-#ifndef MAIDSAFE_WIN32
-                             bp::initializers::notify_io_service(io_service_),
-#endif
                              bp::initializers::throw_on_error(), bp::initializers::inherit_env());
+#else
+  itr->process =
+      bp::child(static_cast<pid_t>(launcher_->Launch(args, cgroups_.Descriptor(label))));
+  placement_.SetAffinity(GetProcessId(*itr), itr->info.numa_node);
+#endif
 
-  itr->status = ProcessStatus::kStarting;
+  SetStatus(itr, ProcessStatus::kStarting);
+  process_id_index_[GetProcessId(*itr)] = itr;
 
 #ifdef MAIDSAFE_WIN32
   HANDLE copied_handle;
@@ -284,27 +554,35 @@ void ProcessManager::StartProcess(std::vector<Child>::iterator itr) {
                   &copied_handle, 0, FALSE, DUPLICATE_SAME_ACCESS);
   itr->handle.assign(copied_handle);
   HANDLE native_handle{itr->handle.native_handle()};
-  itr->handle.async_wait([this, label, native_handle](const std::error_code&) {
+  itr->handle.async_wait(strand_.wrap([this, label,
+                                       native_handle](const std::error_code& error_code) {
+    if (error_code)  // The handle has been closed, e.g. since the vault is backing off.
+      return;
     DWORD exit_code;
     GetExitCodeProcess(native_handle, &exit_code);
     OnProcessExit(label, BOOST_PROCESS_EXITSTATUS(exit_code));
-  });
+  }));
+#else
+  WatchForExit(itr);
 #endif
 
-  itr->timer->expires_from_now(kRpcTimeout);
-  itr->timer->async_wait([this, label](const std::error_code& error_code) {
-    if (!error_code || error_code != asio::error::operation_aborted)
+  itr->timer->expires_from_now(kVaultStartTimeout);
+  itr->timer->async_wait(strand_.wrap([this, label](const std::error_code& error_code) {
+    if (error_code)  // Cancelled, e.g. since the vault has connected.
       return;
     LOG(kWarning) << "Timed out waiting for new process to connect via TCP.";
     OnProcessExit(label, -1, true);
-  });
+  }));
 }
 
 void ProcessManager::InitSignalHandler() {
 #ifndef MAIDSAFE_WIN32
-  signal_set_.async_wait([this](const std::error_code& error_code, int signum) {
-    if (!error_code || error_code != asio::error::operation_aborted)
+  signal_set_.async_wait(strand_.wrap([this](const std::error_code& error_code, int signum) {
+    if (error_code) {
+      if (error_code != asio::error::operation_aborted)
+        LOG(kError) << "Error waiting for signal: " << error_code.message();
       return;
+    }
 
     maidsafe::on_scope_exit init_on_exit([this]() { InitSignalHandler(); });
 
@@ -313,28 +591,139 @@ void ProcessManager::InitSignalHandler() {
       return;
     }
 
-    int exit_code;
-    ProcessId process_id{static_cast<ProcessId>(wait(&exit_code))};
-    LOG(kWarning) << "Process ID " << process::GetProcessId()
-                  << " received SIGCHLD pid: " << process_id;
-    if (process_id == process::GetProcessId())
+    ReapExitedChildren();
+  }));
+#endif
+}
+
+void ProcessManager::ScheduleResourceSampling() {
+  resource_sample_timer_.expires_from_now(kResourceSampleInterval);
+  resource_sample_timer_.async_wait(strand_.wrap([this](const std::error_code& error_code) {
+    if (error_code)
+      return;
+    SampleResourceUsageOfAll();
+    ScheduleResourceSampling();
+  }));
+}
+
+void ProcessManager::SampleResourceUsageOfAll() {
+  for (auto& vault : vaults_) {
+    if (vault.status != ProcessStatus::kStarting && vault.status != ProcessStatus::kRunning &&
+        vault.status != ProcessStatus::kStopping) {
+      continue;
+    }
+    auto sample(SampleResourceUsage(GetProcessId(vault)));
+    if (sample)
+      vault.resource_samples.push_back(*sample);
+  }
+}
+
+void ProcessManager::ScheduleHeartbeatCheck() {
+  heartbeat_timer_.expires_from_now(kVaultHeartbeatInterval);
+  heartbeat_timer_.async_wait(strand_.wrap([this](const std::error_code& error_code) {
+    if (error_code)
       return;
+    CheckHeartbeats();
+    ScheduleHeartbeatCheck();
+  }));
+}
+
+void ProcessManager::CheckHeartbeats() {
+  auto now(std::chrono::steady_clock::now());
+  std::vector<NonEmptyString> hung_vaults;
+  for (auto& vault : vaults_) {
+    if (vault.status != ProcessStatus::kRunning)
+      continue;
+    auto silence(now - vault.last_heartbeat);
+    if (silence >= kVaultHeartbeatTerminateTimeout) {
+      hung_vaults.push_back(vault.info.label);
+    } else if (silence >= kVaultHeartbeatShutdownTimeout &&
+               vault.heartbeat_state != HeartbeatState::kShutdownRequested) {
+      LOG(kWarning) << "Vault " << vault.info.label.string()
+                    << " still not heartbeating; asking it to stop.";
+      vault.heartbeat_state = HeartbeatState::kShutdownRequested;
+      Send(vault.info.tcp_connection, VaultShutdownRequest());
+    } else if (silence >= kVaultHeartbeatWarningTimeout &&
+               vault.heartbeat_state == HeartbeatState::kHealthy) {
+      LOG(kWarning) << "Vault " << vault.info.label.string() << " has missed heartbeats (last "
+                    << "progress " << vault.heartbeat_progress << ").";
+      vault.heartbeat_state = HeartbeatState::kWarned;
+    }
+  }
+  // Handled outside the loop, since this can erase the vault.
+  for (const auto& label : hung_vaults) {
+    LOG(kError) << "Vault " << label.string() << " is hung; terminating it.";
+    OnProcessExit(label, -1, true);
+  }
+}
 
-    auto child_itr(std::find_if(
-        std::begin(vaults_), std::end(vaults_),
-        [this, process_id](const Child& vault) { return GetProcessId(vault) == process_id; }));
-    if (child_itr == std::end(vaults_))
+void ProcessManager::WatchForExit(ChildItr itr) {
+#if defined(MAIDSAFE_LINUX) && defined(SYS_pidfd_open)
+  int pid_fd{static_cast<int>(syscall(SYS_pidfd_open, static_cast<pid_t>(itr->process.pid), 0))};
+  if (pid_fd < 0) {
+    LOG(kVerbose) << "pidfd_open unavailable (" << errno << "); relying on SIGCHLD.";
+    return;
+  }
+  itr->exit_watcher = maidsafe::make_unique<asio::posix::stream_descriptor>(io_service_, pid_fd);
+  ProcessId process_id{GetProcessId(*itr)};
+  // The descriptor becomes readable once the child has exited.  If the child is erased first, the
+  // descriptor is destroyed and this handler is invoked with operation_aborted.
+  itr->exit_watcher->async_read_some(
+      asio::null_buffers(),
+      strand_.wrap([this, process_id](const std::error_code& error_code, std::size_t) {
+        if (error_code)
+          return;
+        ReapChild(process_id);
+      }));
+#else
+  static_cast<void>(itr);
+#endif
+}
+
+void ProcessManager::ReapExitedChildren() {
+#ifndef MAIDSAFE_WIN32
+  for (;;) {
+    int status{0};
+    pid_t pid{waitpid(-1, &status, WNOHANG)};
+    // 0 means no further children have exited, -1 with ECHILD means there are no children left.
+    if (pid <= 0)
       return;
+    OnChildReaped(static_cast<ProcessId>(pid), status);
+  }
+#endif
+}
+
+void ProcessManager::ReapChild(ProcessId process_id) {
+#ifndef MAIDSAFE_WIN32
+  int status{0};
+  // If the SIGCHLD drain has already reaped this child, there's nothing left to do.
+  if (waitpid(static_cast<pid_t>(process_id), &status, WNOHANG) ==
+      static_cast<pid_t>(process_id)) {
+    OnChildReaped(process_id, status);
+  }
+#else
+  static_cast<void>(process_id);
+#endif
+}
+
+void ProcessManager::OnChildReaped(ProcessId process_id, int status) {
+#ifndef MAIDSAFE_WIN32
+  LOG(kWarning) << "Process ID " << process::GetProcessId() << " reaped child pid: " << process_id;
+  auto child_itr(process_id_index_.find(process_id));
+  if (child_itr == std::end(process_id_index_))
+    return;
 
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
 #endif
-    OnProcessExit(child_itr->info.label, BOOST_PROCESS_EXITSTATUS(exit_code));
+  OnProcessExit(child_itr->second->info.label, BOOST_PROCESS_EXITSTATUS(status));
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
-  });
+#else
+  static_cast<void>(process_id);
+  static_cast<void>(status);
 #endif
 }
 
@@ -346,17 +735,26 @@ void ProcessManager::StopProcess(tcp::ConnectionPtr connection, OnExitFunctor on
     LOG(kError) << "Vault process doesn't exist: " << boost::diagnostic_information(e);
     return;
   }
+  RequestStop(itr, on_exit_functor);
+  LaunchQueuedProcesses();
+}
+
+void ProcessManager::RequestStop(ChildItr itr, OnExitFunctor on_exit_functor) {
   itr->on_exit = on_exit_functor;
-  itr->status = ProcessStatus::kStopping;
-  Send(itr->info.tcp_connection, VaultShutdownRequest());
+  SetStatus(itr, ProcessStatus::kStopping);
+  // A vault which hasn't connected yet can't be asked to stop, so just terminate it.
+  if (itr->info.tcp_connection)
+    Send(itr->info.tcp_connection, VaultShutdownRequest());
+  else
+    TerminateProcess(itr);
   NonEmptyString label{itr->info.label};
   itr->timer->expires_from_now(kVaultStopTimeout);
-  itr->timer->async_wait([this, label](const std::error_code& error_code) {
-    if (!error_code || error_code != asio::error::operation_aborted)
+  itr->timer->async_wait(strand_.wrap([this, label](const std::error_code& error_code) {
+    if (error_code)  // Cancelled, e.g. since the vault has exited.
       return;
     LOG(kWarning) << "Timed out waiting for Vault to stop; terminating now.";
     OnProcessExit(label, -1, true);
-  });
+  }));
 }
 
 bool ProcessManager::HandleConnectionClosed(tcp::ConnectionPtr connection) {
@@ -372,50 +770,49 @@ bool ProcessManager::HandleConnectionClosed(tcp::ConnectionPtr connection) {
 
 VaultInfo ProcessManager::Find(const NonEmptyString& label) const { return DoFind(label)->info; }
 
-std::vector<ProcessManager::Child>::const_iterator ProcessManager::DoFind(
-    const NonEmptyString& label) const {
-  auto itr(std::find_if(std::begin(vaults_), std::end(vaults_),
-                        [this, &label](const Child& vault) { return vault.info.label == label; }));
-  if (itr == std::end(vaults_)) {
+ProcessManager::ChildConstItr ProcessManager::DoFind(const NonEmptyString& label) const {
+  auto itr(label_index_.find(label.string()));
+  if (itr == std::end(label_index_)) {
     LOG(kError) << "Vault process with label " << label.string() << " doesn't exist.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
   }
-  return itr;
+  return itr->second;
 }
 
-std::vector<ProcessManager::Child>::iterator ProcessManager::DoFind(const NonEmptyString& label) {
-  auto itr(std::find_if(std::begin(vaults_), std::end(vaults_),
-                        [this, &label](const Child& vault) { return vault.info.label == label; }));
-  if (itr == std::end(vaults_)) {
+ProcessManager::ChildItr ProcessManager::DoFind(const NonEmptyString& label) {
+  auto itr(label_index_.find(label.string()));
+  if (itr == std::end(label_index_)) {
     LOG(kError) << "Vault process with label " << label.string() << " doesn't exist.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
   }
-  return itr;
+  return itr->second;
 }
 
 VaultInfo ProcessManager::Find(tcp::ConnectionPtr connection) const {
   return DoFind(connection)->info;
 }
 
-std::vector<ProcessManager::Child>::const_iterator ProcessManager::DoFind(
-    tcp::ConnectionPtr connection) const {
-  auto itr(
-      std::find_if(std::begin(vaults_), std::end(vaults_), [this, connection](const Child& vault) {
-        return ConnectionsEqual(vault.info.tcp_connection, connection);
-      }));
-  if (itr == std::end(vaults_))
+ProcessManager::ChildConstItr ProcessManager::DoFind(tcp::ConnectionPtr connection) const {
+  auto itr(connection_index_.find(connection.get()));
+  if (!connection || itr == std::end(connection_index_))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
-  return itr;
+  return itr->second;
 }
 
-std::vector<ProcessManager::Child>::iterator ProcessManager::DoFind(tcp::ConnectionPtr connection) {
-  auto itr(
-      std::find_if(std::begin(vaults_), std::end(vaults_), [this, connection](const Child& vault) {
-        return ConnectionsEqual(vault.info.tcp_connection, connection);
-      }));
-  if (itr == std::end(vaults_))
+ProcessManager::ChildItr ProcessManager::DoFind(tcp::ConnectionPtr connection) {
+  auto itr(connection_index_.find(connection.get()));
+  if (!connection || itr == std::end(connection_index_))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
-  return itr;
+  return itr->second;
+}
+
+ProcessManager::ChildItr ProcessManager::DoFind(ProcessId process_id) {
+  auto itr(process_id_index_.find(process_id));
+  if (itr == std::end(process_id_index_)) {
+    LOG(kError) << "Failed to find vault with process ID " << process_id << " in child processes.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  }
+  return itr->second;
 }
 
 ProcessId ProcessManager::GetProcessId(const Child& vault) const {
@@ -440,28 +837,25 @@ bool ProcessManager::IsRunning(const Child& vault) const {
 }
 
 void ProcessManager::OnProcessExit(const NonEmptyString& label, int exit_code, bool terminate) {
-  auto child_itr(
-      std::find_if(std::begin(vaults_), std::end(vaults_),
-                   [this, &label](const Child& vault) { return vault.info.label == label; }));
-  if (child_itr == std::end(vaults_))
+  auto index_itr(label_index_.find(label.string()));
+  if (index_itr == std::end(label_index_))
     return;
+  ChildItr child_itr(index_itr->second);
+  // There's no process to have exited if it's yet to be (re)started.
+  if (child_itr->status == ProcessStatus::kBeforeStarted ||
+      child_itr->status == ProcessStatus::kBackingOff) {
+    return;
+  }
 
-  VaultInfo vault_info;
-  int restart_count{-1};
-  if (child_itr->status != ProcessStatus::kStopping) {  // Unexpected exit - try to restart.
-    restart_count = child_itr->restart_count;
-    vault_info = child_itr->info;
-    LOG(kError) << "Vault " << DebugId(vault_info.pmid_and_signer->first.name().value)
+  bool unexpected{child_itr->status != ProcessStatus::kStopping};
+  if (unexpected) {
+    LOG(kError) << "Vault " << DebugId(child_itr->info.pmid_and_signer->first.name().value)
                 << " stopped unexpectedly";
 #ifdef USE_VLOGGING
     log::VisualiserLogMessage::SendVaultStoppedMessage(
-        DebugId(vault_info.pmid_and_signer->first.name().value), vault_info.vlog_session_id,
-        exit_code);
+        DebugId(child_itr->info.pmid_and_signer->first.name().value),
+        child_itr->info.vlog_session_id, exit_code);
 #endif
-    if (vault_info.tcp_connection) {
-      vault_info.tcp_connection->Close();
-      vault_info.tcp_connection.reset();
-    }
   }
 
   bool is_running{IsRunning(*child_itr)};
@@ -472,13 +866,19 @@ void ProcessManager::OnProcessExit(const NonEmptyString& label, int exit_code, b
     child_itr->info.tcp_connection->Close();
 
   OnExitFunctor on_exit{child_itr->on_exit};
-  vaults_.erase(child_itr);
+  if (unexpected && !shutdown_)
+    ScheduleRestart(child_itr);
+  else
+    Erase(child_itr);
+  if (shutdown_)
+    HandleStopAllProgress();
+  else
+    LaunchQueuedProcesses();
 
   InvokeOnExitFunctor(on_exit, exit_code, terminate);
-  RestartIfRequired(restart_count, std::move(vault_info));
 }
 
-void ProcessManager::TerminateProcess(std::vector<Child>::iterator itr) {
+void ProcessManager::TerminateProcess(ChildItr itr) {
   boost::system::error_code ec;
   bp::terminate(itr->process, ec);
   if (ec)
@@ -503,18 +903,98 @@ void ProcessManager::InvokeOnExitFunctor(OnExitFunctor on_exit, int exit_code, b
   }
 }
 
-void ProcessManager::RestartIfRequired(int restart_count, VaultInfo vault_info) {
-  if (restart_count < 0 || restart_count >= kMaxVaultRestarts)
-    return;
+void ProcessManager::ScheduleRestart(ChildItr itr) {
+  auto process_id_itr(process_id_index_.find(GetProcessId(*itr)));
+  if (process_id_itr != std::end(process_id_index_) && process_id_itr->second == itr)
+    process_id_index_.erase(process_id_itr);
+  SetConnection(itr, nullptr);
+#ifdef MAIDSAFE_WIN32
+  std::error_code ignored_ec;
+  itr->handle.close(ignored_ec);
+#endif
+#ifdef MAIDSAFE_LINUX
+  itr->exit_watcher.reset();
+#endif
+  itr->on_exit = nullptr;
+  SetStatus(itr, ProcessStatus::kBackingOff);
 
-  LOG(kWarning) << "Restarting vault " << vault_info.label.string();
-  io_service_.post([vault_info, restart_count, this] {
-    try {
-      AddProcess(std::move(vault_info), restart_count + 1);
-    } catch (const std::exception& e) {
-      LOG(kError) << "Failed restarting vault: " << boost::diagnostic_information(e);
+  std::chrono::milliseconds delay{
+      itr->restart_budget.RecordFailure(std::chrono::steady_clock::now(), RandomUint32())};
+  itr->restart_time = std::chrono::steady_clock::now() + delay;
+  NonEmptyString label{itr->info.label};
+  LOG(kWarning) << "Restarting vault " << label.string() << " in " << delay.count() << "ms";
+  itr->timer->expires_from_now(delay);
+  itr->timer->async_wait(strand_.wrap([this, label](const std::error_code& error_code) {
+    if (error_code)  // Cancelled, e.g. since the vault has been removed.
+      return;
+    auto index_itr(label_index_.find(label.string()));
+    if (index_itr == std::end(label_index_) ||
+        index_itr->second->status != ProcessStatus::kBackingOff) {
+      return;
     }
-  });
+    SetStatus(index_itr->second, ProcessStatus::kBeforeStarted);
+    launch_queue_.push_back(index_itr->second);
+    LaunchQueuedProcesses();
+  }));
+}
+
+void ProcessManager::EraseUnstarted() {
+  auto itr(std::begin(vaults_));
+  while (itr != std::end(vaults_)) {
+    auto next(std::next(itr));
+    if (itr->status == ProcessStatus::kBeforeStarted || itr->status == ProcessStatus::kBackingOff)
+      Erase(itr);
+    itr = next;
+  }
+}
+
+VaultStatus ProcessManager::GetStatus(const NonEmptyString& label) const {
+  auto itr(DoFind(label));
+  VaultStatus status;
+  switch (itr->status) {
+    case ProcessStatus::kBeforeStarted:
+    case ProcessStatus::kStarting:
+      status.state = VaultStatus::State::kStarting;
+      break;
+    case ProcessStatus::kRunning:
+      status.state = VaultStatus::State::kRunning;
+      break;
+    case ProcessStatus::kStopping:
+      status.state = VaultStatus::State::kStopping;
+      break;
+    case ProcessStatus::kBackingOff:
+      status.state = VaultStatus::State::kBackingOff;
+      status.time_until_restart = std::max(
+          std::chrono::milliseconds(0), std::chrono::duration_cast<std::chrono::milliseconds>(
+                                            itr->restart_time - std::chrono::steady_clock::now()));
+      break;
+  }
+  status.recent_failures =
+      static_cast<int>(itr->restart_budget.FailureScore(std::chrono::steady_clock::now()));
+  return status;
+}
+
+void ProcessManager::SetResourceLimits(const NonEmptyString& label,
+                                       const VaultResourceLimits& limits) {
+  auto itr(DoFind(label));
+  cgroups_.SetLimits(label, limits, itr->resource_limits);
+  itr->resource_limits = limits;
+}
+
+std::vector<VaultResourceSample> ProcessManager::GetResourceUsage(
+    const NonEmptyString& label) const {
+  auto itr(DoFind(label));
+  return std::vector<VaultResourceSample>(std::begin(itr->resource_samples),
+                                          std::end(itr->resource_samples));
+}
+
+RetainedVaultState ProcessManager::GetRetainedState(const NonEmptyString& label) const {
+  auto itr(DoFind(label));
+  RetainedVaultState retained_state;
+  retained_state.resource_limits = itr->resource_limits;
+  retained_state.resource_samples = GetResourceUsage(label);
+  retained_state.restart_budget = itr->restart_budget;
+  return retained_state;
 }
 
 }  // namespace vault_manager
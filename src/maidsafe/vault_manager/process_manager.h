@@ -19,19 +19,28 @@
 #ifndef MAIDSAFE_VAULT_MANAGER_PROCESS_MANAGER_H_
 #define MAIDSAFE_VAULT_MANAGER_PROCESS_MANAGER_H_
 
+#include <chrono>
+#include <cstddef>
+#include <deque>
 #include <functional>
 #include <future>
+#include <list>
 #include <memory>
-#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "asio/io_service.hpp"
+#include "asio/io_service_strand.hpp"
 #ifdef MAIDSAFE_WIN32
 #include "asio/windows/object_handle.hpp"
 #else
 #include "asio/signal_set.hpp"
 #endif
+#ifdef MAIDSAFE_LINUX
+#include "asio/posix/stream_descriptor.hpp"
+#endif
+#include "boost/circular_buffer.hpp"
 #include "boost/filesystem/path.hpp"
 #include "boost/process/child.hpp"
 
@@ -41,7 +50,14 @@
 #include "maidsafe/passport/types.h"
 
 #include "maidsafe/vault_manager/config.h"
+#include "maidsafe/vault_manager/launcher.h"
+#include "maidsafe/vault_manager/placement_engine.h"
+#include "maidsafe/vault_manager/restart_budget.h"
+#include "maidsafe/vault_manager/vault_cgroups.h"
 #include "maidsafe/vault_manager/vault_info.h"
+#include "maidsafe/vault_manager/vault_resource_limits.h"
+#include "maidsafe/vault_manager/vault_resource_sample.h"
+#include "maidsafe/vault_manager/vault_status.h"
 
 namespace maidsafe {
 
@@ -49,50 +65,124 @@ namespace vault_manager {
 
 typedef uint64_t ProcessId;
 
-enum class ProcessStatus { kBeforeStarted, kStarting, kRunning, kStopping };
+// kBackingOff means the vault exited unexpectedly and is waiting to be restarted.
+enum class ProcessStatus { kBeforeStarted, kStarting, kRunning, kStopping, kBackingOff };
+
+// The state of a vault which outlives its process.  Passing it back to AddProcess re-adds a vault
+// which has been stopped without resetting its resource limits, samples or restart budget.
+struct RetainedVaultState {
+  RetainedVaultState();
+  VaultResourceLimits resource_limits;
+  std::vector<VaultResourceSample> resource_samples;
+  RestartBudget restart_budget;
+};
 
 // All functions provide the strong exception guarantee.
 class ProcessManager {
  public:
   typedef std::function<void(maidsafe_error, int)> OnExitFunctor;
+  // Called with the number of vaults stopped so far and the total being stopped.
+  typedef std::function<void(std::size_t, std::size_t)> StopProgressFunctor;
 
   ProcessManager(const ProcessManager&) = delete;
   ProcessManager(ProcessManager&&) = delete;
   ProcessManager& operator=(ProcessManager) = delete;
 
-  static std::shared_ptr<ProcessManager> MakeShared(asio::io_service& io_service,
+  // All handlers are run via 'strand', on which all public functions must also be called.
+  static std::shared_ptr<ProcessManager> MakeShared(asio::io_service::strand& strand,
                                                     boost::filesystem::path vault_executable_path,
                                                     tcp::Port listening_port);
   ~ProcessManager();
-  void StopAll();
-  void StopAllWithInterval();
+  // Asks every vault to stop, without blocking.  At most 'max_concurrent_stops' vaults are stopping
+  // at any time, and consecutive shutdowns are started at least 'interval' apart, so the vaults
+  // don't all leave the network at once.  Vaults which are queued to start or backing off are
+  // simply removed.  'on_progress' is invoked on the strand as each vault exits.  The returned
+  // future becomes ready once all vaults have exited.  Further calls return the same future.
+  std::shared_future<void> StopAll(std::size_t max_concurrent_stops = kMaxConcurrentVaultStops,
+                                   std::chrono::milliseconds interval = kVaultStopInterval,
+                                   StopProgressFunctor on_progress = nullptr);
   std::vector<VaultInfo> GetAll() const;
-  void AddProcess(VaultInfo info, int restart_count = 0);
+  // At most kMaxConcurrentStarts_ processes are starting (i.e. launched but not yet connected) at
+  // once.  Beyond that, new processes are queued and launched as earlier ones connect or exit, so
+  // that restoring many vaults at once doesn't swamp the machine.
+  //
+  // A process which exits unexpectedly isn't removed, but is restarted after a delay which grows
+  // with its recent failures (see kMaxVaultRestarts).
+  //
+  // The vault is placed on a NUMA node (keeping 'info.numa_node' if that's still valid), and is
+  // pinned to it every time it's started.  Returns 'info' updated with its placement, which should
+  // be persisted.
+  VaultInfo AddProcess(VaultInfo info,
+                       const RetainedVaultState& retained_state = RetainedVaultState());
   VaultInfo HandleVaultStarted(tcp::ConnectionPtr connection, ProcessId process_id);
+  // Once running, a vault which misses heartbeats is warned about, then asked to stop, then
+  // terminated and restarted (see kVaultHeartbeatInterval).  Throws if 'connection' isn't a
+  // vault's.
+  void HandleHeartbeat(tcp::ConnectionPtr connection, uint64_t sequence, uint64_t progress);
   void AssignOwner(const NonEmptyString& label, const passport::PublicMaid::Name& owner_name,
                    DiskUsage max_disk_usage);
+  // Records that the vault has switched to 'vault_dir' without restarting.  Throws if another vault
+  // uses 'vault_dir'.
+  void SetVaultDir(const NonEmptyString& label, const boost::filesystem::path& vault_dir);
   void StopProcess(tcp::ConnectionPtr connection, OnExitFunctor on_exit_functor = nullptr);
   // Returns false if the process doesn't exist.
   bool HandleConnectionClosed(tcp::ConnectionPtr connection);
   VaultInfo Find(const NonEmptyString& label) const;
   VaultInfo Find(tcp::ConnectionPtr connection) const;
+  VaultStatus GetStatus(const NonEmptyString& label) const;
+  // Each vault starts with the default limits (see kDefaultVaultCpuWeight), which are kept across
+  // restarts.  New limits take effect immediately, without restarting the vault.
+  void SetResourceLimits(const NonEmptyString& label, const VaultResourceLimits& limits);
+  // Returns up to kResourceSampleCount of the vault's most recent resource usage samples, oldest
+  // first.  Samples are kept across restarts of the vault.
+  std::vector<VaultResourceSample> GetResourceUsage(const NonEmptyString& label) const;
+  RetainedVaultState GetRetainedState(const NonEmptyString& label) const;
 
  private:
-  ProcessManager(asio::io_service& io_service, boost::filesystem::path vault_executable_path,
+  ProcessManager(asio::io_service::strand& strand, boost::filesystem::path vault_executable_path,
                  tcp::Port listening_port);
 
+  struct Shutdown {
+    Shutdown(asio::io_service& io_service, std::size_t max_concurrent_stops_in,
+             std::chrono::milliseconds interval_in, StopProgressFunctor on_progress_in);
+    const std::size_t max_concurrent_stops;
+    const std::chrono::milliseconds interval;
+    StopProgressFunctor on_progress;
+    std::deque<NonEmptyString> queue;
+    std::size_t stopped_count, total;
+    std::chrono::steady_clock::time_point next_stop_time;
+    Timer pacing_timer;
+    bool pacing_timer_armed;
+    std::promise<void> all_stopped;
+    std::shared_future<void> all_stopped_future;
+  };
+
+  // How far the response to a vault's missed heartbeats has escalated.
+  enum class HeartbeatState { kHealthy, kWarned, kShutdownRequested };
+
   struct Child {
-    Child(VaultInfo info, asio::io_service& io_service, int restarts);
+    Child(VaultInfo info, asio::io_service& io_service);
     Child(Child&& other);
     Child& operator=(Child other);
     VaultInfo info;
     OnExitFunctor on_exit;
     std::unique_ptr<Timer> timer;
-    int restart_count;
+    RestartBudget restart_budget;
+    std::chrono::steady_clock::time_point restart_time;
     std::vector<std::string> process_args;
+    VaultResourceLimits resource_limits;
+    boost::circular_buffer<VaultResourceSample> resource_samples;
+    std::chrono::steady_clock::time_point last_heartbeat;
+    uint64_t heartbeat_progress;
+    HeartbeatState heartbeat_state;
     ProcessStatus status;
 #ifdef MAIDSAFE_WIN32
     asio::windows::object_handle handle;
+#endif
+#ifdef MAIDSAFE_LINUX
+    // A pidfd for the child, registered with the reactor.  Null if the kernel doesn't support
+    // pidfd_open, in which case exits are only detected via SIGCHLD.
+    std::unique_ptr<asio::posix::stream_descriptor> exit_watcher;
 #endif
     boost::process::child process;
 
@@ -101,28 +191,76 @@ class ProcessManager {
   };
   friend void swap(Child& lhs, Child& rhs);
 
-  void StartProcess(std::vector<Child>::iterator itr);
+  // Children are held in a list so that iterators remain valid handles for as long as the child
+  // exists.  Each index maps a unique key of the child to its handle, giving O(1) lookups.
+  typedef std::list<Child>::iterator ChildItr;
+  typedef std::list<Child>::const_iterator ChildConstItr;
+  typedef std::unordered_map<std::string, ChildItr> StringIndex;
+
+  void StartProcess(ChildItr itr);
+  void LaunchQueuedProcesses();
+  void RequestStop(ChildItr itr, OnExitFunctor on_exit_functor);
+  // Starts as many queued shutdowns as the StopAll limits allow.
+  void StopQueuedProcesses();
+  void HandleStopAllProgress();
+  // Keeps 'starting_count_' and 'stopping_count_' in step with children's statuses.
+  void SetStatus(ChildItr itr, ProcessStatus status);
   void InitSignalHandler();
+  void WatchForExit(ChildItr itr);
+  // Reaps every child which has exited, since several SIGCHLDs can be coalesced into one.
+  void ReapExitedChildren();
+  void ReapChild(ProcessId process_id);
+  void OnChildReaped(ProcessId process_id, int status);
+  // Samples every live vault's resource usage each kResourceSampleInterval until StopAll completes.
+  void ScheduleResourceSampling();
+  void SampleResourceUsageOfAll();
+  // Checks every running vault's heartbeat deadlines each kVaultHeartbeatInterval until StopAll
+  // completes.
+  void ScheduleHeartbeatCheck();
+  void CheckHeartbeats();
+
+  void CheckNewVaultDoesntConflict(const VaultInfo& new_vault) const;
+  void AddToIndices(ChildItr itr);
+  void SetConnection(ChildItr itr, tcp::ConnectionPtr connection);
+  void Erase(ChildItr itr);
 
-  std::vector<Child>::const_iterator DoFind(const NonEmptyString& label) const;
-  std::vector<Child>::iterator DoFind(const NonEmptyString& label);
-  std::vector<Child>::const_iterator DoFind(tcp::ConnectionPtr connection) const;
-  std::vector<Child>::iterator DoFind(tcp::ConnectionPtr connection);
+  ChildConstItr DoFind(const NonEmptyString& label) const;
+  ChildItr DoFind(const NonEmptyString& label);
+  ChildConstItr DoFind(tcp::ConnectionPtr connection) const;
+  ChildItr DoFind(tcp::ConnectionPtr connection);
+  ChildItr DoFind(ProcessId process_id);
   ProcessId GetProcessId(const Child& vault) const;
   bool IsRunning(const Child& vault) const;
   void OnProcessExit(const NonEmptyString& label, int exit_code, bool terminate = false);
-  void TerminateProcess(std::vector<Child>::iterator itr);
+  void TerminateProcess(ChildItr itr);
   void InvokeOnExitFunctor(OnExitFunctor on_exit, int exit_code, bool terminate);
-  void RestartIfRequired(int restart_count, VaultInfo vault_info);
+  // Detaches the exited process from 'itr' and schedules a restart.
+  void ScheduleRestart(ChildItr itr);
+  // Removes children which have no process, i.e. those queued for launch or backing off.
+  void EraseUnstarted();
 
+  asio::io_service::strand& strand_;
   asio::io_service& io_service_;
 #ifndef MAIDSAFE_WIN32
   asio::signal_set signal_set_;
 #endif
-  std::once_flag stop_all_flag_;
+  Timer resource_sample_timer_, heartbeat_timer_;
+  // Non-null once StopAll has been called.
+  std::unique_ptr<Shutdown> shutdown_;
   const tcp::Port kListeningPort_;
   const boost::filesystem::path kVaultExecutablePath_;
-  std::vector<Child> vaults_;
+  VaultCgroups cgroups_;
+  PlacementEngine placement_;
+#ifndef MAIDSAFE_WIN32
+  std::unique_ptr<Launcher> launcher_;
+#endif
+  std::list<Child> vaults_;
+  StringIndex label_index_, pmid_index_, vault_dir_index_;
+  std::unordered_map<const tcp::Connection*, ChildItr> connection_index_;
+  std::unordered_map<ProcessId, ChildItr> process_id_index_;
+  const std::size_t kMaxConcurrentStarts_;
+  std::deque<ChildItr> launch_queue_;
+  std::size_t starting_count_, stopping_count_;
 };
 
 }  // namespace vault_manager
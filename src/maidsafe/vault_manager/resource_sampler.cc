@@ -0,0 +1,116 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/resource_sampler.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef MAIDSAFE_LINUX
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+#ifdef MAIDSAFE_LINUX
+
+// Returns the value following 'key' on the first line starting with it, e.g. for "VmRSS:".
+bool ReadField(const std::string& path, const std::string& key, uint64_t& value) {
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.compare(0, key.size(), key) == 0) {
+      std::istringstream field{line.substr(key.size())};
+      return static_cast<bool>(field >> value);
+    }
+  }
+  return false;
+}
+
+bool ReadCpuTime(const std::string& proc_dir, std::chrono::milliseconds& cpu_time) {
+  std::ifstream file(proc_dir + "/stat");
+  std::string content;
+  if (!std::getline(file, content))
+    return false;
+  // The command name (field 2) is in parentheses and may contain spaces, so parse from after it.
+  std::size_t name_end{content.rfind(')')};
+  if (name_end == std::string::npos)
+    return false;
+  std::istringstream fields{content.substr(name_end + 1)};
+  // Skip fields 3 to 13 to reach utime (14) and stime (15).
+  std::string skipped;
+  for (int i(3); i <= 13; ++i)
+    fields >> skipped;
+  uint64_t user_ticks(0), system_ticks(0);
+  if (!(fields >> user_ticks >> system_ticks))
+    return false;
+  static const long kTicksPerSecond{sysconf(_SC_CLK_TCK)};
+  cpu_time = std::chrono::milliseconds((user_ticks + system_ticks) * 1000 /
+                                       static_cast<uint64_t>(kTicksPerSecond > 0 ? kTicksPerSecond
+                                                                                 : 100));
+  return true;
+}
+
+uint32_t CountOpenFiles(const std::string& proc_dir) {
+  DIR* fd_dir{opendir((proc_dir + "/fd").c_str())};
+  if (!fd_dir)
+    return 0;
+  uint32_t count(0);
+  while (dirent* entry = readdir(fd_dir)) {
+    if (entry->d_name[0] != '.')
+      ++count;
+  }
+  closedir(fd_dir);
+  return count;
+}
+
+#endif
+
+}  // unnamed namespace
+
+boost::optional<VaultResourceSample> SampleResourceUsage(process::ProcessId process_id) {
+#ifdef MAIDSAFE_LINUX
+  std::string proc_dir{"/proc/" + std::to_string(process_id)};
+  VaultResourceSample sample;
+  if (!ReadCpuTime(proc_dir, sample.cpu_time))
+    return boost::none;
+  sample.time = std::chrono::system_clock::now();
+  sample.process_id = process_id;
+  uint64_t resident_kilobytes(0);
+  if (ReadField(proc_dir + "/status", "VmRSS:", resident_kilobytes))
+    sample.resident_bytes = resident_kilobytes * 1024;
+  // /proc/<pid>/io is only readable by the process's owner, which the manager normally is.
+  ReadField(proc_dir + "/io", "read_bytes:", sample.read_bytes);
+  ReadField(proc_dir + "/io", "write_bytes:", sample.write_bytes);
+  sample.open_files = CountOpenFiles(proc_dir);
+  return sample;
+#else
+  static_cast<void>(process_id);
+  return boost::none;
+#endif
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
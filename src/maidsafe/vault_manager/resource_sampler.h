@@ -0,0 +1,41 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_RESOURCE_SAMPLER_H_
+#define MAIDSAFE_VAULT_MANAGER_RESOURCE_SAMPLER_H_
+
+#include "boost/optional.hpp"
+
+#include "maidsafe/common/process.h"
+
+#include "maidsafe/vault_manager/vault_resource_sample.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Reads the process's current resource usage from /proc/<pid>/{stat,status,io,fd}.  Returns none if
+// the process doesn't exist or on platforms other than Linux.  Each call only reads a few small
+// in-memory files, so it's cheap enough to run on the event loop.
+boost::optional<VaultResourceSample> SampleResourceUsage(process::ProcessId process_id);
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_RESOURCE_SAMPLER_H_
@@ -0,0 +1,63 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault_manager/restart_budget.h"
+
+#include <cmath>
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+std::chrono::milliseconds RestartBudget::RecordFailure(std::chrono::steady_clock::time_point now,
+                                                       uint32_t random) {
+  failure_score = FailureScore(now) + 1.0;
+  last_failure = now;
+  int64_t half_delay{RestartDelay(failure_score).count() / 2};
+  return std::chrono::milliseconds(half_delay + random % (half_delay + 1));
+}
+
+double RestartBudget::FailureScore(std::chrono::steady_clock::time_point now) const {
+  if (failure_score == 0.0)
+    return 0.0;
+  std::chrono::duration<double> elapsed{now - last_failure};
+  std::chrono::duration<double> half_life{kRestartBudgetHalfLife};
+  return failure_score * std::pow(0.5, elapsed / half_life);
+}
+
+std::chrono::milliseconds RestartDelay(double failure_score) {
+  // The first failure in a while is restarted immediately.
+  if (failure_score < 2.0)
+    return std::chrono::milliseconds(0);
+
+  std::chrono::milliseconds delay{kMaxRestartDelay};
+  if (failure_score <= kMaxVaultRestarts) {
+    double backoff{std::pow(2.0, std::floor(failure_score) - 2.0)};
+    if (backoff * kInitialRestartDelay.count() < kMaxRestartDelay.count())
+      delay = std::chrono::milliseconds(
+          static_cast<int64_t>(backoff * kInitialRestartDelay.count()));
+  }
+  return delay;
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
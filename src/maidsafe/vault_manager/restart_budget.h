@@ -0,0 +1,52 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_MANAGER_RESTART_BUDGET_H_
+#define MAIDSAFE_VAULT_MANAGER_RESTART_BUDGET_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Tracks a vault's unexpected exits.  Each exit adds one to 'failure_score', which then halves
+// every kRestartBudgetHalfLife.  Times are passed in so that the decay can be tested.
+struct RestartBudget {
+  RestartBudget() : failure_score(0.0), last_failure() {}
+  // Records an exit at 'now' and returns the delay before the vault should be restarted.  That's
+  // picked from [RestartDelay / 2, RestartDelay] using 'random', so that vaults which failed
+  // together don't all restart together.
+  std::chrono::milliseconds RecordFailure(std::chrono::steady_clock::time_point now,
+                                          uint32_t random);
+  // The score at 'now', allowing for decay since the last failure.
+  double FailureScore(std::chrono::steady_clock::time_point now) const;
+  double failure_score;
+  std::chrono::steady_clock::time_point last_failure;
+};
+
+// The longest delay before restarting a vault with the given (just incremented) failure score.
+std::chrono::milliseconds RestartDelay(double failure_score);
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_RESTART_BUDGET_H_
@@ -19,22 +19,17 @@
 #ifndef MAIDSAFE_VAULT_MANAGER_RPC_HELPER_H_
 #define MAIDSAFE_VAULT_MANAGER_RPC_HELPER_H_
 
-#include <functional>
+#include <chrono>
 #include <future>
-#include <memory>
 #include <mutex>
-#include <string>
+#include <system_error>
 
-#include "asio/error.hpp"
 #include "asio/io_service.hpp"
 #include "asio/steady_timer.hpp"
-#include "boost/exception/diagnostic_information.hpp"
 
 #include "maidsafe/common/error.h"
-#include "maidsafe/common/log.h"
 
 #include "maidsafe/vault_manager/config.h"
-#include "maidsafe/vault_manager/utils.h"
 
 namespace maidsafe {
 
@@ -42,6 +37,11 @@ namespace vault_manager {
 
 namespace detail {
 
+// A request's promise with a timer of its own.  This is only for the client's vault requests, which
+// can't be registered in RpcMultiplexer: they're matched to their response by vault label rather
+// than by correlation ID, since the response may come from a later operation (e.g. the vault
+// restarting), and each MoveChunkstoreProgress restarts the timeout, which the multiplexer's
+// timeout wheel doesn't allow.  There's at most one per vault, so a timer each is cheap.
 template <typename ResultType, typename MessageType>
 struct PromiseAndTimer {
   PromiseAndTimer(asio::io_service& io_service,
@@ -73,40 +73,6 @@ struct PromiseAndTimer {
 
 }  // namespace detail
 
-template <typename ResultType, typename MessageType>
-std::future<ResultType> SetResponseCallback(std::function<void(MessageType&&)>& callback,
-                                            asio::io_service& io_service, std::mutex& mutex) {
-  auto promise_and_timer =
-      std::make_shared<detail::PromiseAndTimer<ResultType, MessageType>>(io_service);
-  {
-    std::lock_guard<std::mutex> lock{mutex};
-    auto callback_copy(callback);
-    callback = [=](MessageType&& message) {
-      try {
-        promise_and_timer->SetValue(detail::GetValue(message));
-      } catch (const std::exception& e) {
-        LOG(kError) << boost::diagnostic_information(e);
-        promise_and_timer->SetException(std::current_exception());
-      }
-      if (callback_copy)
-        callback_copy(std::move(message));
-      promise_and_timer->timer.cancel();
-    };
-  }
-  promise_and_timer->timer.async_wait([=, &callback, &mutex](const std::error_code& ec) {
-    if (ec && ec == asio::error::operation_aborted)
-      return;
-    std::lock_guard<std::mutex> lock{mutex};
-    if (callback)
-      callback = nullptr;
-    if (ec)
-      promise_and_timer->SetException(ec);
-    else
-      promise_and_timer->SetException(MakeError(VaultManagerErrors::timed_out));
-  });
-  return promise_and_timer->promise.get_future();
-}
-
 }  // namespace vault_manager
 
 }  // namespace maidsafe
@@ -0,0 +1,175 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault_manager/rpc_multiplexer.h"
+
+#include <system_error>
+
+#include "asio/error.hpp"
+
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+// With kRpcTimeoutResolution of 50ms, the wheel turns once every 3.2s.  Longer timeouts just go
+// round more than once.
+const std::size_t kWheelSize(64);
+
+uint64_t TicksUntil(std::chrono::steady_clock::duration timeout) {
+  auto ticks((timeout + kRpcTimeoutResolution - std::chrono::steady_clock::duration(1)) /
+             kRpcTimeoutResolution);
+  return ticks < 1 ? 1U : static_cast<uint64_t>(ticks);
+}
+
+std::exception_ptr Aborted() {
+  return std::make_exception_ptr(
+      std::system_error(make_error_code(asio::error::operation_aborted)));
+}
+
+}  // unnamed namespace
+
+RpcMultiplexer::RpcMultiplexer(asio::io_service& io_service)
+    : mutex_(),
+      timer_(io_service),
+      ticking_(false),
+      current_tick_(0),
+      next_correlation_id_(0),
+      pending_(),
+      wheel_(kWheelSize) {}
+
+std::shared_ptr<RpcMultiplexer> RpcMultiplexer::MakeShared(asio::io_service& io_service) {
+  return std::shared_ptr<RpcMultiplexer>{new RpcMultiplexer{io_service}};
+}
+
+RpcMultiplexer::~RpcMultiplexer() {
+  CancelAll();
+  std::error_code ignored_ec;
+  timer_.cancel(ignored_ec);
+}
+
+CorrelationId RpcMultiplexer::Insert(std::unique_ptr<detail::PendingRpcBase> rpc,
+                                     std::chrono::steady_clock::duration timeout) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  // 0 is reserved for messages which aren't part of an RPC.
+  do {
+    ++next_correlation_id_;
+  } while (next_correlation_id_ == 0 || pending_.count(next_correlation_id_) != 0);
+  uint64_t expiry_tick{current_tick_ + TicksUntil(timeout)};
+  pending_.emplace(next_correlation_id_, Entry{std::move(rpc), expiry_tick});
+  wheel_[expiry_tick % kWheelSize].push_back(next_correlation_id_);
+  if (!ticking_) {
+    ticking_ = true;
+    ScheduleTick();
+  }
+  return next_correlation_id_;
+}
+
+std::unique_ptr<detail::PendingRpcBase> RpcMultiplexer::Remove(CorrelationId correlation_id,
+                                                               const std::type_info* type) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto itr(pending_.find(correlation_id));
+  if (itr == std::end(pending_) || (type && typeid(*itr->second.rpc) != *type))
+    return nullptr;
+  std::unique_ptr<detail::PendingRpcBase> rpc{std::move(itr->second.rpc)};
+  pending_.erase(itr);
+  return rpc;
+}
+
+bool RpcMultiplexer::SetException(CorrelationId correlation_id, std::exception_ptr exception) {
+  std::unique_ptr<detail::PendingRpcBase> rpc{Remove(correlation_id)};
+  if (!rpc)
+    return false;
+  rpc->SetException(exception);
+  return true;
+}
+
+bool RpcMultiplexer::SetException(CorrelationId correlation_id, maidsafe_error error) {
+  return SetException(correlation_id, std::make_exception_ptr(error));
+}
+
+bool RpcMultiplexer::Cancel(CorrelationId correlation_id) {
+  return SetException(correlation_id, Aborted());
+}
+
+void RpcMultiplexer::CancelAll() {
+  std::unordered_map<CorrelationId, Entry> cancelled;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    cancelled.swap(pending_);
+  }
+  for (auto& entry : cancelled)
+    entry.second.rpc->SetException(Aborted());
+}
+
+std::size_t RpcMultiplexer::PendingCount() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return pending_.size();
+}
+
+void RpcMultiplexer::ScheduleTick() {
+  std::weak_ptr<RpcMultiplexer> this_weak_ptr{shared_from_this()};
+  timer_.expires_from_now(kRpcTimeoutResolution);
+  timer_.async_wait([this_weak_ptr](const std::error_code& error_code) {
+    if (error_code == asio::error::operation_aborted)
+      return;
+    if (std::shared_ptr<RpcMultiplexer> this_ptr{this_weak_ptr.lock()})
+      this_ptr->Tick();
+  });
+}
+
+void RpcMultiplexer::Tick() {
+  std::vector<std::unique_ptr<detail::PendingRpcBase>> expired;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    ++current_tick_;
+    std::vector<CorrelationId>& slot(wheel_[current_tick_ % kWheelSize]);
+    std::vector<CorrelationId> not_yet_due;
+    for (CorrelationId correlation_id : slot) {
+      auto itr(pending_.find(correlation_id));
+      if (itr == std::end(pending_))
+        continue;
+      if (itr->second.expiry_tick <= current_tick_) {
+        expired.push_back(std::move(itr->second.rpc));
+        pending_.erase(itr);
+      } else {
+        not_yet_due.push_back(correlation_id);
+      }
+    }
+    slot.swap(not_yet_due);
+    if (pending_.empty()) {
+      for (auto& ids : wheel_)
+        ids.clear();
+      ticking_ = false;
+    } else {
+      ScheduleTick();
+    }
+  }
+  if (!expired.empty())
+    LOG(kWarning) << expired.size() << " RPC(s) timed out.";
+  for (auto& rpc : expired)
+    rpc->SetException(std::make_exception_ptr(MakeError(VaultManagerErrors::timed_out)));
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -0,0 +1,133 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#ifndef MAIDSAFE_VAULT_MANAGER_RPC_MULTIPLEXER_H_
+#define MAIDSAFE_VAULT_MANAGER_RPC_MULTIPLEXER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "asio/io_service.hpp"
+
+#include "maidsafe/common/error.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace detail {
+
+struct PendingRpcBase {
+  virtual ~PendingRpcBase() {}
+  virtual void SetException(std::exception_ptr exception) = 0;
+};
+
+template <typename ResultType>
+struct PendingRpc : public PendingRpcBase {
+  void SetException(std::exception_ptr exception) override { promise.set_exception(exception); }
+  std::promise<ResultType> promise;
+};
+
+}  // namespace detail
+
+// Matches responses to requests by correlation ID.  Pending requests are kept in a flat table, and
+// their deadlines in a timeout wheel driven by a single timer which only runs while requests are
+// pending, so adding, completing, cancelling or timing out a request is O(1) however many are in
+// flight.  Requests time out to within kRpcTimeoutResolution.  Thread-safe.
+class RpcMultiplexer : public std::enable_shared_from_this<RpcMultiplexer> {
+ public:
+  static std::shared_ptr<RpcMultiplexer> MakeShared(asio::io_service& io_service);
+  // Fails any requests still pending with asio::error::operation_aborted.
+  ~RpcMultiplexer();
+
+  // Returns the ID to send with the request, and the future for its result.
+  template <typename ResultType>
+  std::pair<CorrelationId, std::future<ResultType>> Add(
+      std::chrono::steady_clock::duration timeout = kRpcTimeout);
+  // These return false if no request with 'correlation_id' is pending (e.g. it has timed out).
+  // SetValue also returns false, leaving the request pending, if it awaits a different ResultType.
+  template <typename ResultType>
+  bool SetValue(CorrelationId correlation_id, ResultType result);
+  bool SetException(CorrelationId correlation_id, std::exception_ptr exception);
+  bool SetException(CorrelationId correlation_id, maidsafe_error error);
+  // Fails the request with asio::error::operation_aborted.
+  bool Cancel(CorrelationId correlation_id);
+  void CancelAll();
+  std::size_t PendingCount() const;
+
+ private:
+  struct Entry {
+    std::unique_ptr<detail::PendingRpcBase> rpc;
+    uint64_t expiry_tick;
+  };
+
+  explicit RpcMultiplexer(asio::io_service& io_service);
+  CorrelationId Insert(std::unique_ptr<detail::PendingRpcBase> rpc,
+                       std::chrono::steady_clock::duration timeout);
+  // If 'type' is non-null, only removes the request if it's of that type.
+  std::unique_ptr<detail::PendingRpcBase> Remove(CorrelationId correlation_id,
+                                                 const std::type_info* type = nullptr);
+  void ScheduleTick();
+  void Tick();
+
+  mutable std::mutex mutex_;
+  Timer timer_;
+  bool ticking_;
+  uint64_t current_tick_;
+  CorrelationId next_correlation_id_;
+  std::unordered_map<CorrelationId, Entry> pending_;
+  // Slot 'n' holds the IDs of requests due to expire on a tick congruent to 'n'.  IDs of requests
+  // which have completed are dropped lazily when their slot is next visited.
+  std::vector<std::vector<CorrelationId>> wheel_;
+};
+
+template <typename ResultType>
+std::pair<CorrelationId, std::future<ResultType>> RpcMultiplexer::Add(
+    std::chrono::steady_clock::duration timeout) {
+  std::unique_ptr<detail::PendingRpc<ResultType>> rpc{new detail::PendingRpc<ResultType>};
+  std::future<ResultType> future{rpc->promise.get_future()};
+  CorrelationId correlation_id{Insert(std::move(rpc), timeout)};
+  return std::make_pair(correlation_id, std::move(future));
+}
+
+template <typename ResultType>
+bool RpcMultiplexer::SetValue(CorrelationId correlation_id, ResultType result) {
+  std::unique_ptr<detail::PendingRpcBase> rpc{
+      Remove(correlation_id, &typeid(detail::PendingRpc<ResultType>))};
+  if (!rpc)
+    return false;
+  static_cast<detail::PendingRpc<ResultType>*>(rpc.get())->promise.set_value(std::move(result));
+  return true;
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_RPC_MULTIPLEXER_H_
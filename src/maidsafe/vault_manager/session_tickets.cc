@@ -0,0 +1,143 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+#include "maidsafe/vault_manager/session_tickets.h"
+
+#include <chrono>
+#include <cstdint>
+
+#include "cryptopp/hmac.h"
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+// A ticket is the Maid name, the expiry time and a nonce, followed by their HMAC.
+const std::size_t kNameSize(crypto::SHA512::DIGESTSIZE);
+const std::size_t kExpirySize(8);
+const std::size_t kNonceSize(16);
+const std::size_t kBodySize(kNameSize + kExpirySize + kNonceSize);
+const std::size_t kMacSize(crypto::SHA512::DIGESTSIZE);
+
+// HMAC-SHA512.
+std::string Hmac(const std::string& key, const std::string& message) {
+  CryptoPP::HMAC<crypto::SHA512> hmac(reinterpret_cast<const unsigned char*>(key.data()),
+                                      key.size());
+  std::string mac(kMacSize, '\0');
+  hmac.CalculateDigest(reinterpret_cast<unsigned char*>(&mac[0]),
+                       reinterpret_cast<const unsigned char*>(message.data()), message.size());
+  return mac;
+}
+
+// Takes the same time whichever byte differs.
+bool SecureEqual(const std::string& lhs, const std::string& rhs) {
+  if (lhs.size() != rhs.size())
+    return false;
+  unsigned char difference(0);
+  for (std::size_t i(0); i != lhs.size(); ++i)
+    difference |= static_cast<unsigned char>(lhs[i] ^ rhs[i]);
+  return difference == 0;
+}
+
+int64_t MillisecondsSinceEpoch(std::chrono::system_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+std::string EncodeExpiry(int64_t expiry) {
+  std::string encoded(kExpirySize, '\0');
+  for (std::size_t i(0); i != kExpirySize; ++i)
+    encoded[kExpirySize - 1 - i] = static_cast<char>((static_cast<uint64_t>(expiry) >> (8 * i)));
+  return encoded;
+}
+
+int64_t DecodeExpiry(const std::string& encoded) {
+  uint64_t expiry(0);
+  for (std::size_t i(0); i != kExpirySize; ++i)
+    expiry = (expiry << 8) | static_cast<unsigned char>(encoded[i]);
+  return static_cast<int64_t>(expiry);
+}
+
+std::string Secret(const std::string& key, const std::string& body) {
+  return Hmac(key, "secret" + body);
+}
+
+std::string Mac(const std::string& key, const std::string& body) {
+  return Hmac(key, "ticket" + body);
+}
+
+}  // unnamed namespace
+
+SessionTickets::SessionTickets() : kKey_(RandomString(kMacSize)) {}
+
+SessionTicket SessionTickets::Issue(const MaidName& maid_name,
+                                    const crypto::AES256Key& session_key) const {
+  std::string body(maid_name.value.string() +
+                   EncodeExpiry(MillisecondsSinceEpoch(std::chrono::system_clock::now() +
+                                                       kSessionTicketLifetime)) +
+                   RandomString(kNonceSize));
+  return SessionTicket(body + Mac(kKey_, body), Secret(kKey_, body), session_key,
+                       static_cast<uint32_t>(kSessionTicketLifetime.count()));
+}
+
+SessionTickets::Redeemed SessionTickets::Redeem(const std::string& ticket,
+                                                const asymm::PlainText& challenge,
+                                                const std::string& proof) const {
+  if (ticket.size() != kBodySize + kMacSize) {
+    LOG(kWarning) << "Session ticket has wrong size.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+  std::string body(ticket.substr(0, kBodySize));
+  if (!SecureEqual(Mac(kKey_, body), ticket.substr(kBodySize))) {
+    LOG(kWarning) << "Session ticket wasn't issued by this VaultManager.";
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_signature));
+  }
+  if (DecodeExpiry(body.substr(kNameSize, kExpirySize)) <
+      MillisecondsSinceEpoch(std::chrono::system_clock::now())) {
+    LOG(kInfo) << "Session ticket has expired.";
+    BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::timed_out));
+  }
+  std::string secret(Secret(kKey_, body));
+  if (!SecureEqual(SessionProof(secret, challenge), proof)) {
+    LOG(kWarning) << "Session ticket presented with wrong proof.";
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_signature));
+  }
+  return Redeemed{MaidName{Identity{body.substr(0, kNameSize)}},
+                  ResumedSessionKey(secret, challenge)};
+}
+
+std::string SessionProof(const std::string& secret, const asymm::PlainText& challenge) {
+  return Hmac(secret, challenge.string());
+}
+
+crypto::AES256Key ResumedSessionKey(const std::string& secret, const asymm::PlainText& challenge) {
+  return crypto::AES256Key{Hmac(secret, "session key" + challenge.string())
+                               .substr(0, crypto::AES256_KeySize)};
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
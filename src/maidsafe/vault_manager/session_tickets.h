@@ -0,0 +1,70 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+#ifndef MAIDSAFE_VAULT_MANAGER_SESSION_TICKETS_H_
+#define MAIDSAFE_VAULT_MANAGER_SESSION_TICKETS_H_
+
+#include <string>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/passport/types.h"
+
+#include "maidsafe/vault_manager/messages/session_ticket.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Issues and redeems the tickets which let a client validate a new connection using only
+// symmetric-key work.  A ticket holds the client's Maid name and expiry time, authenticated with
+// an HMAC under a key known only to this object, so tickets don't outlive the VaultManager.  Each
+// ticket comes with a secret (derived from the same key) which the client uses to answer the new
+// connection's challenge, so a ticket alone can't be replayed.  The secret is sent encrypted under
+// the issuing connection's session key, and in turn yields the session key of the connection on
+// which the ticket is redeemed.  Thread-safe.
+class SessionTickets {
+ public:
+  typedef passport::PublicMaid::Name MaidName;
+
+  struct Redeemed {
+    MaidName maid_name;
+    crypto::AES256Key session_key;
+  };
+
+  SessionTickets();
+
+  SessionTicket Issue(const MaidName& maid_name, const crypto::AES256Key& session_key) const;
+  // Returns the Maid named in 'ticket' and the new connection's session key if this object issued
+  // 'ticket', it hasn't expired, and 'proof' is SessionProof(secret, challenge).  Throws otherwise.
+  Redeemed Redeem(const std::string& ticket, const asymm::PlainText& challenge,
+                  const std::string& proof) const;
+
+ private:
+  const std::string kKey_;
+};
+
+std::string SessionProof(const std::string& secret, const asymm::PlainText& challenge);
+
+// The session key of a connection validated with a ticket's 'secret' and its 'challenge'.
+crypto::AES256Key ResumedSessionKey(const std::string& secret, const asymm::PlainText& challenge);
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_SESSION_TICKETS_H_
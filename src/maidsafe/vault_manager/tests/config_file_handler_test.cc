@@ -0,0 +1,330 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault_manager/config_file_handler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+#include "maidsafe/passport/passport.h"
+
+#include "maidsafe/vault_manager/config.h"
+#include "maidsafe/vault_manager/config_file.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace test {
+
+namespace {
+
+// Generating keys is slow, so the vaults in these tests share them.
+VaultInfo MakeVault(std::shared_ptr<passport::PmidAndSigner> pmid_and_signer, int index) {
+  VaultInfo vault;
+  vault.pmid_and_signer = std::move(pmid_and_signer);
+  vault.label = NonEmptyString{"vault " + std::to_string(index)};
+  vault.vault_dir = fs::path{"vault_dir"} / std::to_string(index);
+  vault.max_disk_usage = DiskUsage{1000U + index};
+  return vault;
+}
+
+// Keyed by label.
+std::map<std::string, VaultInfo> ReadVaults(const fs::path& config_file_path) {
+  ConfigFileHandler config_file_handler{config_file_path};
+  std::map<std::string, VaultInfo> vaults;
+  for (auto& vault : config_file_handler.ReadConfigFile())
+    vaults.insert(std::make_pair(vault.label.string(), std::move(vault)));
+  return vaults;
+}
+
+// The config file layout from before it was versioned, i.e. without the vaults' NUMA nodes.
+struct UnversionedConfigFile {
+  template <typename Archive>
+  void save(Archive& archive) const {
+    archive(symm_key, symm_iv, vaults.size());
+    for (const auto& vault : vaults) {
+      archive(*EncryptVaultKeys(vault, symm_key, symm_iv), vault.vault_dir, vault.label,
+              vault.max_disk_usage, vault.owner_name->IsInitialised());
+      if (vault.owner_name->IsInitialised())
+        archive(vault.owner_name);
+    }
+  }
+
+  crypto::AES256Key symm_key;
+  crypto::AES256InitialisationVector symm_iv;
+  std::vector<VaultInfo> vaults;
+};
+
+fs::path JournalPath(const fs::path& config_file_path) {
+  fs::path journal_file_path{config_file_path};
+  journal_file_path += ".journal";
+  return journal_file_path;
+}
+
+// Counts the complete size-prefixed records in the journal.
+std::size_t CountJournalRecords(const fs::path& journal_file_path) {
+  std::string content{ReadFile(journal_file_path).string()};
+  std::size_t count{0}, offset{0};
+  while (content.size() - offset >= 4) {
+    uint32_t size{0};
+    for (std::size_t i(0); i < 4; ++i)
+      size = (size << 8) | static_cast<unsigned char>(content[offset + i]);
+    if (content.size() - offset - 4 < size)
+      break;
+    offset += 4 + size;
+    ++count;
+  }
+  return count;
+}
+
+}  // unnamed namespace
+
+TEST(ConfigFileHandlerTest, BEH_JournalReplay) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestConfigFile")};
+  fs::path config_file_path{*test_dir / kConfigFilename};
+  auto pmid_and_signer(std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner()));
+
+  // Start from a config file which already holds a vault.
+  crypto::AES256Key symm_key{RandomString(crypto::AES256_KeySize)};
+  crypto::AES256InitialisationVector symm_iv{RandomString(crypto::AES256_IVSize)};
+  ConfigFile base_config{symm_key, symm_iv, std::vector<VaultInfo>{MakeVault(pmid_and_signer, 0)}};
+  ASSERT_TRUE(WriteFile(config_file_path, ConvertToString(base_config)));
+
+  {
+    ConfigFileHandler config_file_handler{config_file_path};
+    EXPECT_EQ(symm_key, config_file_handler.SymmKey());
+    ASSERT_EQ(1U, config_file_handler.ReadConfigFile().size());
+    VaultInfo updated_vault{MakeVault(pmid_and_signer, 0)};
+    updated_vault.max_disk_usage = DiskUsage{1};
+    std::future<void> added{config_file_handler.AddVault(MakeVault(pmid_and_signer, 1))};
+    std::future<void> updated{config_file_handler.UpdateVault(updated_vault)};
+    EXPECT_NO_THROW(added.get());
+    EXPECT_NO_THROW(updated.get());
+  }
+
+  // The changes are only in the journal, and are replayed over the config file when it's read.
+  EXPECT_EQ(1U, ConvertFromString<ConfigFile>(ReadFile(config_file_path).string()).vaults.size());
+  EXPECT_TRUE(fs::exists(JournalPath(config_file_path)));
+  auto vaults(ReadVaults(config_file_path));
+  ASSERT_EQ(2U, vaults.size());
+  EXPECT_EQ(DiskUsage{1}, vaults["vault 0"].max_disk_usage);
+  EXPECT_EQ(DiskUsage{1001}, vaults["vault 1"].max_disk_usage);
+  EXPECT_EQ(fs::path{"vault_dir"} / "1", vaults["vault 1"].vault_dir);
+  ASSERT_TRUE(vaults["vault 1"].pmid_and_signer != nullptr);
+  EXPECT_EQ(pmid_and_signer->first.name(), vaults["vault 1"].pmid_and_signer->first.name());
+}
+
+TEST(ConfigFileHandlerTest, BEH_TornJournalTail) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestConfigFile")};
+  fs::path config_file_path{*test_dir / kConfigFilename};
+  auto pmid_and_signer(std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner()));
+  {
+    ConfigFileHandler config_file_handler{config_file_path};
+    for (int i(0); i < 3; ++i)
+      EXPECT_NO_THROW(config_file_handler.AddVault(MakeVault(pmid_and_signer, i)).get());
+  }
+
+  // Simulate a crash part way through appending the last record.
+  fs::path journal_file_path{JournalPath(config_file_path)};
+  fs::resize_file(journal_file_path, fs::file_size(journal_file_path) - 5);
+  {
+    ConfigFileHandler config_file_handler{config_file_path};
+    std::vector<VaultInfo> vaults{config_file_handler.ReadConfigFile()};
+    EXPECT_EQ(2U, vaults.size());
+    // The torn record must have been cut off, or this would be lost behind it.
+    EXPECT_NO_THROW(config_file_handler.AddVault(MakeVault(pmid_and_signer, 3)).get());
+  }
+
+  auto vaults(ReadVaults(config_file_path));
+  EXPECT_EQ(3U, vaults.size());
+  EXPECT_EQ(1U, vaults.count("vault 0"));
+  EXPECT_EQ(1U, vaults.count("vault 1"));
+  EXPECT_EQ(0U, vaults.count("vault 2"));
+  EXPECT_EQ(1U, vaults.count("vault 3"));
+}
+
+TEST(ConfigFileHandlerTest, BEH_Compaction) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestConfigFile")};
+  fs::path config_file_path{*test_dir / kConfigFilename};
+  auto pmid_and_signer(std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner()));
+  VaultInfo vault{MakeVault(pmid_and_signer, 0)};
+  const uint64_t kUpdateCount(kMaxConfigJournalRecords + 2);
+  {
+    // One record more than the limit allows for a single vault.
+    ConfigFileHandler config_file_handler{config_file_path};
+    std::vector<std::future<void>> committed;
+    for (uint64_t i(1); i <= kUpdateCount; ++i) {
+      vault.max_disk_usage = DiskUsage{i};
+      committed.push_back(config_file_handler.UpdateVault(vault));
+    }
+    for (auto& change_committed : committed)
+      EXPECT_NO_THROW(change_committed.get());
+  }
+
+  // Compaction rewrites the config file with the current vaults and clears the journal.
+  boost::system::error_code error_code;
+  EXPECT_TRUE(!fs::exists(JournalPath(config_file_path), error_code) ||
+              fs::file_size(JournalPath(config_file_path), error_code) == 0);
+  ConfigFile config{ConvertFromString<ConfigFile>(ReadFile(config_file_path).string())};
+  ASSERT_EQ(1U, config.vaults.size());
+  EXPECT_EQ(DiskUsage{kUpdateCount}, config.vaults.front().max_disk_usage);
+  auto vaults(ReadVaults(config_file_path));
+  ASSERT_EQ(1U, vaults.size());
+  EXPECT_EQ(DiskUsage{kUpdateCount}, vaults["vault 0"].max_disk_usage);
+}
+
+TEST(ConfigFileHandlerTest, BEH_LoadUnversionedConfigFile) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestConfigFile")};
+  fs::path config_file_path{*test_dir / kConfigFilename};
+  auto pmid_and_signer(std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner()));
+  passport::PublicMaid::Name owner_name{Identity{RandomString(64)}};
+
+  UnversionedConfigFile old_config{crypto::AES256Key{RandomString(crypto::AES256_KeySize)},
+                                   crypto::AES256InitialisationVector{
+                                       RandomString(crypto::AES256_IVSize)},
+                                   std::vector<VaultInfo>{MakeVault(pmid_and_signer, 0),
+                                                          MakeVault(pmid_and_signer, 1)}};
+  old_config.vaults[1].owner_name = owner_name;
+  ASSERT_TRUE(WriteFile(config_file_path, ConvertToString(old_config)));
+
+  auto vaults(ReadVaults(config_file_path));
+  ASSERT_EQ(2U, vaults.size());
+  EXPECT_EQ(DiskUsage{1000}, vaults["vault 0"].max_disk_usage);
+  EXPECT_FALSE(vaults["vault 0"].owner_name->IsInitialised());
+  EXPECT_EQ(owner_name, vaults["vault 1"].owner_name);
+  EXPECT_EQ(fs::path{"vault_dir"} / "1", vaults["vault 1"].vault_dir);
+  // Vaults from before NUMA placement are unplaced.
+  EXPECT_EQ(-1, vaults["vault 0"].numa_node);
+  EXPECT_EQ(-1, vaults["vault 1"].numa_node);
+  ASSERT_TRUE(vaults["vault 1"].pmid_and_signer != nullptr);
+  EXPECT_EQ(pmid_and_signer->first.name(), vaults["vault 1"].pmid_and_signer->first.name());
+}
+
+TEST(ConfigFileHandlerTest, BEH_RoundTripVersion2ConfigFile) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestConfigFile")};
+  fs::path config_file_path{*test_dir / kConfigFilename};
+  auto pmid_and_signer(std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner()));
+  passport::PublicMaid::Name owner_name{Identity{RandomString(64)}};
+
+  VaultInfo placed_vault{MakeVault(pmid_and_signer, 0)};
+  placed_vault.numa_node = 1;
+  placed_vault.owner_name = owner_name;
+  ConfigFile config{crypto::AES256Key{RandomString(crypto::AES256_KeySize)},
+                    crypto::AES256InitialisationVector{RandomString(crypto::AES256_IVSize)},
+                    std::vector<VaultInfo>{placed_vault, MakeVault(pmid_and_signer, 1)}};
+  ASSERT_TRUE(WriteFile(config_file_path, ConvertToString(config)));
+
+  {
+    ConfigFileHandler config_file_handler{config_file_path};
+    std::vector<VaultInfo> vaults{config_file_handler.ReadConfigFile()};
+    ASSERT_EQ(2U, vaults.size());
+    // A journal record carries the NUMA node too.
+    VaultInfo moved_vault{MakeVault(pmid_and_signer, 1)};
+    moved_vault.numa_node = 0;
+    EXPECT_NO_THROW(config_file_handler.UpdateVault(moved_vault).get());
+  }
+
+  auto vaults(ReadVaults(config_file_path));
+  ASSERT_EQ(2U, vaults.size());
+  EXPECT_EQ(1, vaults["vault 0"].numa_node);
+  EXPECT_EQ(owner_name, vaults["vault 0"].owner_name);
+  EXPECT_EQ(DiskUsage{1000}, vaults["vault 0"].max_disk_usage);
+  EXPECT_EQ(0, vaults["vault 1"].numa_node);
+  EXPECT_FALSE(vaults["vault 1"].owner_name->IsInitialised());
+}
+
+TEST(ConfigFileHandlerTest, BEH_CoalesceQueuedChanges) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestConfigFile")};
+  fs::path config_file_path{*test_dir / kConfigFilename};
+  auto pmid_and_signer(std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner()));
+  ConfigFileHandler config_file_handler{config_file_path};
+
+  // Changes queued within kConfigWriteCoalescingWindow of each other are appended together, so all
+  // are on disk by the time the first is reported committed.
+  std::vector<std::future<void>> committed;
+  for (int i(0); i < 3; ++i)
+    committed.push_back(config_file_handler.AddVault(MakeVault(pmid_and_signer, i)));
+  EXPECT_NO_THROW(committed.front().get());
+  EXPECT_EQ(3U, CountJournalRecords(JournalPath(config_file_path)));
+  for (std::size_t i(1); i < committed.size(); ++i)
+    EXPECT_NO_THROW(committed[i].get());
+}
+
+TEST(ConfigFileHandlerTest, BEH_FailedWrite) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestConfigFile")};
+  fs::path config_file_path{*test_dir / kConfigFilename};
+  auto pmid_and_signer(std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner()));
+  ConfigFileHandler config_file_handler{config_file_path};
+
+  // Appending fails while a directory is in the journal's place.  Each change in the batch must
+  // get the error.
+  fs::path journal_file_path{JournalPath(config_file_path)};
+  fs::remove(journal_file_path);
+  ASSERT_TRUE(fs::create_directory(journal_file_path));
+  std::vector<std::future<void>> committed;
+  for (int i(0); i < 3; ++i)
+    committed.push_back(config_file_handler.AddVault(MakeVault(pmid_and_signer, i)));
+  committed.push_back(config_file_handler.UpdateVaults(
+      std::vector<VaultInfo>{MakeVault(pmid_and_signer, 3), MakeVault(pmid_and_signer, 4)}));
+  for (auto& change_committed : committed)
+    EXPECT_THROW(change_committed.get(), maidsafe_error);
+
+  // Nothing was recorded as committed, and later changes succeed once the journal is writable.
+  fs::remove(journal_file_path);
+  EXPECT_NO_THROW(config_file_handler.AddVault(MakeVault(pmid_and_signer, 5)).get());
+  EXPECT_EQ(1U, CountJournalRecords(journal_file_path));
+}
+
+TEST(ConfigFileHandlerTest, BEH_DestructorFlushesQueuedChanges) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestConfigFile")};
+  fs::path config_file_path{*test_dir / kConfigFilename};
+  auto pmid_and_signer(std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner()));
+  std::vector<std::future<void>> committed;
+  {
+    ConfigFileHandler config_file_handler{config_file_path};
+    for (int i(0); i < 3; ++i)
+      committed.push_back(config_file_handler.AddVault(MakeVault(pmid_and_signer, i)));
+  }
+
+  for (auto& change_committed : committed) {
+    ASSERT_EQ(std::future_status::ready, change_committed.wait_for(std::chrono::seconds(0)));
+    EXPECT_NO_THROW(change_committed.get());
+  }
+  EXPECT_EQ(3U, ReadVaults(config_file_path).size());
+}
+
+}  // namespace test
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -0,0 +1,133 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/directory_sync.h"
+
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace test {
+
+namespace {
+
+void WriteFile(const fs::path& path, const std::string& content) {
+  fs::create_directories(path.parent_path());
+  std::ofstream(path.string(), std::ios::binary | std::ios::trunc) << content;
+}
+
+std::string ReadFile(const fs::path& path) {
+  std::ifstream file(path.string(), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Files modified just before a sync are copied again by the next, so tests of what the next sync
+// skips must use files modified well before.
+void Backdate(const fs::path& path) {
+  fs::last_write_time(path, std::time(nullptr) - 3600);
+}
+
+}  // unnamed namespace
+
+TEST(DirectorySyncTest, BEH_SyncTwice) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestDirectorySync")};
+  fs::path source{*test_dir / "source"}, target{*test_dir / "target"};
+  const std::string kLarge(3 * (1 << 20) + 7, 'x');
+  WriteFile(source / "a" / "1", "one");
+  WriteFile(source / "b" / "c" / "2", kLarge);
+  Backdate(source / "a" / "1");
+  Backdate(source / "b" / "c" / "2");
+  WriteFile(target / "stale", "stale");
+
+  uint64_t last_done(0), last_total(0);
+  EXPECT_TRUE(SyncDirectory(source, target, 0, [&](uint64_t done, uint64_t total) {
+    last_done = done;
+    last_total = total;
+    return true;
+  }));
+  EXPECT_EQ(kLarge.size() + 3, last_total);
+  EXPECT_EQ(last_total, last_done);
+  EXPECT_EQ("one", ReadFile(target / "a" / "1"));
+  EXPECT_EQ(kLarge, ReadFile(target / "b" / "c" / "2"));
+  EXPECT_FALSE(fs::exists(target / "stale"));
+
+  // The second pass only copies what changed, and removes what was removed.
+  fs::remove_all(source / "a");
+  WriteFile(source / "d" / "3", "three");
+  EXPECT_TRUE(SyncDirectory(source, target, 0, [&](uint64_t, uint64_t total) {
+    last_total = total;
+    return true;
+  }));
+  EXPECT_EQ(5U, last_total);
+  EXPECT_FALSE(fs::exists(target / "a"));
+  EXPECT_EQ("three", ReadFile(target / "d" / "3"));
+  EXPECT_EQ(kLarge, ReadFile(target / "b" / "c" / "2"));
+
+  // Cancelling leaves no partial files behind.
+  WriteFile(source / "b" / "c" / "2", kLarge + kLarge);
+  EXPECT_FALSE(SyncDirectory(source, target, 0,
+                             [](uint64_t done, uint64_t) { return done == 0; }));
+  EXPECT_FALSE(fs::exists(target / "b" / "c" / "2.partial"));
+}
+
+TEST(DirectorySyncTest, BEH_RewriteDuringSync) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestDirectorySync")};
+  fs::path source{*test_dir / "source"}, target{*test_dir / "target"};
+  WriteFile(source / "1", "before");
+  EXPECT_TRUE(SyncDirectory(source, target, 0, nullptr));
+  // Rewritten in place, with the same size and (at one-second resolution) the same time.
+  WriteFile(source / "1", "after!");
+  EXPECT_TRUE(SyncDirectory(source, target, 0, nullptr));
+  EXPECT_EQ("after!", ReadFile(target / "1"));
+}
+
+TEST(DirectorySyncTest, BEH_OverlappingDirectories) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestDirectorySync")};
+  fs::path old_dir{*test_dir / "v1"};
+  WriteFile(old_dir / "1", "one");
+  EXPECT_TRUE(DirectoriesOverlap(old_dir, old_dir / "moved"));
+  EXPECT_TRUE(DirectoriesOverlap(old_dir / "moved" / ".." / "moved", old_dir));
+  EXPECT_TRUE(DirectoriesOverlap(old_dir, *test_dir / "v2" / ".." / "v1" / ""));
+  EXPECT_FALSE(DirectoriesOverlap(old_dir, *test_dir / "v10"));
+  EXPECT_FALSE(DirectoriesOverlap(old_dir, *test_dir / "v2"));
+
+  EXPECT_THROW(SyncDirectory(old_dir, old_dir / "moved", 0, nullptr), maidsafe_error);
+  EXPECT_THROW(SyncDirectory(old_dir / "..", old_dir, 0, nullptr), maidsafe_error);
+  EXPECT_FALSE(fs::exists(old_dir / "moved"));
+  EXPECT_EQ("one", ReadFile(old_dir / "1"));
+}
+
+}  // namespace test
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
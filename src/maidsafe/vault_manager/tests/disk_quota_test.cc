@@ -0,0 +1,62 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/disk_quota.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace test {
+
+TEST(DiskQuotaTest, BEH_ComputeDiskQuotas) {
+  std::map<uint64_t, FilesystemSpace> filesystems;
+  // 300 bytes spare once 10% of the capacity is reserved.
+  filesystems[1] = FilesystemSpace{1000, 400};
+  // Already overcommitted.
+  filesystems[2] = FilesystemSpace{1000, 50};
+  std::vector<VaultDiskUsage> vaults;
+  vaults.push_back(VaultDiskUsage{"a", 1, 50, 0});
+  vaults.push_back(VaultDiskUsage{"b", 1, 200, 0});
+  vaults.push_back(VaultDiskUsage{"c", 1, 10, 60});
+  vaults.push_back(VaultDiskUsage{"d", 2, 300, 0});
+  vaults.push_back(VaultDiskUsage{"e", 2, 100, 0});
+  vaults.push_back(VaultDiskUsage{"unmeasured filesystem", 3, 100, 0});
+
+  std::map<std::string, uint64_t> quotas{ComputeDiskQuotas(vaults, filesystems)};
+  ASSERT_EQ(5U, quotas.size());
+  // "c" is held to its limit, and the rest shared evenly.
+  EXPECT_EQ(250U, quotas["a"]);
+  EXPECT_EQ(250U, quotas["b"]);
+  EXPECT_EQ(60U, quotas["c"]);
+  // No vault is asked to shrink below what it already uses.
+  EXPECT_EQ(300U, quotas["d"]);
+  EXPECT_EQ(100U, quotas["e"]);
+}
+
+}  // namespace test
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -38,6 +38,9 @@ int main(int argc, char* argv[]) {
     uint16_t port{static_cast<uint16_t>(std::stoi(std::string{&unuseds[1][0]}))};
     maidsafe::vault_manager::VaultInterface vault_interface{port};
     connected_to_vault_manager = true;
+    vault_interface.SubscribeToMaxDiskUsage([](maidsafe::DiskUsage max_disk_usage) {
+      LOG(kInfo) << "Max disk usage is " << max_disk_usage.data;
+    });
 
     std::future<void> worker;
     VaultConfig config{vault_interface.GetConfiguration()};
@@ -0,0 +1,75 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/key_pool.h"
+
+#include <chrono>
+#include <memory>
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace test {
+
+namespace {
+
+void WaitForSize(const KeyPool& key_pool, std::size_t size) {
+  auto deadline(std::chrono::steady_clock::now() + std::chrono::minutes(1));
+  while (key_pool.Size() < size && std::chrono::steady_clock::now() < deadline)
+    Sleep(std::chrono::milliseconds(100));
+  ASSERT_EQ(size, key_pool.Size());
+}
+
+}  // unnamed namespace
+
+TEST(KeyPoolTest, BEH_RefillAndPersist) {
+  std::shared_ptr<fs::path> test_dir{maidsafe::test::CreateTestPath("MaidSafe_TestKeyPool")};
+  fs::path pool_file_path{*test_dir / kKeyPoolFilename};
+  crypto::AES256Key symm_key{RandomString(crypto::AES256_KeySize)};
+  crypto::AES256InitialisationVector symm_iv{RandomString(crypto::AES256_IVSize)};
+
+  passport::Pmid::Name taken_name;
+  {
+    KeyPool key_pool{pool_file_path, symm_key, symm_iv, 2};
+    WaitForSize(key_pool, 2);
+    taken_name = key_pool.Get().first.name();
+    EXPECT_TRUE(fs::exists(pool_file_path));
+  }
+
+  // The taken key must not be handed out again after a restart.
+  KeyPool key_pool{pool_file_path, symm_key, symm_iv, 1};
+  EXPECT_GE(key_pool.Size(), 1U);
+  EXPECT_NE(taken_name, key_pool.Get().first.name());
+}
+
+}  // namespace test
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -0,0 +1,66 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/placement_engine.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace test {
+
+TEST(PlacementEngineTest, BEH_BalanceAndKeepPlacement) {
+  // Node 1 has twice the CPUs of node 0, so should take twice the vaults.
+  PlacementEngine placement_engine{std::vector<PlacementEngine::Node>{
+      PlacementEngine::Node{0, std::vector<unsigned>{0, 1}, 0},
+      PlacementEngine::Node{1, std::vector<unsigned>{2, 3, 4, 5}, 0}}};
+  std::vector<int32_t> placed;
+  for (int i(0); i < 6; ++i)
+    placed.push_back(placement_engine.Place(-1));
+  EXPECT_EQ(2, std::count(std::begin(placed), std::end(placed), 0));
+  EXPECT_EQ(4, std::count(std::begin(placed), std::end(placed), 1));
+
+  // A vault which has been placed before stays put, even if that unbalances the nodes.  An unknown
+  // node is treated as no placement.
+  EXPECT_EQ(1, placement_engine.Place(1));
+  placement_engine.Release(0);
+  placement_engine.Release(0);
+  EXPECT_EQ(0, placement_engine.Place(7));
+
+  ASSERT_NE(nullptr, placement_engine.NodeToPin(1));
+  EXPECT_EQ("2-5", ToCpuList(placement_engine.NodeToPin(1)->cpus));
+  EXPECT_EQ(nullptr, placement_engine.NodeToPin(7));
+  EXPECT_EQ("0,2-3,7", ToCpuList(std::vector<unsigned>{0, 2, 3, 7}));
+
+  // Nothing is pinned on a single-node host.
+  PlacementEngine single_node{
+      std::vector<PlacementEngine::Node>{PlacementEngine::Node{0, std::vector<unsigned>{0, 1}, 0}}};
+  EXPECT_EQ(0, single_node.Place(-1));
+  EXPECT_EQ(nullptr, single_node.NodeToPin(0));
+}
+
+}  // namespace test
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -18,10 +18,17 @@
 
 #include "maidsafe/vault_manager/process_manager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <string>
 #include <vector>
 
+#include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
 
 #include "maidsafe/common/asio_service.h"
@@ -29,9 +36,14 @@
 #include "maidsafe/common/process.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+#include "maidsafe/common/tcp/connection.h"
+#include "maidsafe/common/tcp/listener.h"
+#include "maidsafe/passport/passport.h"
 
 #include "maidsafe/vault_manager/config.h"
 #include "maidsafe/vault_manager/utils.h"
+#include "maidsafe/vault_manager/messages/vault_started.h"
 #include "maidsafe/vault_manager/tests/test_utils.h"
 
 namespace fs = boost::filesystem;
@@ -42,14 +54,279 @@ namespace vault_manager {
 
 namespace test {
 
-TEST(ProcessManagerTest, BEH_Constructor) {
-  fs::path path_to_vault{process::GetOtherExecutablePath("dummy_vault")};
-  std::unique_ptr<AsioService> asio_service{maidsafe::make_unique<AsioService>(1)};
-  std::shared_ptr<ProcessManager> process_manager{
-      ProcessManager::MakeShared(asio_service->service(), path_to_vault, tcp::Port{7777})};
-  process_manager->StopAll();
-  LOG(kInfo) << "Destroying asio...";
-  asio_service.reset();
+namespace {
+
+// ProcessManager may only be used on its strand, so tests run each call there and wait for it.
+template <typename Functor>
+auto OnStrand(asio::io_service::strand& strand, Functor functor) -> decltype(functor()) {
+  std::packaged_task<decltype(functor())()> task{std::move(functor)};
+  auto result(task.get_future());
+  strand.dispatch([&task] { task(); });
+  return result.get();
+}
+
+std::vector<VaultInfo> MakeVaults(int count, const fs::path& root) {
+  std::vector<VaultInfo> vaults;
+  for (int i(0); i < count; ++i) {
+    VaultInfo vault;
+    vault.pmid_and_signer =
+        std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner());
+    vault.label = GenerateLabel();
+    vault.vault_dir = root / std::to_string(i);
+    fs::create_directories(vault.vault_dir);
+    vaults.push_back(std::move(vault));
+  }
+  return vaults;
+}
+
+// Accepts the dummy vaults' connections and records the process ID each reports, but never answers
+// them.  Each vault then keeps running until it times out waiting for a response (kRpcTimeout),
+// rather than exiting on failing to connect.
+class VaultListener {
+ public:
+  struct StartedVault {
+    tcp::ConnectionPtr connection;
+    ProcessId process_id;
+  };
+
+  explicit VaultListener(asio::io_service::strand& strand)
+      : state_(std::make_shared<State>()), listener_() {
+    auto state(state_);
+    auto on_new_connection([state](tcp::ConnectionPtr connection) {
+      tcp::MessageReceivedFunctor on_message{[state, connection](tcp::Message message) {
+        InputVectorStream binary_input_stream(std::move(message));
+        MessageTag tag(static_cast<MessageTag>(-1));
+        CorrelationId correlation_id(0);
+        Parse(binary_input_stream, tag, correlation_id);
+        if (tag != MessageTag::kVaultStarted)
+          return;
+        ProcessId process_id{Parse<VaultStarted>(binary_input_stream).process_id};
+        std::lock_guard<std::mutex> lock{state->mutex};
+        state->started.push_back(StartedVault{connection, process_id});
+        state->cond_var.notify_all();
+      }};
+      connection->Start(on_message, [] {});
+      std::lock_guard<std::mutex> lock{state->mutex};
+      state->connections.push_back(connection);
+    });
+    listener_ = tcp::Listener::MakeShared(strand, on_new_connection, tcp::Port{7777});
+  }
+
+  tcp::Port Port() const { return listener_->ListeningPort(); }
+
+  // Waits until at least 'count' vaults have reported starting, and returns all which have.
+  std::vector<StartedVault> WaitForStarted(std::size_t count) {
+    std::unique_lock<std::mutex> lock{state_->mutex};
+    state_->cond_var.wait_for(lock, kRpcTimeout * 5,
+                              [&] { return state_->started.size() >= count; });
+    return state_->started;
+  }
+
+  // Must be called on the listener's strand.
+  void Close() {
+    listener_->StopListening();
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    for (auto& connection : state_->connections)
+      connection->Close();
+  }
+
+ private:
+  struct State {
+    std::mutex mutex;
+    std::condition_variable cond_var;
+    std::vector<tcp::ConnectionPtr> connections;
+    std::vector<StartedVault> started;
+  };
+
+  std::shared_ptr<State> state_;
+  std::shared_ptr<tcp::Listener> listener_;
+};
+
+}  // unnamed namespace
+
+class ProcessManagerTest : public testing::Test {
+ protected:
+  ProcessManagerTest()
+      : test_dir_(maidsafe::test::CreateTestPath("MaidSafe_TestProcessManager")),
+        path_to_vault_(process::GetOtherExecutablePath("dummy_vault")),
+        asio_service_(maidsafe::make_unique<AsioService>(2)),
+        strand_(asio_service_->service()),
+        listener_(),
+        process_manager_() {}
+
+  void SetUp() override {
+    listener_ = maidsafe::make_unique<VaultListener>(strand_);
+    process_manager_ = ProcessManager::MakeShared(strand_, path_to_vault_, listener_->Port());
+  }
+
+  void TearDown() override {
+    OnStrand([&] { return process_manager_->StopAll(); }).wait();
+    CloseListener();
+    process_manager_.reset();
+    asio_service_.reset();
+  }
+
+  template <typename Functor>
+  auto OnStrand(Functor functor) -> decltype(functor()) {
+    return test::OnStrand(strand_, std::move(functor));
+  }
+
+  // Once closed, nothing listens on the ProcessManager's port, so vaults fail to connect and exit.
+  void CloseListener() {
+    if (!listener_)
+      return;
+    OnStrand([&] { listener_->Close(); });
+    listener_.reset();
+  }
+
+  maidsafe::test::TestPath test_dir_;
+  const fs::path path_to_vault_;
+  std::unique_ptr<AsioService> asio_service_;
+  asio::io_service::strand strand_;
+  std::unique_ptr<VaultListener> listener_;
+  std::shared_ptr<ProcessManager> process_manager_;
+};
+
+TEST_F(ProcessManagerTest, BEH_Constructor) {
+  auto stopped(OnStrand([&] { return process_manager_->StopAll(); }));
+  EXPECT_EQ(std::future_status::ready, stopped.wait_for(std::chrono::seconds(10)));
+}
+
+TEST_F(ProcessManagerTest, BEH_StopAll) {
+  const int kVaultCount(3);
+  for (auto& vault : MakeVaults(kVaultCount, *test_dir_))
+    OnStrand([&] { return process_manager_->AddProcess(vault); });
+
+  // Stop one vault at a time, at least kInterval apart.
+  const std::chrono::milliseconds kInterval(200);
+  std::vector<std::pair<std::size_t, std::size_t>> progress;
+  std::size_t most_stopping(0);
+  auto start(std::chrono::steady_clock::now());
+  auto stopped(OnStrand([&] {
+    return process_manager_->StopAll(1, kInterval, [&](std::size_t count, std::size_t total) {
+      progress.emplace_back(count, total);
+      std::size_t stopping(0);
+      for (const auto& vault : process_manager_->GetAll()) {
+        if (process_manager_->GetStatus(vault.label).state == VaultStatus::State::kStopping)
+          ++stopping;
+      }
+      most_stopping = std::max(most_stopping, stopping);
+    });
+  }));
+  ASSERT_EQ(std::future_status::ready, stopped.wait_for(std::chrono::seconds(10)));
+  auto elapsed(std::chrono::steady_clock::now() - start);
+
+  // Only vaults which had been launched are counted (queued ones are just removed), and at least
+  // two are launched at once, so at least one interval separates their shutdowns.
+  EXPECT_GE(elapsed, kInterval);
+  EXPECT_LE(most_stopping, 1U);
+  OnStrand([&] {
+    ASSERT_FALSE(progress.empty());
+    EXPECT_GE(progress.back().second, 2U);
+    EXPECT_LE(progress.back().second, std::size_t(kVaultCount));
+    EXPECT_EQ(progress.back().second, progress.back().first);
+    for (std::size_t i(1); i < progress.size(); ++i)
+      EXPECT_GE(progress[i].first, progress[i - 1].first);
+    EXPECT_TRUE(process_manager_->GetAll().empty());
+    // Further calls return the same, ready, future.
+    EXPECT_EQ(std::future_status::ready,
+              process_manager_->StopAll().wait_for(std::chrono::seconds(0)));
+  });
+  // Every vault has been reaped, so none is left running or as a zombie.
+  EXPECT_EQ(0, GetNumRunningProcesses("dummy_vault"));
+}
+
+TEST_F(ProcessManagerTest, BEH_Lookups) {
+  // At least two vaults are launched at once, so both report starting.
+  auto vaults(MakeVaults(2, *test_dir_));
+  for (auto& vault : vaults)
+    OnStrand([&] { return process_manager_->AddProcess(vault); });
+  auto started(listener_->WaitForStarted(vaults.size()));
+  ASSERT_EQ(vaults.size(), started.size());
+
+  OnStrand([&] {
+    // Unknown keys aren't found.
+    EXPECT_THROW(process_manager_->Find(GenerateLabel()), maidsafe_error);
+    EXPECT_THROW(process_manager_->Find(started[0].connection), maidsafe_error);
+    EXPECT_THROW(process_manager_->HandleVaultStarted(started[0].connection, ProcessId{0}),
+                 maidsafe_error);
+
+    for (const auto& vault : started) {
+      // The process ID identifies the vault and its connection.
+      VaultInfo info{process_manager_->HandleVaultStarted(vault.connection, vault.process_id)};
+      EXPECT_TRUE(std::any_of(std::begin(vaults), std::end(vaults),
+                              [&](const VaultInfo& added) { return added.label == info.label; }));
+      EXPECT_EQ(info.label, process_manager_->Find(vault.connection).label);
+      EXPECT_EQ(vault.connection, process_manager_->Find(info.label).tcp_connection);
+      EXPECT_EQ(VaultStatus::State::kRunning, process_manager_->GetStatus(info.label).state);
+    }
+    EXPECT_NE(process_manager_->Find(started[0].connection).label,
+              process_manager_->Find(started[1].connection).label);
+  });
+}
+
+TEST_F(ProcessManagerTest, BEH_Conflicts) {
+  auto vaults(MakeVaults(4, *test_dir_));
+  OnStrand([&] { return process_manager_->AddProcess(vaults[0]); });
+
+  auto expect_conflict([&](const VaultInfo& vault) {
+    try {
+      OnStrand([&] { return process_manager_->AddProcess(vault); });
+      ADD_FAILURE() << "Conflicting vault was added.";
+    } catch (const maidsafe_error& error) {
+      EXPECT_EQ(make_error_code(CommonErrors::already_initialised), error.code());
+    }
+    // A rejected vault leaves nothing behind.
+    EXPECT_EQ(1U, OnStrand([&] { return process_manager_->GetAll(); }).size());
+  });
+  VaultInfo same_pmid{vaults[1]};
+  same_pmid.pmid_and_signer = vaults[0].pmid_and_signer;
+  expect_conflict(same_pmid);
+  VaultInfo same_dir{vaults[1]};
+  same_dir.vault_dir = vaults[0].vault_dir;
+  expect_conflict(same_dir);
+  VaultInfo same_label{vaults[1]};
+  same_label.label = vaults[0].label;
+  expect_conflict(same_label);
+
+  OnStrand([&] {
+    process_manager_->AddProcess(vaults[1]);
+    EXPECT_THROW(process_manager_->SetVaultDir(vaults[1].label, vaults[0].vault_dir),
+                 maidsafe_error);
+    // Once a vault moves, its old directory is free for another vault.
+    process_manager_->SetVaultDir(vaults[1].label, vaults[3].vault_dir);
+    EXPECT_EQ(vaults[3].vault_dir, process_manager_->Find(vaults[1].label).vault_dir);
+    vaults[2].vault_dir = vaults[1].vault_dir;
+    process_manager_->AddProcess(vaults[2]);
+    EXPECT_EQ(3U, process_manager_->GetAll().size());
+  });
+}
+
+TEST_F(ProcessManagerTest, BEH_ReapBurstOfExits) {
+  // Every vault fails to connect and exits at once.  Their SIGCHLDs arrive together and are
+  // coalesced.
+  CloseListener();
+  auto vaults(MakeVaults(8, *test_dir_));
+  for (auto& vault : vaults)
+    OnStrand([&] { return process_manager_->AddProcess(vault); });
+
+  // The first exit of each vault is restarted immediately, and the second puts it into backoff.
+  // Both must have been reaped well within kVaultStartTimeout, after which an unreaped vault would
+  // be treated as having failed to start anyway.
+  auto all_failed_twice([&] {
+    return OnStrand([&] {
+      return std::all_of(std::begin(vaults), std::end(vaults), [&](const VaultInfo& vault) {
+        return process_manager_->GetStatus(vault.label).recent_failures >= 1;
+      });
+    });
+  });
+  auto deadline(std::chrono::steady_clock::now() + kVaultStartTimeout / 3);
+  while (!all_failed_twice() && std::chrono::steady_clock::now() < deadline)
+    Sleep(std::chrono::milliseconds(50));
+  EXPECT_TRUE(all_failed_twice());
+
+  OnStrand([&] { return process_manager_->StopAll(); }).wait();
+  EXPECT_EQ(0, GetNumRunningProcesses("dummy_vault"));
 }
 
 }  // namespace test
@@ -0,0 +1,47 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/resource_sampler.h"
+
+#include "maidsafe/common/process.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace test {
+
+TEST(ResourceSamplerTest, BEH_SampleOwnProcess) {
+  auto sample(SampleResourceUsage(process::GetProcessId()));
+#ifdef MAIDSAFE_LINUX
+  ASSERT_TRUE(static_cast<bool>(sample));
+  EXPECT_EQ(process::GetProcessId(), sample->process_id);
+  EXPECT_GT(sample->resident_bytes, 0U);
+  // At least stdin, stdout and stderr.
+  EXPECT_GE(sample->open_files, 3U);
+#else
+  EXPECT_FALSE(static_cast<bool>(sample));
+#endif
+}
+
+}  // namespace test
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
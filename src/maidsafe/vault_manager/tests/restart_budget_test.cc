@@ -0,0 +1,90 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+
+#include "maidsafe/vault_manager/restart_budget.h"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/vault_manager/config.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace test {
+
+TEST(RestartBudgetTest, BEH_BackoffGrowsToCap) {
+  EXPECT_EQ(std::chrono::milliseconds(0), RestartDelay(1.0));
+  EXPECT_EQ(std::chrono::milliseconds(0), RestartDelay(1.9));
+  EXPECT_EQ(kInitialRestartDelay, RestartDelay(2.0));
+  EXPECT_EQ(kInitialRestartDelay, RestartDelay(2.9));
+  EXPECT_EQ(kInitialRestartDelay * 2, RestartDelay(3.0));
+  EXPECT_EQ(kInitialRestartDelay * 4, RestartDelay(4.0));
+  // Beyond kMaxVaultRestarts, retries are only every kMaxRestartDelay.
+  EXPECT_EQ(kMaxRestartDelay, RestartDelay(kMaxVaultRestarts + 0.5));
+  EXPECT_EQ(kMaxRestartDelay, RestartDelay(1000.0));
+  std::chrono::milliseconds previous(0);
+  for (double score(1.0); score < 100.0; score += 0.5) {
+    EXPECT_GE(RestartDelay(score), previous);
+    EXPECT_LE(RestartDelay(score), kMaxRestartDelay);
+    previous = RestartDelay(score);
+  }
+}
+
+TEST(RestartBudgetTest, BEH_JitterBounds) {
+  auto now(std::chrono::steady_clock::now());
+  for (uint32_t random : {0U, 1U, 12345U, std::numeric_limits<uint32_t>::max()}) {
+    RestartBudget budget;
+    EXPECT_EQ(std::chrono::milliseconds(0), budget.RecordFailure(now, random));
+    for (int failure(2); failure <= kMaxVaultRestarts + 2; ++failure) {
+      std::chrono::milliseconds delay{budget.RecordFailure(now, random)};
+      std::chrono::milliseconds max_delay{RestartDelay(budget.failure_score)};
+      EXPECT_GE(delay, max_delay / 2);
+      EXPECT_LE(delay, max_delay);
+    }
+  }
+}
+
+TEST(RestartBudgetTest, BEH_Decay) {
+  auto now(std::chrono::steady_clock::now());
+  RestartBudget budget;
+  EXPECT_EQ(0.0, budget.FailureScore(now));
+  budget.RecordFailure(now, 0);
+  budget.RecordFailure(now, 0);
+  EXPECT_DOUBLE_EQ(2.0, budget.FailureScore(now));
+  EXPECT_DOUBLE_EQ(1.0, budget.FailureScore(now + kRestartBudgetHalfLife));
+  EXPECT_DOUBLE_EQ(0.5, budget.FailureScore(now + kRestartBudgetHalfLife * 2));
+
+  // A failure soon after adds to the score, so backs off further.
+  EXPECT_GE(budget.RecordFailure(now + std::chrono::seconds(1), 0), kInitialRestartDelay / 2);
+  // Once the earlier failures have been forgotten, the vault is restarted immediately again.
+  auto later(now + kRestartBudgetHalfLife * 20);
+  EXPECT_LT(budget.FailureScore(later), 0.001);
+  EXPECT_EQ(std::chrono::milliseconds(0), budget.RecordFailure(later, 0));
+}
+
+}  // namespace test
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -0,0 +1,76 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/rpc_multiplexer.h"
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace test {
+
+TEST(RpcMultiplexerTest, BEH_MatchCancelAndTimeOut) {
+  AsioService asio_service(1);
+  std::shared_ptr<RpcMultiplexer> rpcs{RpcMultiplexer::MakeShared(asio_service.service())};
+
+  // Responses are matched by ID, whatever order they arrive in.
+  std::vector<std::pair<CorrelationId, std::future<std::string>>> requests;
+  for (int i(0); i < 100; ++i)
+    requests.push_back(rpcs->Add<std::string>());
+  for (auto itr(requests.rbegin()); itr != requests.rend(); ++itr)
+    EXPECT_TRUE(rpcs->SetValue(itr->first, std::to_string(itr->first)));
+  for (auto& request : requests)
+    EXPECT_EQ(std::to_string(request.first), request.second.get());
+  EXPECT_FALSE(rpcs->SetValue(requests.front().first, std::string{"again"}));
+
+  // A response of the wrong type leaves the request pending.
+  auto request(rpcs->Add<bool>());
+  EXPECT_FALSE(rpcs->SetValue(request.first, std::string{"wrong type"}));
+  EXPECT_TRUE(rpcs->SetValue(request.first, true));
+  EXPECT_TRUE(request.second.get());
+
+  auto cancelled(rpcs->Add<int>());
+  auto failed(rpcs->Add<int>());
+  auto timed_out(rpcs->Add<int>(std::chrono::milliseconds(100)));
+  EXPECT_EQ(3U, rpcs->PendingCount());
+  EXPECT_TRUE(rpcs->Cancel(cancelled.first));
+  EXPECT_THROW(cancelled.second.get(), std::system_error);
+  EXPECT_TRUE(rpcs->SetException(failed.first, MakeError(CommonErrors::invalid_parameter)));
+  EXPECT_THROW(failed.second.get(), maidsafe_error);
+  EXPECT_THROW(timed_out.second.get(), maidsafe_error);
+  EXPECT_FALSE(rpcs->SetValue(timed_out.first, 1));
+  EXPECT_EQ(0U, rpcs->PendingCount());
+
+  auto outstanding(rpcs->Add<int>());
+  rpcs.reset();
+  EXPECT_THROW(outstanding.second.get(), std::system_error);
+}
+
+}  // namespace test
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -0,0 +1,69 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/session_tickets.h"
+
+#include <string>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace test {
+
+TEST(SessionTicketsTest, BEH_IssueAndRedeem) {
+  SessionTickets session_tickets;
+  SessionTickets::MaidName maid_name{Identity{RandomString(64)}};
+  asymm::PlainText challenge{RandomString(100)};
+  crypto::AES256Key session_key{RandomString(crypto::AES256_KeySize)};
+  SessionTicket session_ticket{session_tickets.Issue(maid_name, session_key)};
+  std::string secret{session_ticket.Secret(session_key)};
+  std::string proof{SessionProof(secret, challenge)};
+
+  SessionTickets::Redeemed redeemed{
+      session_tickets.Redeem(session_ticket.ticket, challenge, proof)};
+  EXPECT_EQ(maid_name, redeemed.maid_name);
+  // Both ends derive the same key for the new connection.
+  EXPECT_EQ(ResumedSessionKey(secret, challenge), redeemed.session_key);
+  // The proof must answer this connection's challenge.
+  EXPECT_THROW(session_tickets.Redeem(session_ticket.ticket, asymm::PlainText{RandomString(100)},
+                                      proof),
+               maidsafe_error);
+  // Tickets can't be altered, nor redeemed with another VaultManager.
+  std::string altered_ticket{session_ticket.ticket};
+  altered_ticket[0] ^= 1;
+  EXPECT_THROW(session_tickets.Redeem(altered_ticket, challenge, proof), maidsafe_error);
+  EXPECT_THROW(SessionTickets().Redeem(session_ticket.ticket, challenge, proof), maidsafe_error);
+}
+
+// SessionProof is HMAC-SHA512 of the challenge, keyed with the secret (RFC 4231 test case 2).
+TEST(SessionTicketsTest, BEH_SessionProofIsHmacSha512) {
+  EXPECT_EQ(
+      "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea2505549758bf75c05a994a6d034f65f8f0"
+      "e6fdcaeab1a34d4a6b4b636e070a38bce737",
+      HexEncode(SessionProof("Jefe", asymm::PlainText{"what do ya want for nothing?"})));
+}
+
+}  // namespace test
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
@@ -18,16 +18,25 @@
 
 #include "maidsafe/vault_manager/vault_manager.h"
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "boost/filesystem/path.hpp"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/process.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+#include "maidsafe/common/tcp/connection.h"
+#include "maidsafe/passport/passport.h"
 
+#include "maidsafe/vault_manager/client_interface.h"
 #include "maidsafe/vault_manager/config.h"
 #include "maidsafe/vault_manager/utils.h"
+#include "maidsafe/vault_manager/messages/validate_connection_request.h"
 #include "maidsafe/vault_manager/tests/test_utils.h"
 
 namespace fs = boost::filesystem;
@@ -49,6 +58,51 @@ TEST(VaultManagerTest, BEH_Basic) {
   std::this_thread::sleep_for(std::chrono::seconds(1));
 }
 
+TEST(VaultManagerTest, BEH_DuplicateValidateConnectionRequest) {
+  std::shared_ptr<fs::path> test_env_root_dir{
+      maidsafe::test::CreateTestPath("MaidSafe_TestVaultManager")};
+  fs::path path_to_vault{process::GetOtherExecutablePath("dummy_vault")};
+  SetEnvironment(tcp::Port{7777}, *test_env_root_dir, path_to_vault);
+
+  VaultManager vault_manager;
+  static_cast<void>(vault_manager);
+
+  AsioService asio_service{1};
+  asio::io_service::strand strand{asio_service.service()};
+  std::mutex mutex;
+  std::condition_variable cond_var;
+  std::vector<CorrelationId> challenged;
+  tcp::ConnectionPtr connection{tcp::Connection::MakeShared(strand, GetInitialListeningPort())};
+  connection->Start([&](tcp::Message message) {
+    InputVectorStream binary_input_stream(std::move(message));
+    MessageTag tag(static_cast<MessageTag>(-1));
+    CorrelationId correlation_id(0);
+    Parse(binary_input_stream, tag, correlation_id);
+    std::lock_guard<std::mutex> lock{mutex};
+    if (tag == MessageTag::kChallenge)
+      challenged.push_back(correlation_id);
+    cond_var.notify_all();
+  }, [] {});
+
+  // Only the first request is answered.  Handling the second throws, since the connection is no
+  // longer a new one, which mustn't take down the manager.
+  Send(connection, ValidateConnectionRequest(), 1);
+  Send(connection, ValidateConnectionRequest(), 2);
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    EXPECT_TRUE(cond_var.wait_for(lock, kRpcTimeout, [&] { return !challenged.empty(); }));
+  }
+  {
+    passport::MaidAndSigner maid_and_signer{passport::CreateMaidAndSigner()};
+    ClientInterface client_interface{maid_and_signer.first};
+  }
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    EXPECT_EQ(std::vector<CorrelationId>(1, 1), challenged);
+  }
+  connection->Close();
+}
+
 }  // namespace test
 
 }  // namespace vault_manager
@@ -18,6 +18,8 @@
 
 #include "maidsafe/vault_manager/tools/actions/start_network.h"
 
+#include <vector>
+
 #include "boost/filesystem/operations.hpp"
 
 #include "maidsafe/common/log.h"
@@ -41,22 +43,20 @@ namespace tools {
 namespace {
 
 void StartVaults(LocalNetworkController* local_network_controller, DiskUsage max_usage) {
-  for (int i(0); i < local_network_controller->vault_count; ++i) {
-    TLOG(kDefaultColour) << "Starting vault " << i << '\n';
+  TLOG(kDefaultColour) << "Starting " << local_network_controller->vault_count << " vaults\n";
+  std::vector<boost::filesystem::path> vault_dirs(local_network_controller->vault_count);
 #ifdef USE_VLOGGING
-    assert(local_network_controller->vlog_session_id);
-    assert(local_network_controller->send_hostname_to_visualiser_server);
-    local_network_controller->client_interface
-        ->StartVault(boost::filesystem::path(), max_usage,
-                     *local_network_controller->vlog_session_id,
-                     *local_network_controller->send_hostname_to_visualiser_server)
-        .get();
+  assert(local_network_controller->vlog_session_id);
+  assert(local_network_controller->send_hostname_to_visualiser_server);
+  auto vault_futures(local_network_controller->client_interface->StartVaults(
+      vault_dirs, max_usage, *local_network_controller->vlog_session_id,
+      *local_network_controller->send_hostname_to_visualiser_server, std::vector<int>()));
 #else
-    local_network_controller->client_interface->StartVault(boost::filesystem::path(), max_usage)
-        .get();
+  auto vault_futures(local_network_controller->client_interface->StartVaults(vault_dirs,
+                                                                             max_usage));
 #endif
-    Sleep(std::chrono::milliseconds(500));
-  }
+  for (auto& vault_future : vault_futures)
+    vault_future.get();
 }
 
 }  // unnamed namespace
@@ -184,17 +184,29 @@ void StartFirstTwoVaults(LocalNetworkController* local_network_controller, DiskU
 }
 
 void StartRemainingVaults(LocalNetworkController* local_network_controller, DiskUsage max_usage) {
+  // Once the first two have joined, the rest can all be started with a single request.
   const int kRemainingIndex(local_network_controller->vault_count + 2);
+  std::vector<boost::filesystem::path> vault_dirs;
+  std::vector<int> pmid_list_indices;
   for (int i(4); i < kRemainingIndex; ++i) {
     TLOG(kDefaultColour) << "Starting vault " << i - 1 << '\n';  // index i in pmid list
     std::string vault_dir_name{DebugId(GetPmidAndSigner(i).first.name().value)};
     fs::create_directories(local_network_controller->test_env_root_dir / vault_dir_name);
-    auto vault_future(StartVault(local_network_controller,
-                                 local_network_controller->test_env_root_dir / vault_dir_name,
-                                 max_usage, i));
-    vault_future.get();
-    Sleep(std::chrono::milliseconds(500));
+    vault_dirs.push_back(local_network_controller->test_env_root_dir / vault_dir_name);
+    pmid_list_indices.push_back(i);
   }
+#ifdef USE_VLOGGING
+  assert(local_network_controller->vlog_session_id);
+  assert(local_network_controller->send_hostname_to_visualiser_server);
+  auto vault_futures(local_network_controller->client_interface->StartVaults(
+      vault_dirs, max_usage, *local_network_controller->vlog_session_id,
+      *local_network_controller->send_hostname_to_visualiser_server, pmid_list_indices));
+#else
+  auto vault_futures(local_network_controller->client_interface->StartVaults(
+      vault_dirs, max_usage, pmid_list_indices));
+#endif
+  for (auto& vault_future : vault_futures)
+    vault_future.get();
 }
 
 }  // unnamed namespace
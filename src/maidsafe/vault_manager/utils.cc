@@ -18,8 +18,16 @@
 
 #include "maidsafe/vault_manager/utils.h"
 
+#ifndef MAIDSAFE_WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <fstream>
 #include <functional>
 #include <iterator>
 #include <limits>
@@ -65,6 +73,36 @@ const MessageTag VaultStartedResponse::tag;
 
 namespace {
 
+#ifndef MAIDSAFE_WIN32
+bool WriteAndSync(const fs::path& path, int flags, const std::string& content) {
+  int fd{open(path.c_str(), flags, S_IRUSR | S_IWUSR)};
+  if (fd < 0) {
+    LOG(kError) << "Failed to open " << path << " for writing.";
+    return false;
+  }
+  const char* data{content.data()};
+  std::size_t remaining{content.size()};
+  while (remaining != 0) {
+    ssize_t written{write(fd, data, remaining)};
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      LOG(kError) << "Failed to write " << path;
+      close(fd);
+      return false;
+    }
+    data += written;
+    remaining -= static_cast<std::size_t>(written);
+  }
+  if (fsync(fd) != 0) {
+    LOG(kError) << "Failed to flush " << path;
+    close(fd);
+    return false;
+  }
+  return close(fd) == 0;
+}
+#endif
+
 #ifdef TESTING
 std::once_flag test_env_flag;
 tcp::Port g_test_vault_manager_port(0);
@@ -111,6 +149,53 @@ NonEmptyString GenerateLabel() {
   return NonEmptyString{label};
 }
 
+bool WriteFileAtomically(const fs::path& path, const std::string& content) {
+  fs::path temp_path{path};
+  temp_path += ".tmp";
+#ifdef MAIDSAFE_WIN32
+  // On Windows, fs::rename uses MoveFileEx with MOVEFILE_REPLACE_EXISTING which is atomic for files
+  // on the same volume.
+  if (!WriteFile(temp_path, content))
+    return false;
+#else
+  if (!WriteAndSync(temp_path, O_WRONLY | O_CREAT | O_TRUNC, content))
+    return false;
+#endif
+  boost::system::error_code error_code;
+  fs::rename(temp_path, path, error_code);
+  if (error_code) {
+    LOG(kError) << "Failed to rename " << temp_path << " to " << path << ": "
+                << error_code.message();
+    return false;
+  }
+#ifndef MAIDSAFE_WIN32
+  // Flush the directory entry too, so the rename itself survives a crash.
+  if (path.has_parent_path()) {
+    int dir_fd{open(path.parent_path().c_str(), O_RDONLY)};
+    if (dir_fd >= 0) {
+      fsync(dir_fd);
+      close(dir_fd);
+    }
+  }
+#endif
+  return true;
+}
+
+bool AppendToFileDurably(const fs::path& path, const std::string& content) {
+#ifdef MAIDSAFE_WIN32
+  std::ofstream file_out(path.string(), std::ios::out | std::ios::binary | std::ios::app);
+  file_out.write(content.data(), content.size());
+  file_out.flush();
+  if (!file_out.good()) {
+    LOG(kError) << "Failed to append to " << path;
+    return false;
+  }
+  return true;
+#else
+  return WriteAndSync(path, O_WRONLY | O_CREAT | O_APPEND, content);
+#endif
+}
+
 tcp::Port GetInitialListeningPort() {
 #ifdef TESTING
   return GetTestVaultManagerPort() == 0 ? kLivePort + 100 : GetTestVaultManagerPort();
@@ -52,13 +52,21 @@ std::unique_ptr<VaultConfig> GetValue(const VaultStartedResponse& vault_started_
 
 }  // namespace detail
 
+// Pass the request's 'correlation_id' when sending a request or response which is part of an RPC.
 template <typename T>
-void Send(tcp::ConnectionPtr connection, T message) {
-  connection->Send(Serialise(T::tag, std::move(message)));
+void Send(tcp::ConnectionPtr connection, T message, CorrelationId correlation_id = 0) {
+  connection->Send(Serialise(T::tag, correlation_id, std::move(message)));
 }
 
 NonEmptyString GenerateLabel();
 
+// Writes 'content' to a temporary file alongside 'path', flushes it to disk and then renames it
+// over 'path', so that a crash leaves either the old or the new file in place, never a partial one.
+bool WriteFileAtomically(const boost::filesystem::path& path, const std::string& content);
+
+// Appends 'content' to 'path' (creating it if required) and flushes it to disk before returning.
+bool AppendToFileDurably(const boost::filesystem::path& path, const std::string& content);
+
 tcp::Port GetInitialListeningPort();
 
 #ifdef TESTING
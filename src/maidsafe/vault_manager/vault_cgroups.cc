@@ -0,0 +1,350 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault_manager/vault_cgroups.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#ifdef MAIDSAFE_LINUX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/vault_manager/launcher.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+namespace {
+
+const uint32_t kMaxCgroupWeight(10000);
+
+void CheckLimits(const VaultResourceLimits& limits) {
+  auto valid_weight = [](const boost::optional<uint32_t>& weight) {
+    return !weight || (*weight >= 1 && *weight <= kMaxCgroupWeight);
+  };
+  bool valid{valid_weight(limits.cpu_weight) && valid_weight(limits.io_weight) &&
+             (!limits.memory_high || !limits.memory_max ||
+              *limits.memory_high <= *limits.memory_max)};
+  for (const auto& line : limits.io_max) {
+    // Each line must be a single "MAJ:MIN key=value..." entry.
+    std::size_t space{line.find(' ')};
+    valid = valid && space != std::string::npos && line.find(':') < space &&
+            line.find('\n') == std::string::npos;
+  }
+  if (!valid) {
+    LOG(kError) << "Invalid vault resource limits.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+}
+
+#ifdef MAIDSAFE_LINUX
+
+const fs::path kCgroupMount("/sys/fs/cgroup");
+const uint32_t kDefaultCgroupWeight(100);
+
+// Returns the manager's cgroup v2 path relative to the mount, or an empty path if it isn't in one.
+fs::path OwnCgroup() {
+  std::ifstream file("/proc/self/cgroup");
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.compare(0, 3, "0::") == 0)
+      return fs::path(line.substr(3));
+  }
+  return fs::path();
+}
+
+std::string ReadCgroupFile(const fs::path& path) {
+  std::ifstream file(path.string());
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// The kernel parses each write() separately, so each value must be written in a single call.
+bool WriteCgroupFile(const fs::path& path, const std::string& value) {
+  int fd{open(path.c_str(), O_WRONLY | O_CLOEXEC)};
+  if (fd < 0) {
+    LOG(kWarning) << "Failed to open " << path << ": " << std::strerror(errno);
+    return false;
+  }
+  bool written{write(fd, value.data(), value.size()) == static_cast<ssize_t>(value.size())};
+  if (!written)
+    LOG(kWarning) << "Failed to write \"" << value << "\" to " << path << ": "
+                  << std::strerror(errno);
+  close(fd);
+  return written;
+}
+
+bool MakeCgroupDir(const fs::path& dir) {
+  if (mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST)
+    return true;
+  LOG(kInfo) << "Failed to create cgroup " << dir << ": " << std::strerror(errno);
+  return false;
+}
+
+// Enables whichever of the cpu, cpuset, memory and io controllers are available to the children of
+// 'dir'.
+void EnableControllers(const fs::path& dir) {
+  std::istringstream available{ReadCgroupFile(dir / "cgroup.controllers")};
+  std::string controller;
+  while (available >> controller) {
+    if (controller == "cpu" || controller == "cpuset" || controller == "memory" ||
+        controller == "io")
+      WriteCgroupFile(dir / "cgroup.subtree_control", "+" + controller);
+  }
+}
+
+std::string Weight(const boost::optional<uint32_t>& weight) {
+  return std::to_string(weight ? *weight : kDefaultCgroupWeight);
+}
+
+std::string Memory(const boost::optional<uint64_t>& bytes) {
+  return bytes ? std::to_string(*bytes) : std::string("max");
+}
+
+std::string IoMaxDevice(const std::string& line) { return line.substr(0, line.find(' ')); }
+
+#endif
+
+}  // unnamed namespace
+
+VaultCgroups::VaultCgroups() : vaults_dir_(), cgroups_() { Initialise(); }
+
+VaultCgroups::~VaultCgroups() {
+#ifdef MAIDSAFE_LINUX
+  for (const auto& cgroup : cgroups_)
+    close(cgroup.second.fd);
+#endif
+}
+
+void VaultCgroups::Initialise() {
+#ifdef MAIDSAFE_LINUX
+  fs::path own_cgroup{OwnCgroup()};
+  boost::system::error_code ec;
+  fs::path base_dir{kCgroupMount.string() + own_cgroup.string()};
+  if (own_cgroup.empty() || !fs::exists(base_dir / "cgroup.controllers", ec)) {
+    LOG(kInfo) << "cgroup v2 is unavailable; vaults will run without resource limits.";
+    return;
+  }
+
+  // Processes can't be in a cgroup whose controllers are enabled for its children, so the manager
+  // and its spawn helper (if any) are moved into a leaf.  Other processes aren't the manager's to
+  // move, so any in the cgroup disable this.  The root cgroup is exempt from the rule, but is left
+  // alone in favour of a dedicated child.
+  const fs::path own_dir{base_dir};
+  std::vector<std::string> process_ids;
+  if (own_cgroup.filename() == "manager") {
+    // Already set up by an earlier instance in this process.
+    base_dir = base_dir.parent_path();
+  } else {
+    const std::string manager_id{std::to_string(getpid())};
+    const std::string helper_id{std::to_string(SpawnHelperProcessId())};
+    process_ids.push_back(manager_id);
+    std::istringstream procs{ReadCgroupFile(own_dir / "cgroup.procs")};
+    std::string process_id;
+    while (procs >> process_id) {
+      if (process_id == helper_id) {
+        process_ids.push_back(helper_id);
+      } else if (process_id != manager_id && own_cgroup != "/") {
+        LOG(kInfo) << "Cgroup " << own_dir << " holds process " << process_id
+                   << " as well as the manager; vaults will run without resource limits.";
+        return;
+      }
+    }
+    if (own_cgroup == "/") {
+      base_dir /= "maidsafe_vault_manager";
+      if (!MakeCgroupDir(base_dir))
+        return;
+    }
+  }
+  if (!MakeCgroupDir(base_dir / "manager"))
+    return;
+  for (auto itr(std::begin(process_ids)); itr != std::end(process_ids); ++itr) {
+    if (!WriteCgroupFile(base_dir / "manager" / "cgroup.procs", *itr)) {
+      // Put back any processes already moved, so that a partial move isn't left behind.
+      for (auto moved(std::begin(process_ids)); moved != itr; ++moved)
+        WriteCgroupFile(own_dir / "cgroup.procs", *moved);
+      LOG(kInfo) << "Can't manage cgroup " << base_dir
+                 << "; vaults will run without resource limits.";
+      return;
+    }
+  }
+  EnableControllers(base_dir);
+
+  fs::path vaults_dir{base_dir / "vaults"};
+  if (!MakeCgroupDir(vaults_dir))
+    return;
+  EnableControllers(vaults_dir);
+  // Remove any cgroups left by a previous run.  Those still holding a process are left alone.
+  for (fs::directory_iterator itr(vaults_dir, ec); !ec && itr != fs::directory_iterator();
+       itr.increment(ec)) {
+    if (fs::is_directory(itr->status()))
+      rmdir(itr->path().c_str());
+  }
+  vaults_dir_ = vaults_dir;
+  LOG(kInfo) << "Vault cgroups will be created under " << vaults_dir_;
+#endif
+}
+
+void VaultCgroups::Add(const NonEmptyString& label, const VaultResourceLimits& limits) {
+#ifdef MAIDSAFE_LINUX
+  if (!Enabled() || cgroups_.count(label.string()) != 0U)
+    return;
+  Cgroup cgroup{vaults_dir_ / CgroupName(label), -1};
+  if (!MakeCgroupDir(cgroup.dir))
+    return;
+  cgroup.fd = open(cgroup.dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (cgroup.fd < 0) {
+    LOG(kWarning) << "Failed to open " << cgroup.dir << ": " << std::strerror(errno);
+    rmdir(cgroup.dir.c_str());
+    return;
+  }
+  cgroups_.emplace(label.string(), cgroup);
+  try {
+    CheckLimits(limits);
+    Apply(cgroup, limits, VaultResourceLimits());
+  } catch (const std::exception& e) {
+    LOG(kWarning) << "Failed to apply resource limits to vault " << label.string() << ": "
+                  << boost::diagnostic_information(e);
+  }
+#else
+  static_cast<void>(label);
+  static_cast<void>(limits);
+#endif
+}
+
+void VaultCgroups::SetLimits(const NonEmptyString& label, const VaultResourceLimits& limits,
+                             const VaultResourceLimits& previous_limits) {
+  auto itr(cgroups_.find(label.string()));
+  if (itr == std::end(cgroups_)) {
+    LOG(kError) << "Vault " << label.string() << " has no cgroup, so can't have resource limits.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  }
+  CheckLimits(limits);
+  Apply(itr->second, limits, previous_limits);
+}
+
+void VaultCgroups::SetCpuset(const NonEmptyString& label, const std::string& cpus,
+                             const std::string& mems) {
+#ifdef MAIDSAFE_LINUX
+  auto itr(cgroups_.find(label.string()));
+  if (itr == std::end(cgroups_))
+    return;
+  if (!WriteCgroupFile(itr->second.dir / "cpuset.cpus", cpus) ||
+      !WriteCgroupFile(itr->second.dir / "cpuset.mems", mems)) {
+    LOG(kWarning) << "Failed to restrict vault " << label.string() << " to CPUs " << cpus
+                  << " and memory nodes " << mems;
+  }
+#else
+  static_cast<void>(label);
+  static_cast<void>(cpus);
+  static_cast<void>(mems);
+#endif
+}
+
+void VaultCgroups::Remove(const NonEmptyString& label) {
+#ifdef MAIDSAFE_LINUX
+  auto itr(cgroups_.find(label.string()));
+  if (itr == std::end(cgroups_))
+    return;
+  close(itr->second.fd);
+  if (rmdir(itr->second.dir.c_str()) != 0) {
+    LOG(kWarning) << "Failed to remove cgroup " << itr->second.dir << ": "
+                  << std::strerror(errno);
+  }
+  cgroups_.erase(itr);
+#else
+  static_cast<void>(label);
+#endif
+}
+
+int VaultCgroups::Descriptor(const NonEmptyString& label) const {
+  auto itr(cgroups_.find(label.string()));
+  return itr == std::end(cgroups_) ? -1 : itr->second.fd;
+}
+
+void VaultCgroups::Apply(const Cgroup& cgroup, const VaultResourceLimits& limits,
+                         const VaultResourceLimits& previous_limits) const {
+#ifdef MAIDSAFE_LINUX
+  // Values which are unset now and were unset before are left alone, so that controllers which
+  // aren't available don't cause failures unless their limits are actually wanted.
+  bool applied{true};
+  if (limits.cpu_weight || previous_limits.cpu_weight)
+    applied &= WriteCgroupFile(cgroup.dir / "cpu.weight", Weight(limits.cpu_weight));
+  if (limits.memory_high || previous_limits.memory_high)
+    applied &= WriteCgroupFile(cgroup.dir / "memory.high", Memory(limits.memory_high));
+  if (limits.memory_max || previous_limits.memory_max)
+    applied &= WriteCgroupFile(cgroup.dir / "memory.max", Memory(limits.memory_max));
+  if (limits.io_weight || previous_limits.io_weight)
+    applied &= WriteCgroupFile(cgroup.dir / "io.weight", "default " + Weight(limits.io_weight));
+  for (const auto& line : previous_limits.io_max) {
+    std::string device{IoMaxDevice(line)};
+    auto same_device = [&](const std::string& new_line) { return IoMaxDevice(new_line) == device; };
+    if (std::none_of(std::begin(limits.io_max), std::end(limits.io_max), same_device)) {
+      applied &= WriteCgroupFile(cgroup.dir / "io.max",
+                                 device + " rbps=max wbps=max riops=max wiops=max");
+    }
+  }
+  for (const auto& line : limits.io_max)
+    applied &= WriteCgroupFile(cgroup.dir / "io.max", line);
+  if (!applied)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+#else
+  static_cast<void>(cgroup);
+  static_cast<void>(limits);
+  static_cast<void>(previous_limits);
+#endif
+}
+
+// Labels come from clients, so are reduced to characters which are safe in a directory name.
+std::string VaultCgroups::CgroupName(const NonEmptyString& label) const {
+  std::string name{label.string().substr(0, 64)};
+  std::replace_if(std::begin(name), std::end(name), [](char c) {
+    return !std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_';
+  }, '_');
+  auto in_use = [this](const std::string& candidate) {
+    return std::any_of(std::begin(cgroups_), std::end(cgroups_),
+                       [&](const std::pair<const std::string, Cgroup>& cgroup) {
+                         return cgroup.second.dir.filename() == candidate;
+                       });
+  };
+  std::string unique_name{name};
+  for (int suffix(2); in_use(unique_name); ++suffix)
+    unique_name = name + "-" + std::to_string(suffix);
+  return unique_name;
+}
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
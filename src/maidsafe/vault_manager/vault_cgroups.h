@@ -0,0 +1,89 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MANAGER_VAULT_CGROUPS_H_
+#define MAIDSAFE_VAULT_MANAGER_VAULT_CGROUPS_H_
+
+#include <map>
+#include <string>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/types.h"
+
+#include "maidsafe/vault_manager/vault_resource_limits.h"
+
+namespace maidsafe {
+
+namespace vault_manager {
+
+// Gives each vault its own cgroup v2 cgroup, so that its CPU, memory and IO can be limited.  On
+// construction, the manager and its spawn helper are moved from the manager's cgroup (C) into a
+// leaf "C/manager", and the vaults' cgroups are created under "C/vaults".  "manager" and "vaults"
+// are siblings with equal weights, so however many vaults are running, the manager keeps a fair
+// share of CPU and IO.
+//
+// If cgroup v2 isn't available, C hasn't been delegated to the manager (e.g. via systemd's
+// Delegate=yes) or C holds other processes too (unless it's the root), this is disabled: vaults
+// then run in the manager's cgroup without limits.  The class is not thread-safe.
+class VaultCgroups {
+ public:
+  VaultCgroups(const VaultCgroups&) = delete;
+  VaultCgroups(VaultCgroups&&) = delete;
+  VaultCgroups& operator=(VaultCgroups) = delete;
+
+  VaultCgroups();
+  ~VaultCgroups();
+
+  bool Enabled() const { return !vaults_dir_.empty(); }
+  // Creates the vault's cgroup and applies 'limits' to it.  Failures are logged, and leave the
+  // vault without a cgroup (i.e. in the manager's).
+  void Add(const NonEmptyString& label, const VaultResourceLimits& limits);
+  // Applies 'limits' to the vault's cgroup in place of 'previous_limits'.  Throws if cgroups are
+  // disabled, the vault has no cgroup, 'limits' is invalid or the limits couldn't be written.
+  void SetLimits(const NonEmptyString& label, const VaultResourceLimits& limits,
+                 const VaultResourceLimits& previous_limits);
+  // Restricts the vault to the given CPUs and memory nodes (both in kernel list format, e.g.
+  // "0-3,8-11").  Failures are logged.
+  void SetCpuset(const NonEmptyString& label, const std::string& cpus, const std::string& mems);
+  // Removes the vault's cgroup.  The vault's process must have exited.
+  void Remove(const NonEmptyString& label);
+  // Returns an open descriptor for the vault's cgroup directory (owned by this class), to be passed
+  // to the Launcher, or -1 if the vault has no cgroup.
+  int Descriptor(const NonEmptyString& label) const;
+
+ private:
+  struct Cgroup {
+    boost::filesystem::path dir;
+    int fd;
+  };
+
+  void Initialise();
+  void Apply(const Cgroup& cgroup, const VaultResourceLimits& limits,
+             const VaultResourceLimits& previous_limits) const;
+  std::string CgroupName(const NonEmptyString& label) const;
+
+  boost::filesystem::path vaults_dir_;
+  std::map<std::string, Cgroup> cgroups_;
+};
+
+}  // namespace vault_manager
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MANAGER_VAULT_CGROUPS_H_
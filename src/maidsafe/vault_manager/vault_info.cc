@@ -18,6 +18,7 @@
 
 #include "maidsafe/vault_manager/vault_info.h"
 
+#include <memory>
 #include <utility>
 
 namespace maidsafe {
@@ -26,10 +27,12 @@ namespace vault_manager {
 
 VaultInfo::VaultInfo()
     : pmid_and_signer(),
+      encrypted_keys(),
       vault_dir(),
       max_disk_usage(0),
       owner_name(),
       label(),
+      numa_node(-1),
 #ifdef USE_VLOGGING
       vlog_session_id(),
       send_hostname_to_visualiser_server(false),
@@ -39,10 +42,12 @@ VaultInfo::VaultInfo()
 
 VaultInfo::VaultInfo(const VaultInfo& other)
     : pmid_and_signer(other.pmid_and_signer),
+      encrypted_keys(other.encrypted_keys),
       vault_dir(other.vault_dir),
       max_disk_usage(other.max_disk_usage),
       owner_name(other.owner_name),
       label(other.label),
+      numa_node(other.numa_node),
 #ifdef USE_VLOGGING
       vlog_session_id(other.vlog_session_id),
       send_hostname_to_visualiser_server(other.send_hostname_to_visualiser_server),
@@ -52,10 +57,12 @@ VaultInfo::VaultInfo(const VaultInfo& other)
 
 VaultInfo::VaultInfo(VaultInfo&& other)
     : pmid_and_signer(std::move(other.pmid_and_signer)),
+      encrypted_keys(std::move(other.encrypted_keys)),
       vault_dir(std::move(other.vault_dir)),
       max_disk_usage(std::move(other.max_disk_usage)),
       owner_name(std::move(other.owner_name)),
       label(std::move(other.label)),
+      numa_node(std::move(other.numa_node)),
 #ifdef USE_VLOGGING
       vlog_session_id(std::move(other.vlog_session_id)),
       send_hostname_to_visualiser_server(std::move(other.send_hostname_to_visualiser_server)),
@@ -71,10 +78,12 @@ VaultInfo& VaultInfo::operator=(VaultInfo other) {
 void swap(VaultInfo& lhs, VaultInfo& rhs) {
   using std::swap;
   swap(lhs.pmid_and_signer, rhs.pmid_and_signer);
+  swap(lhs.encrypted_keys, rhs.encrypted_keys);
   swap(lhs.vault_dir, rhs.vault_dir);
   swap(lhs.max_disk_usage, rhs.max_disk_usage);
   swap(lhs.owner_name, rhs.owner_name);
   swap(lhs.label, rhs.label);
+  swap(lhs.numa_node, rhs.numa_node);
 #ifdef USE_VLOGGING
   swap(lhs.vlog_session_id, rhs.vlog_session_id);
   swap(lhs.send_hostname_to_visualiser_server, rhs.send_hostname_to_visualiser_server);
@@ -82,6 +91,27 @@ void swap(VaultInfo& lhs, VaultInfo& rhs) {
   swap(lhs.tcp_connection, rhs.tcp_connection);
 }
 
+std::shared_ptr<const EncryptedVaultKeys> EncryptVaultKeys(
+    const VaultInfo& vault, const crypto::AES256Key& symm_key,
+    const crypto::AES256InitialisationVector& symm_iv) {
+  if (vault.encrypted_keys)
+    return vault.encrypted_keys;
+  auto encrypted_keys(std::make_shared<EncryptedVaultKeys>());
+  encrypted_keys->encrypted_pmid =
+      passport::EncryptPmid(vault.pmid_and_signer->first, symm_key, symm_iv);
+  encrypted_keys->encrypted_anpmid =
+      passport::EncryptAnpmid(vault.pmid_and_signer->second, symm_key, symm_iv);
+  return encrypted_keys;
+}
+
+std::shared_ptr<passport::PmidAndSigner> DecryptVaultKeys(
+    const EncryptedVaultKeys& encrypted_keys, const crypto::AES256Key& symm_key,
+    const crypto::AES256InitialisationVector& symm_iv) {
+  return std::make_shared<passport::PmidAndSigner>(
+      std::make_pair(passport::DecryptPmid(encrypted_keys.encrypted_pmid, symm_key, symm_iv),
+                     passport::DecryptAnpmid(encrypted_keys.encrypted_anpmid, symm_key, symm_iv)));
+}
+
 }  // namespace vault_manager
 
 }  // namespace maidsafe
@@ -26,6 +26,7 @@
 
 #include "boost/filesystem/path.hpp"
 
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/passport/passport.h"
 
@@ -35,6 +36,17 @@ namespace maidsafe {
 
 namespace vault_manager {
 
+// A vault's keys encrypted with the config file's key.  Neither ever changes once the vault has
+// been created, so this is computed once and reused every time the vault is persisted.
+struct EncryptedVaultKeys {
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(encrypted_pmid, encrypted_anpmid);
+  }
+
+  crypto::CipherText encrypted_pmid, encrypted_anpmid;
+};
+
 struct VaultInfo {
   VaultInfo();
   VaultInfo(const VaultInfo&);
@@ -42,10 +54,14 @@ struct VaultInfo {
   VaultInfo& operator=(VaultInfo other);
 
   std::shared_ptr<passport::PmidAndSigner> pmid_and_signer;
+  // Cached encryption of 'pmid_and_signer'; may be null if it hasn't been persisted yet.
+  std::shared_ptr<const EncryptedVaultKeys> encrypted_keys;
   boost::filesystem::path vault_dir;
   DiskUsage max_disk_usage;
   passport::PublicMaid::Name owner_name;
   NonEmptyString label;
+  // The NUMA node which the vault is pinned to, or -1 if it hasn't been placed yet.
+  int32_t numa_node;
 #ifdef USE_VLOGGING
   std::string vlog_session_id;
   bool send_hostname_to_visualiser_server;
@@ -55,6 +71,15 @@ struct VaultInfo {
 
 void swap(VaultInfo& lhs, VaultInfo& rhs);
 
+// Returns 'vault.encrypted_keys' if set, otherwise encrypts the vault's keys.
+std::shared_ptr<const EncryptedVaultKeys> EncryptVaultKeys(
+    const VaultInfo& vault, const crypto::AES256Key& symm_key,
+    const crypto::AES256InitialisationVector& symm_iv);
+
+std::shared_ptr<passport::PmidAndSigner> DecryptVaultKeys(
+    const EncryptedVaultKeys& encrypted_keys, const crypto::AES256Key& symm_key,
+    const crypto::AES256InitialisationVector& symm_iv);
+
 }  // namespace vault_manager
 
 }  // namespace maidsafe
@@ -18,15 +18,22 @@
 
 #include "maidsafe/vault_manager/vault_interface.h"
 
+#include <vector>
+
 #include "maidsafe/common/make_unique.h"
 #include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/process.h"
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/tcp/connection.h"
 
-#include "maidsafe/vault_manager/rpc_helper.h"
+#include "maidsafe/vault_manager/directory_sync.h"
+#include "maidsafe/vault_manager/rpc_multiplexer.h"
 #include "maidsafe/vault_manager/utils.h"
 #include "maidsafe/vault_manager/messages/joined_network.h"
+#include "maidsafe/vault_manager/messages/max_disk_usage_update.h"
+#include "maidsafe/vault_manager/messages/move_chunkstore_request.h"
+#include "maidsafe/vault_manager/messages/move_chunkstore_response.h"
+#include "maidsafe/vault_manager/messages/vault_heartbeat.h"
 #include "maidsafe/vault_manager/messages/vault_started.h"
 #include "maidsafe/vault_manager/messages/vault_started_response.h"
 
@@ -40,30 +47,131 @@ VaultInterface::VaultInterface(tcp::Port vault_manager_port)
     : exit_code_promise_(),
       exit_code_flag_(),
       vault_manager_port_(vault_manager_port),
-      on_vault_started_response_(),
+      config_mutex_(),
       vault_config_(),
+      next_subscription_id_(0),
+      max_disk_usage_subscriptions_(),
       asio_service_(1),
       strand_(asio_service_.service()),
+      rpcs_(RpcMultiplexer::MakeShared(asio_service_.service())),
       tcp_connection_(tcp::Connection::MakeShared(strand_, vault_manager_port_)),
-      connection_closer_([&] { tcp_connection_->Close(); }) {
+      connection_closer_([&] { tcp_connection_->Close(); }),
+      progress_probe_mutex_(),
+      progress_probe_(),
+      heartbeat_sequence_(0),
+      heartbeat_timer_(asio_service_.service()),
+      chunkstore_mutex_(),
+      move_chunkstore_functor_(),
+      chunkstore_dir_(),
+      chunkstore_move_() {
   tcp_connection_->Start(
       [this](tcp::Message message) { HandleReceivedMessage(std::move(message)); },
       [this] { OnConnectionClosed(); });
   LOG(kSuccess) << "Connected to VaultManager which is listening on port " << vault_manager_port_;
-  std::mutex mutex;
-  auto vault_config_future(SetResponseCallback<std::unique_ptr<VaultConfig>, VaultStartedResponse>(
-      on_vault_started_response_, asio_service_.service(), mutex));
-  Send(tcp_connection_, VaultStarted(process::GetProcessId()));
-  vault_config_ = vault_config_future.get();
+  auto vault_started(rpcs_->Add<std::unique_ptr<VaultConfig>>());
+  Send(tcp_connection_, VaultStarted(process::GetProcessId()), vault_started.first);
+  std::unique_ptr<VaultConfig> vault_config{vault_started.second.get()};
+  chunkstore_dir_ = vault_config->vault_dir;
+  {
+    std::lock_guard<std::mutex> lock{config_mutex_};
+    vault_config_ = std::move(vault_config);
+  }
   LOG(kSuccess) << "Retrieved config info from VaultManager";
+  asio_service_.service().post([this] { ScheduleHeartbeat(); });
+}
+
+VaultInterface::~VaultInterface() {
+  // Cancel on the heartbeat thread so that a handler can't be rescheduling the timer concurrently.
+  std::promise<void> cancelled;
+  asio_service_.service().post([&] {
+    std::error_code ignored_ec;
+    heartbeat_timer_.cancel(ignored_ec);
+    cancelled.set_value();
+  });
+  cancelled.get_future().wait();
 }
 
-VaultConfig VaultInterface::GetConfiguration() { return *vault_config_; }
+VaultConfig VaultInterface::GetConfiguration() {
+  std::lock_guard<std::mutex> lock{config_mutex_};
+  return *vault_config_;
+}
 
 int VaultInterface::WaitForExit() { return exit_code_promise_.get_future().get(); }
 
 void VaultInterface::SendJoined() { Send(tcp_connection_, JoinedNetwork()); }
 
+void VaultInterface::SetProgressProbe(std::function<uint64_t()> progress_probe) {
+  std::lock_guard<std::mutex> lock{progress_probe_mutex_};
+  progress_probe_ = std::move(progress_probe);
+}
+
+void VaultInterface::SetMoveChunkstoreFunctor(MoveChunkstoreFunctor functor) {
+  std::lock_guard<std::mutex> lock{chunkstore_mutex_};
+  move_chunkstore_functor_ = std::move(functor);
+}
+
+VaultInterface::SubscriptionId VaultInterface::SubscribeToMaxDiskUsage(
+    MaxDiskUsageFunctor functor) {
+  SubscriptionId subscription_id{0};
+  {
+    std::lock_guard<std::mutex> lock{config_mutex_};
+    subscription_id = next_subscription_id_++;
+    max_disk_usage_subscriptions_.insert(std::make_pair(subscription_id, std::move(functor)));
+  }
+  // Deliver the current value on this object's thread, so that it can't overtake an update.
+  asio_service_.service().post([=] { NotifyMaxDiskUsage(subscription_id); });
+  return subscription_id;
+}
+
+void VaultInterface::Unsubscribe(SubscriptionId subscription_id) {
+  std::lock_guard<std::mutex> lock{config_mutex_};
+  max_disk_usage_subscriptions_.erase(subscription_id);
+}
+
+void VaultInterface::NotifyMaxDiskUsage(SubscriptionId subscription_id) {
+  MaxDiskUsageFunctor functor;
+  DiskUsage max_disk_usage{0};
+  {
+    std::lock_guard<std::mutex> lock{config_mutex_};
+    auto itr(max_disk_usage_subscriptions_.find(subscription_id));
+    if (itr == std::end(max_disk_usage_subscriptions_))
+      return;
+    functor = itr->second;
+    max_disk_usage = vault_config_->max_disk_usage;
+  }
+  try {
+    functor(max_disk_usage);
+  } catch (const std::exception& e) {
+    LOG(kError) << "Max disk usage subscriber threw: " << boost::diagnostic_information(e);
+  }
+}
+
+void VaultInterface::ScheduleHeartbeat() {
+  if (!tcp_connection_)
+    return;
+  std::function<uint64_t()> progress_probe;
+  {
+    std::lock_guard<std::mutex> lock{progress_probe_mutex_};
+    progress_probe = progress_probe_;
+  }
+  uint64_t progress{0};
+  if (progress_probe) {
+    try {
+      progress = progress_probe();
+    } catch (const std::exception& e) {
+      LOG(kError) << "Error executing progress probe: " << boost::diagnostic_information(e);
+    }
+  }
+  Send(tcp_connection_, VaultHeartbeat(heartbeat_sequence_++, progress));
+
+  heartbeat_timer_.expires_from_now(kVaultHeartbeatInterval);
+  heartbeat_timer_.async_wait([this](const std::error_code& error_code) {
+    if (error_code)
+      return;
+    ScheduleHeartbeat();
+  });
+}
+
 void VaultInterface::OnConnectionClosed() {
   LOG(kError) << "Lost connection to Vault Manager";
   std::call_once(exit_code_flag_, [this] {
@@ -75,14 +183,22 @@ void VaultInterface::HandleReceivedMessage(tcp::Message&& message) {
   try {
     InputVectorStream binary_input_stream(std::move(message));
     MessageTag tag(static_cast<MessageTag>(-1));
-    Parse(binary_input_stream, tag);
+    CorrelationId correlation_id(0);
+    Parse(binary_input_stream, tag, correlation_id);
     switch (tag) {
       case MessageTag::kVaultStartedResponse:
-        HandleVaultStartedResponse(Parse<VaultStartedResponse>(binary_input_stream));
+        HandleVaultStartedResponse(correlation_id,
+                                   Parse<VaultStartedResponse>(binary_input_stream));
         break;
       case MessageTag::kVaultShutdownRequest:
         HandleVaultShutdownRequest();
         break;
+      case MessageTag::kMoveChunkstoreRequest:
+        HandleMoveChunkstoreRequest(Parse<MoveChunkstoreRequest>(binary_input_stream));
+        break;
+      case MessageTag::kMaxDiskUsageUpdate:
+        HandleMaxDiskUsageUpdate(Parse<MaxDiskUsageUpdate>(binary_input_stream));
+        break;
       default:
         return;
     }
@@ -91,11 +207,17 @@ void VaultInterface::HandleReceivedMessage(tcp::Message&& message) {
   }
 }
 
-void VaultInterface::HandleVaultStartedResponse(VaultStartedResponse&& vault_started_response) {
-  if (on_vault_started_response_)
-    on_vault_started_response_(std::move(vault_started_response));
-  else
-    assert(false);  // already received vault configuration
+void VaultInterface::HandleVaultStartedResponse(CorrelationId correlation_id,
+                                                VaultStartedResponse&& vault_started_response) {
+  bool expected{false};
+  try {
+    expected = rpcs_->SetValue(correlation_id, detail::GetValue(vault_started_response));
+  } catch (const std::exception& e) {
+    LOG(kError) << boost::diagnostic_information(e);
+    expected = rpcs_->SetException(correlation_id, std::current_exception());
+  }
+  if (!expected)
+    LOG(kError) << "Unexpected VaultStartedResponse; already received vault configuration.";
 }
 
 void VaultInterface::HandleVaultShutdownRequest() {
@@ -103,10 +225,71 @@ void VaultInterface::HandleVaultShutdownRequest() {
   std::call_once(exit_code_flag_, [this] { exit_code_promise_.set_value(0); });
 }
 
+void VaultInterface::HandleMoveChunkstoreRequest(MoveChunkstoreRequest&& move_chunkstore_request) {
+  fs::path new_vault_dir{move_chunkstore_request.new_vault_dir};
+  MoveChunkstoreFunctor functor;
+  {
+    std::lock_guard<std::mutex> lock{chunkstore_mutex_};
+    functor = move_chunkstore_functor_;
+  }
+  if (!functor) {
+    Send(tcp_connection_,
+         MoveChunkstoreResponse(new_vault_dir, MakeError(CommonErrors::unable_to_handle_request)));
+    return;
+  }
+  if (chunkstore_move_.valid())
+    chunkstore_move_.get();
+  // Run off this thread, which must stay free to send heartbeats while the vault is paused.
+  chunkstore_move_ = std::async(std::launch::async, [this, functor, new_vault_dir] {
+    maidsafe_error error{MakeError(CommonErrors::success)};
+    try {
+      fs::path old_vault_dir;
+      {
+        std::lock_guard<std::mutex> lock{chunkstore_mutex_};
+        old_vault_dir = chunkstore_dir_;
+      }
+      functor(new_vault_dir, [&] { SyncDirectory(old_vault_dir, new_vault_dir, 0, nullptr); });
+      {
+        std::lock_guard<std::mutex> lock{chunkstore_mutex_};
+        chunkstore_dir_ = new_vault_dir;
+      }
+      std::lock_guard<std::mutex> lock{config_mutex_};
+      vault_config_->vault_dir = new_vault_dir;
+    } catch (const maidsafe_error& e) {
+      LOG(kError) << "Failed to move chunkstore: " << boost::diagnostic_information(e);
+      error = e;
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to move chunkstore: " << boost::diagnostic_information(e);
+      error = MakeError(CommonErrors::unknown);
+    }
+    if (error.code() == make_error_code(CommonErrors::success))
+      Send(tcp_connection_, MoveChunkstoreResponse(new_vault_dir));
+    else
+      Send(tcp_connection_, MoveChunkstoreResponse(new_vault_dir, error));
+  });
+}
+
+void VaultInterface::HandleMaxDiskUsageUpdate(MaxDiskUsageUpdate&& max_disk_usage_update) {
+  std::vector<SubscriptionId> subscription_ids;
+  {
+    std::lock_guard<std::mutex> lock{config_mutex_};
+    if (!vault_config_ || vault_config_->max_disk_usage == max_disk_usage_update.usage)
+      return;
+    vault_config_->max_disk_usage = max_disk_usage_update.usage;
+    for (const auto& subscription : max_disk_usage_subscriptions_)
+      subscription_ids.push_back(subscription.first);
+  }
+  LOG(kInfo) << "Max disk usage changed to " << max_disk_usage_update.usage.data;
+  // Each functor is looked up afresh so that none is called after being unsubscribed.
+  for (const auto& subscription_id : subscription_ids)
+    NotifyMaxDiskUsage(subscription_id);
+}
+
 #ifdef TESTING
 void VaultInterface::KillConnection() {
   maidsafe::Sleep(std::chrono::seconds(1));
-  tcp_connection_.reset();
+  // Reset on the heartbeat thread, which also uses the connection.
+  asio_service_.service().post([this] { tcp_connection_.reset(); });
 }
 
 void VaultInterface::SendInvalidMessage() {
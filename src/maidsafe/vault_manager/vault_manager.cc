@@ -18,7 +18,12 @@
 
 #include "maidsafe/vault_manager/vault_manager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "boost/filesystem/operations.hpp"
@@ -32,9 +37,10 @@
 #include "maidsafe/common/tcp/connection.h"
 #include "maidsafe/common/tcp/listener.h"
 #include "maidsafe/passport/passport.h"
-#include "maidsafe/nfs/client/maid_client.h"
 
 #include "maidsafe/vault_manager/client_connections.h"
+#include "maidsafe/vault_manager/directory_sync.h"
+#include "maidsafe/vault_manager/disk_quota.h"
 #include "maidsafe/vault_manager/new_connections.h"
 #include "maidsafe/vault_manager/process_manager.h"
 #include "maidsafe/vault_manager/utils.h"
@@ -43,16 +49,30 @@
 #include "maidsafe/vault_manager/messages/joined_network.h"
 #include "maidsafe/vault_manager/messages/log_message.h"
 #include "maidsafe/vault_manager/messages/max_disk_usage_update.h"
+#include "maidsafe/vault_manager/messages/move_chunkstore_progress.h"
+#include "maidsafe/vault_manager/messages/move_chunkstore_request.h"
+#include "maidsafe/vault_manager/messages/move_chunkstore_response.h"
 #include "maidsafe/vault_manager/messages/network_stable_request.h"
 #include "maidsafe/vault_manager/messages/network_stable_response.h"
+#include "maidsafe/vault_manager/messages/resume_session_request.h"
+#include "maidsafe/vault_manager/messages/session_ticket.h"
 #include "maidsafe/vault_manager/messages/set_network_as_stable.h"
+#include "maidsafe/vault_manager/messages/set_vault_resource_limits_request.h"
+#include "maidsafe/vault_manager/messages/set_vault_resource_limits_response.h"
 #include "maidsafe/vault_manager/messages/start_vault_request.h"
+#include "maidsafe/vault_manager/messages/start_vaults_request.h"
+#include "maidsafe/vault_manager/messages/take_ownership_batch_request.h"
 #include "maidsafe/vault_manager/messages/take_ownership_request.h"
 #include "maidsafe/vault_manager/messages/validate_connection_request.h"
+#include "maidsafe/vault_manager/messages/vault_heartbeat.h"
+#include "maidsafe/vault_manager/messages/vault_resource_usage_request.h"
+#include "maidsafe/vault_manager/messages/vault_resource_usage_response.h"
 #include "maidsafe/vault_manager/messages/vault_running_response.h"
 #include "maidsafe/vault_manager/messages/vault_shutdown_request.h"
 #include "maidsafe/vault_manager/messages/vault_started.h"
 #include "maidsafe/vault_manager/messages/vault_started_response.h"
+#include "maidsafe/vault_manager/messages/vault_status_request.h"
+#include "maidsafe/vault_manager/messages/vault_status_response.h"
 
 namespace fs = boost::filesystem;
 
@@ -72,6 +92,8 @@ fs::path GetPath(const fs::path& p) {
 
 fs::path GetConfigFilePath() { return GetPath(kConfigFilename); }
 
+fs::path GetKeyPoolFilePath() { return GetPath(kKeyPoolFilename); }
+
 fs::path GetVaultDir(const std::string& debug_id) { return GetPath(debug_id); }
 
 fs::path GetVaultExecutablePath() {
@@ -82,87 +104,139 @@ fs::path GetVaultExecutablePath() {
   return process::GetOtherExecutablePath(fs::path{"vault"});
 }
 
-void PutPmidAndSigner(const passport::PmidAndSigner& pmid_and_signer) {
-  std::shared_ptr<nfs_client::MaidClient> client_nfs(
-      nfs_client::MaidClient::MakeShared(passport::MaidAndSigner{passport::CreateMaidAndSigner()}));
-  client_nfs->Put(passport::PublicPmid{pmid_and_signer.first}).get();
-  client_nfs->Put(passport::PublicAnpmid{pmid_and_signer.second}).get();
-  client_nfs->Stop();
+uint32_t WorkerThreadCount() {
+  return std::max(2U, std::thread::hardware_concurrency());
+}
+
+// Runs 'handler' via 'strand'.  Handlers throw on bad input from peers, and an exception escaping
+// the strand would take down the thread running it, so any thrown is logged instead.
+template <typename Functor>
+void PostHandler(asio::io_service::strand& strand, Functor handler) {
+  strand.post([handler] {
+    try {
+      handler();
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to handle incoming message: " << boost::diagnostic_information(e);
+    }
+  });
+}
+
+// Parses a 'MessageType' from 'input', then passes it to 'handler' via 'strand'.
+template <typename MessageType, typename Handler>
+void ParseAndPost(InputVectorStream& input, asio::io_service::strand& strand,
+                  tcp::ConnectionPtr connection, Handler* handler_object,
+                  void (Handler::*handler)(tcp::ConnectionPtr, MessageType&&)) {
+  auto message(std::make_shared<MessageType>(Parse<MessageType>(input)));
+  PostHandler(strand, [=] { (handler_object->*handler)(connection, std::move(*message)); });
+}
+
+// As above, for requests which need their 'correlation_id' echoed in the response.
+template <typename MessageType, typename Handler>
+void ParseAndPost(InputVectorStream& input, asio::io_service::strand& strand,
+                  tcp::ConnectionPtr connection, CorrelationId correlation_id,
+                  Handler* handler_object,
+                  void (Handler::*handler)(tcp::ConnectionPtr, CorrelationId, MessageType&&)) {
+  auto message(std::make_shared<MessageType>(Parse<MessageType>(input)));
+  PostHandler(strand, [=] {
+    (handler_object->*handler)(connection, correlation_id, std::move(*message));
+  });
 }
 
 }  // unnamed namespace
 
-VaultManager::VaultManager()
+VaultManager::VaultManager(uint32_t thread_count)
     : config_file_handler_(GetConfigFilePath()),
+      key_pool_(GetKeyPoolFilePath(), config_file_handler_.SymmKey(), config_file_handler_.SymmIv(),
+                kKeyPoolSize),
       network_stable_(false),
       tear_down_with_interval_(false),
-      asio_service_(1),
+      stopping_(false),
+      asio_service_(thread_count == 0 ? WorkerThreadCount() : thread_count),
       strand_(asio_service_.service()),
       listener_(tcp::Listener::MakeShared(
           strand_, [this](tcp::ConnectionPtr connection) { HandleNewConnection(connection); },
           GetInitialListeningPort())),
-      process_manager_(ProcessManager::MakeShared(asio_service_.service(), GetVaultExecutablePath(),
+      process_manager_(ProcessManager::MakeShared(strand_, GetVaultExecutablePath(),
                                                   listener_->ListeningPort())),
       client_connections_(ClientConnections::MakeShared(asio_service_.service())),
-      new_connections_(NewConnections::MakeShared(asio_service_.service())) {
+      new_connections_(NewConnections::MakeShared(asio_service_.service())),
+      pmid_publisher_(),
+      session_tickets_(),
+      chunkstore_moves_(),
+      disk_quota_timer_(asio_service_.service()),
+      disk_quotas_(),
+      uncommitted_vaults_(),
+      worker_service_(WorkerThreadCount()) {
   std::vector<VaultInfo> vaults{config_file_handler_.ReadConfigFile()};
   if (vaults.empty()) {
 #ifndef TESTING
     VaultInfo vault_info;
-    vault_info.pmid_and_signer =
-        std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner());
-    // Try infinitely to put PmidAndSigner for a new Vault
-    bool stored_pmid_and_signer(false);
-    do {
-      try {
-        PutPmidAndSigner(*vault_info.pmid_and_signer);
-        stored_pmid_and_signer = true;
-        LOG(kSuccess) << "Put PmidAndSigner Successfully";
-      } catch (const std::exception& e) {
-        LOG(kError) << " Failed to put PmidAndSigner : " << boost::diagnostic_information(e);
-      }
-    } while (!stored_pmid_and_signer);
-
-    vault_info.vault_dir = GetVaultDir(DebugId(vault_info.pmid_and_signer->first.name().value));
-    if (!fs::exists(vault_info.vault_dir))
-      fs::create_directories(vault_info.vault_dir);
-    auto space_info(fs::space(vault_info.vault_dir));
-    vault_info.max_disk_usage = DiskUsage{(9 * space_info.available) / 10};
     vault_info.label = GenerateLabel();
-    process_manager_->AddProcess(std::move(vault_info));
-    LOG(kSuccess) << "Vault process handed over to process manager.";
-    config_file_handler_.WriteConfigFile(process_manager_->GetAll());
+    StartVaultAsync(std::move(vault_info), nullptr);
 #endif
   } else {
-    for (auto& vault_info : vaults)
-      process_manager_->AddProcess(std::move(vault_info));
+    // The event loop is already running, so the vaults are restored on strand_ like any other
+    // change to process_manager_.
+    std::promise<void> restored;
+    strand_.post([this, &vaults, &restored] {
+      try {
+        for (auto& vault_info : vaults) {
+          int32_t numa_node{vault_info.numa_node};
+          VaultInfo added_vault{process_manager_->AddProcess(std::move(vault_info))};
+          // Persist the placement of vaults which hadn't been placed, or whose node no longer
+          // exists.
+          if (added_vault.numa_node != numa_node)
+            config_file_handler_.UpdateVault(added_vault);
+        }
+        restored.set_value();
+      } catch (const std::exception&) {
+        restored.set_exception(std::current_exception());
+      }
+    });
+    restored.get_future().get();
   }
+  strand_.dispatch([this] { ScheduleDiskQuotaUpdate(); });
   LOG(kInfo) << "VaultManager started";
 }
 
 void VaultManager::TearDownWithInterval() {
   tear_down_with_interval_ = true;
+  stopping_ = true;
+  pmid_publisher_.Stop();
+  worker_service_.Stop();
   auto listener(listener_);
   auto new_connections(new_connections_);
   auto client_connections(client_connections_);
   auto process_manager(process_manager_);
-  auto future(std::async(std::launch::async, [=] {
+  std::promise<std::shared_future<void>> stop_all;
+  strand_.post([=, &stop_all] {
+    std::error_code ignored;
+    disk_quota_timer_.cancel(ignored);
     listener->StopListening();
     new_connections->CloseAll();
     client_connections->CloseAll();
-    process_manager->StopAllWithInterval();
-  }));
-  future.get();
+    stop_all.set_value(process_manager->StopAll(
+        kMaxConcurrentVaultStops, std::chrono::seconds(5),
+        [](std::size_t stopped, std::size_t total) {
+          TLOG(kDefaultColour) << "stopped " << stopped << " of " << total << " vaults\n";
+        }));
+  });
+  stop_all.get_future().get().wait();
   asio_service_.Stop();
 }
 
 VaultManager::~VaultManager() {
   if (!tear_down_with_interval_) {
+    stopping_ = true;
+    pmid_publisher_.Stop();
+    worker_service_.Stop();
     auto listener(listener_);
     auto new_connections(new_connections_);
     auto client_connections(client_connections_);
     auto process_manager(process_manager_);
-    asio_service_.service().post([=] {
+    strand_.post([=] {
+      std::error_code ignored;
+      disk_quota_timer_.cancel(ignored);
       listener->StopListening();
       new_connections->CloseAll();
       client_connections->CloseAll();
@@ -174,12 +248,28 @@ VaultManager::~VaultManager() {
 
 void VaultManager::HandleNewConnection(tcp::ConnectionPtr connection) {
   new_connections_->Add(connection);
-  tcp::MessageReceivedFunctor on_message{
-      [=](tcp::Message message) { HandleReceivedMessage(connection, std::move(message)); }};
-  connection->Start(on_message, [=] { HandleConnectionClosed(connection); });
+  // Each connection's messages are parsed in order on its own strand, so connections don't hold
+  // each other up.  Its closure goes via the same strand so as not to overtake its messages.
+  auto connection_strand(std::make_shared<asio::io_service::strand>(asio_service_.service()));
+  tcp::MessageReceivedFunctor on_message{[=](tcp::Message message) {
+    auto shared_message(std::make_shared<tcp::Message>(std::move(message)));
+    connection_strand->post(
+        [=] { HandleReceivedMessage(connection, std::move(*shared_message)); });
+  }};
+  connection->Start(on_message, [=] {
+    connection_strand->post(
+        [=] { PostHandler(strand_, [=] { HandleConnectionClosed(connection); }); });
+  });
 }
 
 void VaultManager::HandleConnectionClosed(tcp::ConnectionPtr connection) {
+  for (auto itr(std::begin(chunkstore_moves_)); itr != std::end(chunkstore_moves_); ++itr) {
+    if (itr->second.vault_connection == connection) {
+      // The vault may or may not have switched directories, so leave both in place.
+      FailChunkstoreMove(itr, MakeError(VaultManagerErrors::connection_aborted), false);
+      break;
+    }
+  }
   if (process_manager_->HandleConnectionClosed(connection) ||
       client_connections_->Remove(connection)) {
     return;
@@ -188,38 +278,80 @@ void VaultManager::HandleConnectionClosed(tcp::ConnectionPtr connection) {
 }
 
 void VaultManager::HandleReceivedMessage(tcp::ConnectionPtr connection, tcp::Message&& message) {
+  // This runs on the connection's own strand.  Messages are parsed here, then handled on strand_
+  // (except where noted), so that only the handling of one message at a time is serialised.
   try {
     InputVectorStream binary_input_stream(std::move(message));
     MessageTag tag(static_cast<MessageTag>(-1));
-    Parse(binary_input_stream, tag);
+    CorrelationId correlation_id(0);
+    Parse(binary_input_stream, tag, correlation_id);
     switch (tag) {
       case MessageTag::kValidateConnectionRequest:
-        HandleValidateConnectionRequest(connection);
+        PostHandler(strand_, [=] { HandleValidateConnectionRequest(connection, correlation_id); });
         break;
       case MessageTag::kChallengeResponse:
+        // Handled here, since checking the signature is expensive and client_connections_ is
+        // thread-safe.
         HandleChallengeResponse(connection, Parse<ChallengeResponse>(binary_input_stream));
         break;
+      case MessageTag::kResumeSessionRequest:
+        // Handled here for the same reason.
+        HandleResumeSessionRequest(connection, correlation_id,
+                                   Parse<ResumeSessionRequest>(binary_input_stream));
+        break;
       case MessageTag::kStartVaultRequest:
-        HandleStartVaultRequest(connection, Parse<StartVaultRequest>(binary_input_stream));
+        ParseAndPost(binary_input_stream, strand_, connection, this,
+                     &VaultManager::HandleStartVaultRequest);
+        break;
+      case MessageTag::kStartVaultsRequest:
+        ParseAndPost(binary_input_stream, strand_, connection, this,
+                     &VaultManager::HandleStartVaultsRequest);
         break;
       case MessageTag::kTakeOwnershipRequest:
-        HandleTakeOwnershipRequest(connection, Parse<TakeOwnershipRequest>(binary_input_stream));
+        ParseAndPost(binary_input_stream, strand_, connection, this,
+                     &VaultManager::HandleTakeOwnershipRequest);
+        break;
+      case MessageTag::kTakeOwnershipBatchRequest:
+        ParseAndPost(binary_input_stream, strand_, connection, this,
+                     &VaultManager::HandleTakeOwnershipBatchRequest);
+        break;
+      case MessageTag::kVaultStatusRequest:
+        ParseAndPost(binary_input_stream, strand_, connection, correlation_id, this,
+                     &VaultManager::HandleVaultStatusRequest);
+        break;
+      case MessageTag::kSetVaultResourceLimitsRequest:
+        ParseAndPost(binary_input_stream, strand_, connection, correlation_id, this,
+                     &VaultManager::HandleSetVaultResourceLimitsRequest);
+        break;
+      case MessageTag::kVaultResourceUsageRequest:
+        ParseAndPost(binary_input_stream, strand_, connection, correlation_id, this,
+                     &VaultManager::HandleVaultResourceUsageRequest);
         break;
       case MessageTag::kVaultStarted:
-        HandleVaultStarted(connection, Parse<VaultStarted>(binary_input_stream));
+        ParseAndPost(binary_input_stream, strand_, connection, correlation_id, this,
+                     &VaultManager::HandleVaultStarted);
         break;
       case MessageTag::kJoinedNetwork:
-        HandleJoinedNetwork(connection);
+        PostHandler(strand_, [=] { HandleJoinedNetwork(connection); });
+        break;
+      case MessageTag::kMoveChunkstoreResponse:
+        ParseAndPost(binary_input_stream, strand_, connection, this,
+                     &VaultManager::HandleMoveChunkstoreResponse);
+        break;
+      case MessageTag::kVaultHeartbeat:
+        ParseAndPost(binary_input_stream, strand_, connection, this,
+                     &VaultManager::HandleVaultHeartbeat);
         break;
 #ifdef TESTING
       case MessageTag::kSetNetworkAsStable:
-        HandleSetNetworkAsStable();
+        PostHandler(strand_, [=] { HandleSetNetworkAsStable(); });
         break;
       case MessageTag::kNetworkStableRequest:
-        HandleNetworkStableRequest(connection);
+        PostHandler(strand_, [=] { HandleNetworkStableRequest(connection); });
         break;
 #endif
       case MessageTag::kLogMessage:
+        // Handled here, only looking up the vault's owner on strand_.
         HandleLogMessage(connection, Parse<LogMessage>(binary_input_stream));
         break;
       default:
@@ -230,27 +362,63 @@ void VaultManager::HandleReceivedMessage(tcp::ConnectionPtr connection, tcp::Mes
   }
 }
 
-void VaultManager::HandleValidateConnectionRequest(tcp::ConnectionPtr connection) {
+void VaultManager::HandleValidateConnectionRequest(tcp::ConnectionPtr connection,
+                                                   CorrelationId correlation_id) {
   RemoveFromNewConnections(connection);
   asymm::PlainText plain_text{RandomString((RandomUint32() % 100) + 100)};
 
   client_connections_->Add(connection, plain_text);
-  Send(connection, Challenge(std::move(plain_text)));
+  Send(connection, Challenge(std::move(plain_text)), correlation_id);
 }
 
 void VaultManager::HandleChallengeResponse(tcp::ConnectionPtr connection,
                                            ChallengeResponse&& challenge_response) {
+  crypto::AES256Key session_key{RandomString(crypto::AES256_KeySize)};
   client_connections_->Validate(connection, *challenge_response.public_maid,
-                                challenge_response.signature);
+                                challenge_response.signature, session_key);
+  SessionTicket session_ticket{
+      session_tickets_.Issue(challenge_response.public_maid->name(), session_key)};
+  session_ticket.encrypted_session_key = asymm::Encrypt(
+      asymm::PlainText{session_key.string()}, challenge_response.public_maid->public_key());
+  Send(connection, std::move(session_ticket));
+}
+
+void VaultManager::HandleResumeSessionRequest(tcp::ConnectionPtr connection,
+                                              CorrelationId correlation_id,
+                                              ResumeSessionRequest&& request) {
+  asymm::PlainText challenge{client_connections_->GetChallenge(connection)};
+  SessionTickets::Redeemed redeemed;
+  try {
+    redeemed = session_tickets_.Redeem(request.ticket, challenge, request.proof);
+  } catch (const maidsafe_error& e) {
+    LOG(kInfo) << "Rejected session ticket: " << boost::diagnostic_information(e);
+    // Let the client fall back to signing the challenge.
+    Send(connection, Challenge(std::move(challenge)), correlation_id);
+    return;
+  }
+  client_connections_->ValidateResumed(connection, redeemed.maid_name, redeemed.session_key);
+  Send(connection, session_tickets_.Issue(redeemed.maid_name, redeemed.session_key),
+       correlation_id);
 }
 
 
 void VaultManager::HandleStartVaultRequest(tcp::ConnectionPtr connection,
                                            StartVaultRequest&& start_vault_request) {
+  StartVault(connection, std::move(start_vault_request));
+}
+
+void VaultManager::HandleStartVaultsRequest(tcp::ConnectionPtr connection,
+                                            StartVaultsRequest&& start_vaults_request) {
+  for (auto& start_vault_request : start_vaults_request.vaults)
+    StartVault(connection, std::move(start_vault_request));
+}
+
+void VaultManager::StartVault(tcp::ConnectionPtr client,
+                              StartVaultRequest&& start_vault_request) {
   maidsafe_error error{MakeError(CommonErrors::unknown)};
   VaultInfo vault_info;
   try {
-    passport::PublicMaid::Name client_name{client_connections_->FindValidated(connection)};
+    passport::PublicMaid::Name client_name{client_connections_->FindValidated(client)};
     vault_info.label = std::move(start_vault_request.vault_label);
     vault_info.max_disk_usage = start_vault_request.max_disk_usage;
     vault_info.owner_name = client_name;
@@ -260,18 +428,7 @@ void VaultManager::HandleStartVaultRequest(tcp::ConnectionPtr connection,
           GetPmidAndSigner(*start_vault_request.pmid_list_index));
     }
 #endif
-    if (!vault_info.pmid_and_signer) {
-      vault_info.pmid_and_signer =
-          std::make_shared<passport::PmidAndSigner>(passport::CreatePmidAndSigner());
-      PutPmidAndSigner(*vault_info.pmid_and_signer);
-    }
-    if (start_vault_request.vault_dir.empty()) {
-      vault_info.vault_dir = GetVaultDir(DebugId(vault_info.pmid_and_signer->first.name().value));
-      if (!fs::exists(vault_info.vault_dir))
-        fs::create_directories(vault_info.vault_dir);
-    } else {
-      vault_info.vault_dir = std::move(start_vault_request.vault_dir);
-    }
+    vault_info.vault_dir = std::move(start_vault_request.vault_dir);
 #ifdef USE_VLOGGING
     vault_info.vlog_session_id = std::move(start_vault_request.vlog_session_id);
 #ifdef TESTING
@@ -279,8 +436,87 @@ void VaultManager::HandleStartVaultRequest(tcp::ConnectionPtr connection,
         start_vault_request.send_hostname_to_visualiser_server;
 #endif
 #endif
-    process_manager_->AddProcess(std::move(vault_info));
-    config_file_handler_.WriteConfigFile(process_manager_->GetAll());
+    StartVaultAsync(std::move(vault_info), client);
+    return;
+  } catch (const maidsafe_error& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+    error = e;
+  } catch (const std::exception& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+  }
+  SendStartVaultError(client, std::move(vault_info.label), std::move(error));
+}
+
+void VaultManager::StartVaultAsync(VaultInfo vault_info, tcp::ConnectionPtr client) {
+  if (vault_info.pmid_and_signer) {
+    worker_service_.service().post(
+        [this, vault_info, client] { PrepareVaultDir(vault_info, client); });
+    return;
+  }
+
+  worker_service_.service().post([this, vault_info, client]() mutable {
+    maidsafe_error error{MakeError(CommonErrors::unknown)};
+    try {
+      vault_info.pmid_and_signer =
+          std::make_shared<passport::PmidAndSigner>(key_pool_.Get(&vault_info.encrypted_keys));
+      pmid_publisher_.Publish(vault_info.pmid_and_signer, !client,
+                              [this, vault_info, client](maidsafe_error publish_error) {
+        if (publish_error.code() == make_error_code(CommonErrors::success)) {
+          worker_service_.service().post(
+              [this, vault_info, client] { PrepareVaultDir(vault_info, client); });
+        } else {
+          NonEmptyString label{vault_info.label};
+          strand_.post([this, client, label, publish_error] {
+            SendStartVaultError(client, label, publish_error);
+          });
+        }
+      });
+      return;
+    } catch (const maidsafe_error& e) {
+      LOG(kWarning) << boost::diagnostic_information(e);
+      error = e;
+    } catch (const std::exception& e) {
+      LOG(kWarning) << boost::diagnostic_information(e);
+    }
+    NonEmptyString label{vault_info.label};
+    strand_.post([this, client, label, error] { SendStartVaultError(client, label, error); });
+  });
+}
+
+void VaultManager::PrepareVaultDir(VaultInfo vault_info, tcp::ConnectionPtr client) {
+  maidsafe_error error{MakeError(CommonErrors::unknown)};
+  try {
+    if (vault_info.vault_dir.empty()) {
+      vault_info.vault_dir = GetVaultDir(DebugId(vault_info.pmid_and_signer->first.name().value));
+      if (!fs::exists(vault_info.vault_dir))
+        fs::create_directories(vault_info.vault_dir);
+    }
+    if (!client) {
+      auto space_info(fs::space(vault_info.vault_dir));
+      vault_info.max_disk_usage = DiskUsage{(9 * space_info.available) / 10};
+    }
+    strand_.post([this, vault_info, client] { HandleVaultPrepared(vault_info, client); });
+    return;
+  } catch (const maidsafe_error& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+    error = e;
+  } catch (const std::exception& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+  }
+  NonEmptyString label{vault_info.label};
+  strand_.post([this, client, label, error] { SendStartVaultError(client, label, error); });
+}
+
+void VaultManager::HandleVaultPrepared(VaultInfo vault_info, tcp::ConnectionPtr client) {
+  if (stopping_)
+    return;
+  maidsafe_error error{MakeError(CommonErrors::unknown)};
+  NonEmptyString label{vault_info.label};
+  try {
+    VaultInfo added_vault{process_manager_->AddProcess(vault_info)};
+    LOG(kSuccess) << "Vault process handed over to process manager.";
+    // The owner isn't told the vault is running until it's on disk; see HandleVaultStarted.
+    uncommitted_vaults_[label.string()] = config_file_handler_.AddVault(added_vault).share();
     return;
   } catch (const maidsafe_error& e) {
     LOG(kWarning) << boost::diagnostic_information(e);
@@ -288,16 +524,112 @@ void VaultManager::HandleStartVaultRequest(tcp::ConnectionPtr connection,
   } catch (const std::exception& e) {
     LOG(kWarning) << boost::diagnostic_information(e);
   }
-  LOG(kError) << "VaultManager::HandleStartVaultRequest reporting error";
-  Send(connection, VaultRunningResponse(std::move(vault_info.label), std::move(error)));
+  SendStartVaultError(client, std::move(label), std::move(error));
+}
+
+void VaultManager::SendStartVaultError(tcp::ConnectionPtr client, NonEmptyString label,
+                                       maidsafe_error error) {
+  LOG(kError) << "VaultManager failed to start vault " << label.string();
+  if (client)
+    Send(client, VaultRunningResponse(std::move(label), std::move(error)));
+}
+
+void VaultManager::ScheduleDiskQuotaUpdate() {
+  disk_quota_timer_.expires_from_now(kDiskQuotaInterval);
+  disk_quota_timer_.async_wait(strand_.wrap([this](const std::error_code& error_code) {
+    if (error_code || stopping_)
+      return;
+    MeasureDiskUsage();
+  }));
+}
+
+void VaultManager::MeasureDiskUsage() {
+  std::vector<VaultInfo> vaults{process_manager_->GetAll()};
+  worker_service_.service().post([this, vaults] {
+    std::vector<VaultDiskUsage> usages;
+    std::map<uint64_t, FilesystemSpace> filesystems;
+    for (const auto& vault_info : vaults) {
+      try {
+        VaultDiskUsage usage{vault_info.label.string(), FilesystemId(vault_info.vault_dir),
+                             DirectorySize(vault_info.vault_dir), vault_info.max_disk_usage.data};
+        if (filesystems.count(usage.filesystem) == 0) {
+          fs::space_info space_info(fs::space(vault_info.vault_dir));
+          filesystems[usage.filesystem] = FilesystemSpace{space_info.capacity,
+                                                          space_info.available};
+        }
+        usages.push_back(std::move(usage));
+      } catch (const std::exception& e) {
+        // The vault's directory may not exist yet, or may be being moved.
+        LOG(kWarning) << "Failed to measure disk usage of vault " << vault_info.label.string()
+                      << ": " << boost::diagnostic_information(e);
+      }
+    }
+    std::map<std::string, uint64_t> quotas{ComputeDiskQuotas(usages, filesystems)};
+    strand_.post([this, quotas] {
+      if (!stopping_)
+        ApplyDiskQuotas(quotas);
+    });
+  });
+}
+
+void VaultManager::ApplyDiskQuotas(const std::map<std::string, uint64_t>& quotas) {
+  std::map<std::string, DiskUsage> previous_quotas;
+  previous_quotas.swap(disk_quotas_);
+  for (const auto& quota : quotas) {
+    VaultInfo vault_info;
+    try {
+      vault_info = process_manager_->Find(NonEmptyString{quota.first});
+    } catch (const std::exception&) {
+      continue;  // The vault was removed while being measured.
+    }
+    // Skip vaults whose chunkstore is being moved; they're measured again after the move.
+    if (chunkstore_moves_.count(quota.first) != 0)
+      continue;
+    DiskUsage new_quota{quota.second};
+    disk_quotas_.insert(std::make_pair(quota.first, new_quota));
+    auto previous(previous_quotas.find(quota.first));
+    DiskUsage old_quota{previous == std::end(previous_quotas) ? vault_info.max_disk_usage
+                                                               : previous->second};
+    // A vault which isn't connected gets its quota when it next starts.
+    if (vault_info.tcp_connection && old_quota != new_quota && new_quota != 0U) {
+      LOG(kInfo) << "Changing disk quota of vault " << quota.first << " to " << quota.second;
+      Send(vault_info.tcp_connection, MaxDiskUsageUpdate(new_quota));
+    }
+  }
+  ScheduleDiskQuotaUpdate();
+}
+
+DiskUsage VaultManager::DiskQuota(const NonEmptyString& label, DiskUsage limit) const {
+  auto itr(disk_quotas_.find(label.string()));
+  if (itr == std::end(disk_quotas_) || (limit != 0U && limit.data < itr->second.data))
+    return limit;
+  return itr->second;
 }
 
 void VaultManager::HandleTakeOwnershipRequest(tcp::ConnectionPtr connection,
                                               TakeOwnershipRequest&& take_ownership_request) {
+  NonEmptyString label{take_ownership_request.vault_label};
+  if (TakeOwnership(connection, std::move(take_ownership_request)))
+    ConfirmOwnership(connection, label);
+}
+
+void VaultManager::HandleTakeOwnershipBatchRequest(tcp::ConnectionPtr connection,
+                                                   TakeOwnershipBatchRequest&& request) {
+  std::vector<NonEmptyString> labels;
+  for (auto& take_ownership_request : request.vaults) {
+    NonEmptyString label{take_ownership_request.vault_label};
+    if (TakeOwnership(connection, std::move(take_ownership_request)))
+      labels.push_back(std::move(label));
+  }
+  if (!labels.empty())
+    ConfirmOwnership(connection, labels);
+}
+
+bool VaultManager::TakeOwnership(tcp::ConnectionPtr client,
+                                 TakeOwnershipRequest&& take_ownership_request) {
   maidsafe_error error{MakeError(CommonErrors::unknown)};
-  VaultInfo vault_info;
   try {
-    passport::PublicMaid::Name client_name{client_connections_->FindValidated(connection)};
+    passport::PublicMaid::Name client_name{client_connections_->FindValidated(client)};
 
     NonEmptyString label{take_ownership_request.vault_label};
     fs::path new_vault_dir{take_ownership_request.vault_dir};
@@ -308,16 +640,80 @@ void VaultManager::HandleTakeOwnershipRequest(tcp::ConnectionPtr connection,
       vault_info.vault_dir = new_vault_dir;
       vault_info.max_disk_usage = new_max_disk_usage;
       vault_info.owner_name = client_name;
-      return ChangeChunkstorePath(std::move(vault_info));
+      ChangeChunkstorePath(std::move(vault_info), client);
+      return false;
     }
 
-    if (vault_info.max_disk_usage != new_max_disk_usage && new_max_disk_usage != 0U)
-      Send(vault_info.tcp_connection, MaxDiskUsageUpdate(new_max_disk_usage));
+    // The vault may not be connected, e.g. if it's backing off after a crash.  It'll get the new
+    // limit when it next starts.
+    DiskUsage old_quota{DiskQuota(label, vault_info.max_disk_usage)};
+    DiskUsage new_quota{DiskQuota(label, new_max_disk_usage)};
+    if (vault_info.tcp_connection && old_quota != new_quota && new_quota != 0U)
+      Send(vault_info.tcp_connection, MaxDiskUsageUpdate(new_quota));
 
     process_manager_->AssignOwner(label, client_name, new_max_disk_usage);
-    config_file_handler_.WriteConfigFile(process_manager_->GetAll());
+    return true;
+  } catch (const maidsafe_error& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+    error = e;
+  } catch (const std::exception& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+  }
+  Send(client, VaultRunningResponse(std::move(take_ownership_request.vault_label),
+                                    std::move(error)));
+  return false;
+}
+
+void VaultManager::HandleVaultStatusRequest(tcp::ConnectionPtr connection,
+                                            CorrelationId correlation_id,
+                                            VaultStatusRequest&& vault_status_request) {
+  maidsafe_error error{MakeError(CommonErrors::unknown)};
+  try {
+    client_connections_->FindValidated(connection);
+    VaultStatus status{process_manager_->GetStatus(vault_status_request.vault_label)};
+    Send(connection, VaultStatusResponse(vault_status_request.vault_label, status),
+         correlation_id);
+    return;
+  } catch (const maidsafe_error& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+    error = e;
+  } catch (const std::exception& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+  }
+  Send(connection, VaultStatusResponse(std::move(vault_status_request.vault_label), error),
+       correlation_id);
+}
+
+void VaultManager::HandleSetVaultResourceLimitsRequest(tcp::ConnectionPtr connection,
+                                                       CorrelationId correlation_id,
+                                                       SetVaultResourceLimitsRequest&& request) {
+  maidsafe_error error{MakeError(CommonErrors::unknown)};
+  try {
+    client_connections_->FindValidated(connection);
+    process_manager_->SetResourceLimits(request.vault_label, request.limits);
     Send(connection,
-         VaultRunningResponse(std::move(label), std::move(*vault_info.pmid_and_signer)));
+         SetVaultResourceLimitsResponse(request.vault_label, std::move(request.limits)),
+         correlation_id);
+    return;
+  } catch (const maidsafe_error& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+    error = e;
+  } catch (const std::exception& e) {
+    LOG(kWarning) << boost::diagnostic_information(e);
+  }
+  Send(connection, SetVaultResourceLimitsResponse(std::move(request.vault_label), error),
+       correlation_id);
+}
+
+void VaultManager::HandleVaultResourceUsageRequest(tcp::ConnectionPtr connection,
+                                                   CorrelationId correlation_id,
+                                                   VaultResourceUsageRequest&& request) {
+  maidsafe_error error{MakeError(CommonErrors::unknown)};
+  try {
+    client_connections_->FindValidated(connection);
+    auto samples(process_manager_->GetResourceUsage(request.vault_label));
+    Send(connection, VaultResourceUsageResponse(request.vault_label, std::move(samples)),
+         correlation_id);
     return;
   } catch (const maidsafe_error& e) {
     LOG(kWarning) << boost::diagnostic_information(e);
@@ -325,22 +721,298 @@ void VaultManager::HandleTakeOwnershipRequest(tcp::ConnectionPtr connection,
   } catch (const std::exception& e) {
     LOG(kWarning) << boost::diagnostic_information(e);
   }
-  Send(connection, VaultRunningResponse(std::move(vault_info.label), std::move(error)));
+  Send(connection, VaultResourceUsageResponse(std::move(request.vault_label), error),
+       correlation_id);
 }
 
-void VaultManager::ChangeChunkstorePath(VaultInfo vault_info) {
-  // TODO(Fraser#5#): 2014-05-13 - Handle sending a "MoveChunkstoreRequest" to avoid stopping then
-  //                               restarting the vault.
-  Send(vault_info.tcp_connection, VaultShutdownRequest());
-  ProcessManager::OnExitFunctor on_exit{
-      [this, vault_info](maidsafe_error /*error*/, int /*exit_code*/) {
-        process_manager_->AddProcess(std::move(vault_info));
-        config_file_handler_.WriteConfigFile(process_manager_->GetAll());
-      }};
-  process_manager_->StopProcess(vault_info.tcp_connection, on_exit);
+std::shared_future<void> VaultManager::ConfirmOwnership(
+    tcp::ConnectionPtr client, const std::vector<NonEmptyString>& labels) {
+  std::vector<VaultInfo> vaults;
+  for (const auto& label : labels)
+    vaults.push_back(process_manager_->Find(label));
+  std::shared_future<void> committed{config_file_handler_.UpdateVaults(vaults).share()};
+  // Only confirm the new owner once it's on disk, waiting for that off the event loop.
+  std::vector<std::pair<NonEmptyString, std::shared_ptr<passport::PmidAndSigner>>> confirmations;
+  for (const auto& vault_info : vaults)
+    confirmations.emplace_back(vault_info.label, vault_info.pmid_and_signer);
+  WhenCommitted(committed, [this, client, confirmations](maidsafe_error commit_error) {
+    if (commit_error.code() != make_error_code(CommonErrors::success)) {
+      for (const auto& confirmation : confirmations)
+        Send(client, VaultRunningResponse(confirmation.first, commit_error));
+      return;
+    }
+    try {
+      crypto::AES256Key session_key{client_connections_->FindSessionKey(client)};
+      for (const auto& confirmation : confirmations)
+        Send(client, VaultRunningResponse(confirmation.first, *confirmation.second, session_key));
+    } catch (const std::exception& e) {
+      LOG(kWarning) << "Can't confirm ownership: " << boost::diagnostic_information(e);
+    }
+  });
+  return committed;
 }
 
-void VaultManager::HandleVaultStarted(tcp::ConnectionPtr connection, VaultStarted&& vault_started) {
+void VaultManager::WhenCommitted(std::shared_future<void> committed,
+                                 std::function<void(maidsafe_error)> functor) {
+  worker_service_.service().post([this, committed, functor] {
+    maidsafe_error commit_error{MakeError(CommonErrors::success)};
+    try {
+      committed.get();
+    } catch (const maidsafe_error& e) {
+      LOG(kError) << boost::diagnostic_information(e);
+      commit_error = e;
+    } catch (const std::exception& e) {
+      LOG(kError) << boost::diagnostic_information(e);
+      commit_error = MakeError(CommonErrors::unknown);
+    }
+    strand_.post([this, functor, commit_error] {
+      if (!stopping_)
+        functor(commit_error);
+    });
+  });
+}
+
+std::shared_future<void> VaultManager::ConfirmOwnership(tcp::ConnectionPtr client,
+                                                        const NonEmptyString& label) {
+  return ConfirmOwnership(client, std::vector<NonEmptyString>(1, label));
+}
+
+void VaultManager::ChangeChunkstorePath(VaultInfo vault_info, tcp::ConnectionPtr client) {
+  NonEmptyString label{vault_info.label};
+  if (chunkstore_moves_.count(label.string()) != 0U) {
+    LOG(kError) << "Chunkstore of vault " << label.string() << " is already being moved.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  }
+  boost::system::error_code ec;
+  if (fs::exists(vault_info.vault_dir, ec) && !fs::is_empty(vault_info.vault_dir, ec)) {
+    LOG(kError) << "Can't move chunkstore to non-empty directory " << vault_info.vault_dir;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+
+  fs::path old_vault_dir{process_manager_->Find(label).vault_dir};
+  fs::path new_vault_dir{vault_info.vault_dir};
+  // The old directory is removed once the move completes, so mustn't contain the new one (nor can
+  // a directory be copied into itself).
+  if (DirectoriesOverlap(old_vault_dir, new_vault_dir)) {
+    LOG(kError) << "Can't move chunkstore from " << old_vault_dir << " to " << new_vault_dir
+                << " since one contains the other.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+  chunkstore_moves_.emplace(label.string(),
+                            ChunkstoreMove{std::move(vault_info), old_vault_dir, client, nullptr});
+  LOG(kInfo) << "Copying chunkstore of vault " << label.string() << " to " << new_vault_dir;
+  // Copy in bulk while the vault keeps running.  The vault then copies whatever changed meanwhile
+  // and switches over (see HandleChunkstoreCopied).
+  worker_service_.service().post([this, label, old_vault_dir, new_vault_dir, client] {
+    maidsafe_error error{MakeError(CommonErrors::success)};
+    auto next_report(std::chrono::steady_clock::now());
+    try {
+      bool finished{SyncDirectory(old_vault_dir, new_vault_dir, kChunkstoreCopyRate,
+                                  [&](uint64_t copied, uint64_t total) -> bool {
+        if (stopping_)
+          return false;
+        auto now(std::chrono::steady_clock::now());
+        if (now >= next_report) {
+          next_report = now + kChunkstoreMoveProgressInterval;
+          strand_.post([this, client, label, copied, total] {
+            if (!stopping_)
+              Send(client, MoveChunkstoreProgress(label, copied, total));
+          });
+        }
+        return true;
+      })};
+      if (!finished)  // Only cancelled if we're stopping.
+        return;
+    } catch (const maidsafe_error& e) {
+      error = e;
+    } catch (const std::exception& e) {
+      LOG(kError) << boost::diagnostic_information(e);
+      error = MakeError(CommonErrors::unknown);
+    }
+    strand_.post([this, label, error] {
+      if (!stopping_)
+        HandleChunkstoreCopied(label, error);
+    });
+  });
+}
+
+void VaultManager::HandleChunkstoreCopied(const NonEmptyString& label, maidsafe_error error) {
+  auto itr(chunkstore_moves_.find(label.string()));
+  if (itr == std::end(chunkstore_moves_))
+    return;
+  if (error.code() != make_error_code(CommonErrors::success))
+    return FailChunkstoreMove(itr, error, true);
+
+  tcp::ConnectionPtr vault_connection;
+  try {
+    vault_connection = process_manager_->Find(label).tcp_connection;
+  } catch (const maidsafe_error& e) {
+    return FailChunkstoreMove(itr, e, true);
+  }
+  if (!vault_connection) {
+    // E.g. the vault is backing off after crashing.
+    LOG(kWarning) << "Vault " << label.string() << " isn't running; abandoning chunkstore move.";
+    return FailChunkstoreMove(itr, MakeError(CommonErrors::unable_to_handle_request), true);
+  }
+  itr->second.vault_connection = vault_connection;
+  Send(vault_connection, MoveChunkstoreRequest(itr->second.target.vault_dir));
+}
+
+void VaultManager::HandleMoveChunkstoreResponse(tcp::ConnectionPtr connection,
+                                                MoveChunkstoreResponse&& response) {
+  NonEmptyString label;
+  try {
+    label = process_manager_->Find(connection).label;
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to handle chunkstore move: " << boost::diagnostic_information(e);
+    return;
+  }
+
+  auto itr(chunkstore_moves_.find(label.string()));
+  if (itr == std::end(chunkstore_moves_)) {
+    LOG(kError) << "Vault " << label.string() << " responded to a chunkstore move which isn't "
+                << "pending.";
+    return;
+  }
+  itr->second.vault_connection = nullptr;
+  if (response.error) {
+    if (response.error->code() == make_error_code(CommonErrors::unable_to_handle_request))
+      return MoveChunkstoreByRestart(itr);
+    return FailChunkstoreMove(itr, *response.error, true);
+  }
+
+  // Only the directory this manager asked for is recorded, whatever the vault reports.
+  fs::path new_vault_dir{itr->second.target.vault_dir};
+  if (response.new_vault_dir != new_vault_dir) {
+    LOG(kError) << "Vault " << label.string() << " reports switching to "
+                << response.new_vault_dir << " rather than " << new_vault_dir;
+    return FailChunkstoreMove(itr, MakeError(CommonErrors::invalid_parameter), true);
+  }
+  try {
+    process_manager_->SetVaultDir(label, new_vault_dir);
+  } catch (const maidsafe_error& e) {
+    // Another vault is using the directory, so it mustn't be removed.
+    return FailChunkstoreMove(itr, e, false);
+  }
+  CompleteChunkstoreMove(itr);
+}
+
+void VaultManager::CompleteChunkstoreMove(ChunkstoreMoveItr itr) {
+  ChunkstoreMove move(std::move(itr->second));
+  chunkstore_moves_.erase(itr);
+  const VaultInfo& target{move.target};
+  VaultInfo current{process_manager_->Find(target.label)};
+  DiskUsage old_quota{DiskQuota(target.label, current.max_disk_usage)};
+  // The vault's share was of the filesystem it has just left.
+  disk_quotas_.erase(target.label.string());
+  if (current.tcp_connection && old_quota != target.max_disk_usage &&
+      target.max_disk_usage != 0U) {
+    Send(current.tcp_connection, MaxDiskUsageUpdate(target.max_disk_usage));
+  }
+  process_manager_->AssignOwner(target.label, target.owner_name, target.max_disk_usage);
+  RemoveVaultDirOnceCommitted(ConfirmOwnership(move.client, target.label), move.old_vault_dir);
+  LOG(kSuccess) << "Moved chunkstore of vault " << target.label.string() << " to "
+                << target.vault_dir;
+}
+
+void VaultManager::MoveChunkstoreByRestart(ChunkstoreMoveItr itr) {
+  // This vault can't switch directories while running, so restart it in the new one, copying
+  // whatever changed since the bulk copy once it has stopped.
+  LOG(kInfo) << "Restarting vault " << itr->first << " to move its chunkstore.";
+  NonEmptyString label{itr->second.target.label};
+  fs::path old_vault_dir{itr->second.old_vault_dir};
+  fs::path new_vault_dir{itr->second.target.vault_dir};
+  // The vault is removed from the process manager once stopped, so keep hold of its state.
+  RetainedVaultState retained_state{process_manager_->GetRetainedState(label)};
+  ProcessManager::OnExitFunctor on_exit{[this, label, old_vault_dir, new_vault_dir,
+                                         retained_state](maidsafe_error /*error*/,
+                                                         int /*exit_code*/) {
+    worker_service_.service().post([this, label, old_vault_dir, new_vault_dir, retained_state] {
+      maidsafe_error error{MakeError(CommonErrors::success)};
+      try {
+        SyncDirectory(old_vault_dir, new_vault_dir, 0, nullptr);
+      } catch (const maidsafe_error& e) {
+        error = e;
+      }
+      strand_.post([this, label, retained_state, error] {
+        if (!stopping_)
+          HandleVaultStoppedForMove(label, retained_state, error);
+      });
+    });
+  }};
+  process_manager_->StopProcess(process_manager_->Find(label).tcp_connection, on_exit);
+}
+
+void VaultManager::HandleVaultStoppedForMove(const NonEmptyString& label,
+                                             const RetainedVaultState& retained_state,
+                                             maidsafe_error error) {
+  auto itr(chunkstore_moves_.find(label.string()));
+  if (itr == std::end(chunkstore_moves_))
+    return;
+  // The vault has been removed from the process manager, so must be re-added whatever happens,
+  // with the state it had before being stopped.  Its owner is sent a VaultRunningResponse once it
+  // has restarted.
+  VaultInfo target{itr->second.target};
+  fs::path old_vault_dir{itr->second.old_vault_dir};
+  bool copied{error.code() == make_error_code(CommonErrors::success)};
+  if (!copied)
+    target.vault_dir = old_vault_dir;
+  std::shared_future<void> committed;
+  try {
+    committed = config_file_handler_.UpdateVault(
+        process_manager_->AddProcess(target, retained_state)).share();
+  } catch (const maidsafe_error& e) {
+    // The config file still refers to the old directory, so the vault is restored from there when
+    // this manager next starts.
+    LOG(kError) << "Failed to restart vault " << label.string() << ": "
+                << boost::diagnostic_information(e);
+    return FailChunkstoreMove(itr, e, true);
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to restart vault " << label.string() << ": "
+                << boost::diagnostic_information(e);
+    return FailChunkstoreMove(itr, MakeError(CommonErrors::unknown), true);
+  }
+  if (copied) {
+    chunkstore_moves_.erase(itr);
+    RemoveVaultDirOnceCommitted(committed, old_vault_dir);
+  } else {
+    FailChunkstoreMove(itr, error, true);
+  }
+}
+
+void VaultManager::FailChunkstoreMove(ChunkstoreMoveItr itr, maidsafe_error error,
+                                      bool remove_copy) {
+  LOG(kError) << "Failed to move chunkstore of vault " << itr->first << " to "
+              << itr->second.target.vault_dir << ": " << error.what();
+  Send(itr->second.client, VaultRunningResponse(itr->second.target.label, error));
+  if (remove_copy) {
+    fs::path new_vault_dir{itr->second.target.vault_dir};
+    worker_service_.service().post([new_vault_dir] {
+      boost::system::error_code ignored_ec;
+      fs::remove_all(new_vault_dir, ignored_ec);
+    });
+  }
+  chunkstore_moves_.erase(itr);
+}
+
+void VaultManager::RemoveVaultDirOnceCommitted(std::shared_future<void> committed,
+                                               fs::path vault_dir) {
+  worker_service_.service().post([committed, vault_dir] {
+    try {
+      committed.get();
+    } catch (const std::exception&) {
+      // The config file may still refer to the old directory, so keep it.
+      return;
+    }
+    boost::system::error_code ec;
+    fs::remove_all(vault_dir, ec);
+    if (ec)
+      LOG(kWarning) << "Failed to remove old vault dir " << vault_dir << ": " << ec.message();
+  });
+}
+
+void VaultManager::HandleVaultStarted(tcp::ConnectionPtr connection, CorrelationId correlation_id,
+                                      VaultStarted&& vault_started) {
   // TODO(Fraser#5#): 2014-05-20 - We should validate received ProcessID since a malicious process
   //                  could have spotted a new vault process starting and jumped in with this TCP
   //                  connection before the new vault can connect, passing itself off as the new
@@ -349,17 +1021,30 @@ void VaultManager::HandleVaultStarted(tcp::ConnectionPtr connection, VaultStarte
   VaultInfo vault_info{
       process_manager_->HandleVaultStarted(connection, {vault_started.process_id})};
 
-  // Send vault its credentials
-  Send(vault_info.tcp_connection, VaultStartedResponse(vault_info, config_file_handler_.SymmKey(),
-                                                       config_file_handler_.SymmIv()));
+  // Send vault its credentials, along with its current share of the disk
+  VaultInfo started_info{vault_info};
+  started_info.max_disk_usage = DiskQuota(vault_info.label, vault_info.max_disk_usage);
+  Send(vault_info.tcp_connection,
+       VaultStartedResponse(started_info, config_file_handler_.SymmKey(),
+                            config_file_handler_.SymmIv()),
+       correlation_id);
 
-  // If the corresponding client is connected, send it the credentials too
+  // If the corresponding client is connected, send it the credentials too, but not before a newly
+  // added vault is in the config file.
+  std::shared_future<void> committed;
+  auto uncommitted_itr(uncommitted_vaults_.find(vault_info.label.string()));
+  if (uncommitted_itr != std::end(uncommitted_vaults_)) {
+    committed = uncommitted_itr->second;
+    uncommitted_vaults_.erase(uncommitted_itr);
+  }
   if (vault_info.owner_name->IsInitialised()) {
-    try {
-      tcp::ConnectionPtr client{client_connections_->FindValidated(vault_info.owner_name)};
-      Send(client, VaultRunningResponse(vault_info.label, *vault_info.pmid_and_signer));
-    } catch (const std::exception&) {
-    }  // We don't care if the client isn't connected.
+    if (committed.valid()) {
+      WhenCommitted(committed, [this, vault_info](maidsafe_error commit_error) {
+        SendVaultRunning(vault_info, commit_error);
+      });
+    } else {
+      SendVaultRunning(vault_info, MakeError(CommonErrors::success));
+    }
   }
 
   LOG(kSuccess) << "Vault started.  Pmid ID: "
@@ -368,18 +1053,30 @@ void VaultManager::HandleVaultStarted(tcp::ConnectionPtr connection, VaultStarte
                 << "  Label: " << vault_info.label.string();
 }
 
+void VaultManager::SendVaultRunning(const VaultInfo& vault_info, maidsafe_error commit_error) {
+  try {
+    tcp::ConnectionPtr client{client_connections_->FindValidated(vault_info.owner_name)};
+    if (commit_error.code() != make_error_code(CommonErrors::success)) {
+      Send(client, VaultRunningResponse(vault_info.label, commit_error));
+      return;
+    }
+    Send(client, VaultRunningResponse(vault_info.label, *vault_info.pmid_and_signer,
+                                      client_connections_->FindSessionKey(client)));
+  } catch (const std::exception&) {
+  }  // We don't care if the client isn't connected.
+}
+
 #ifdef TESTING
 void VaultManager::HandleSetNetworkAsStable() {
-  asio_service_.service().dispatch([=] {
-    std::vector<tcp::ConnectionPtr> all_clients{client_connections_->GetAll()};
-    for (const auto& client : all_clients)
-      Send(client, NetworkStableResponse());
+  strand_.dispatch([=] {
+    client_connections_->ForEach(
+        [](const tcp::ConnectionPtr& client) { Send(client, NetworkStableResponse()); });
     network_stable_ = true;
   });
 }
 
 void VaultManager::HandleNetworkStableRequest(tcp::ConnectionPtr connection) {
-  asio_service_.service().dispatch([=] {
+  strand_.dispatch([=] {
     // If network is already stable send reply, else do nothing since all clients get notified once
     // stable anyway.
     if (network_stable_)
@@ -401,14 +1098,25 @@ void VaultManager::HandleJoinedNetwork(tcp::ConnectionPtr connection) {
   }  // We don't care if the client isn't connected.
 }
 
+void VaultManager::HandleVaultHeartbeat(tcp::ConnectionPtr connection, VaultHeartbeat&& heartbeat) {
+  try {
+    process_manager_->HandleHeartbeat(connection, heartbeat.sequence, heartbeat.progress);
+  } catch (const std::exception& e) {
+    LOG(kWarning) << "Heartbeat from unknown vault: " << boost::diagnostic_information(e);
+  }
+}
+
 void VaultManager::HandleLogMessage(tcp::ConnectionPtr connection, LogMessage&& log_message) {
   LOG(kInfo) << log_message.data;
-  try {
-    VaultInfo vault_info(process_manager_->Find(connection));
-    tcp::ConnectionPtr client{client_connections_->FindValidated(vault_info.owner_name)};
-    Send(client, std::move(log_message));
-  } catch (const std::exception&) {
-  }  // We don't care if the client isn't connected.
+  auto shared_log_message(std::make_shared<LogMessage>(std::move(log_message)));
+  strand_.post([=] {
+    try {
+      VaultInfo vault_info(process_manager_->Find(connection));
+      tcp::ConnectionPtr client{client_connections_->FindValidated(vault_info.owner_name)};
+      Send(client, std::move(*shared_log_message));
+    } catch (const std::exception&) {
+    }  // We don't care if the client isn't connected.
+  });
 }
 
 void VaultManager::RemoveFromNewConnections(tcp::ConnectionPtr connection) {
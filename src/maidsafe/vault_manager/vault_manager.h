@@ -19,19 +19,29 @@
 #ifndef MAIDSAFE_VAULT_MANAGER_VAULT_MANAGER_H_
 #define MAIDSAFE_VAULT_MANAGER_VAULT_MANAGER_H_
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "asio/io_service_strand.hpp"
 #include "boost/filesystem/path.hpp"
 
 #include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/crypto.h"
+#include "maidsafe/common/error.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/passport/types.h"
 
 #include "maidsafe/vault_manager/config.h"
 #include "maidsafe/vault_manager/config_file_handler.h"
+#include "maidsafe/vault_manager/key_pool.h"
+#include "maidsafe/vault_manager/pmid_publisher.h"
+#include "maidsafe/vault_manager/session_tickets.h"
 #include "maidsafe/vault_manager/vault_info.h"
 
 namespace maidsafe {
@@ -41,23 +51,36 @@ namespace vault_manager {
 struct ChallengeResponse;
 class ClientConnections;
 struct LogMessage;
+struct MoveChunkstoreResponse;
 class NewConnections;
 class ProcessManager;
+struct ResumeSessionRequest;
+struct RetainedVaultState;
+struct SetVaultResourceLimitsRequest;
 struct StartVaultRequest;
+struct StartVaultsRequest;
+struct TakeOwnershipBatchRequest;
 struct TakeOwnershipRequest;
+struct VaultHeartbeat;
+struct VaultResourceUsageRequest;
 struct VaultStarted;
+struct VaultStatusRequest;
 
 // The VaultManager has several responsibilities:
 // * Reads config file on startup and restarts vaults listed in file.
 // * Writes details of all vaults to config file.
 // * Listens and responds to client and vault requests on the loopback address.
+//
+// Messages are parsed on a strand per connection, while the registries (processes, connections
+// and ongoing operations) are only accessed on strand_.  Blocking work runs on worker_service_.
 class VaultManager {
  public:
   VaultManager(const VaultManager&) = delete;
   VaultManager(VaultManager&&) = delete;
   VaultManager operator=(VaultManager) = delete;
 
-  VaultManager();
+  // Runs 'thread_count' event loop threads, or one per core (minimum 2) if it's 0.
+  explicit VaultManager(uint32_t thread_count = 0);
   ~VaultManager();
 
   void TearDownWithInterval();
@@ -68,32 +91,135 @@ class VaultManager {
   void HandleReceivedMessage(tcp::ConnectionPtr connection, tcp::Message&& message);
 
   // Messages from Client
-  void HandleValidateConnectionRequest(tcp::ConnectionPtr connection);
+  // Where a request is answered directly, the handler is given its 'correlation_id' to echo.
+  void HandleValidateConnectionRequest(tcp::ConnectionPtr connection,
+                                       CorrelationId correlation_id);
   void HandleChallengeResponse(tcp::ConnectionPtr connection,
                                ChallengeResponse&& challenge_response);
+  void HandleResumeSessionRequest(tcp::ConnectionPtr connection, CorrelationId correlation_id,
+                                  ResumeSessionRequest&& request);
   void HandleStartVaultRequest(tcp::ConnectionPtr connection,
                                StartVaultRequest&& start_vault_request);
+  void HandleStartVaultsRequest(tcp::ConnectionPtr connection,
+                                StartVaultsRequest&& start_vaults_request);
   void HandleTakeOwnershipRequest(tcp::ConnectionPtr connection,
                                   TakeOwnershipRequest&& take_ownership_request);
+  void HandleTakeOwnershipBatchRequest(tcp::ConnectionPtr connection,
+                                       TakeOwnershipBatchRequest&& request);
   void HandleSetNetworkAsStable();
   void HandleNetworkStableRequest(tcp::ConnectionPtr connection);
+  void HandleVaultStatusRequest(tcp::ConnectionPtr connection, CorrelationId correlation_id,
+                                VaultStatusRequest&& vault_status_request);
+  void HandleSetVaultResourceLimitsRequest(tcp::ConnectionPtr connection,
+                                           CorrelationId correlation_id,
+                                           SetVaultResourceLimitsRequest&& request);
+  void HandleVaultResourceUsageRequest(tcp::ConnectionPtr connection,
+                                       CorrelationId correlation_id,
+                                       VaultResourceUsageRequest&& request);
 
   // Messages from Vault
-  void HandleVaultStarted(tcp::ConnectionPtr connection, VaultStarted&& vault_started);
+  void HandleVaultStarted(tcp::ConnectionPtr connection, CorrelationId correlation_id,
+                          VaultStarted&& vault_started);
   void HandleJoinedNetwork(tcp::ConnectionPtr connection);
+  void HandleVaultHeartbeat(tcp::ConnectionPtr connection, VaultHeartbeat&& heartbeat);
+  void HandleMoveChunkstoreResponse(tcp::ConnectionPtr connection,
+                                    MoveChunkstoreResponse&& response);
   void HandleLogMessage(tcp::ConnectionPtr connection, LogMessage&& log_message);
 
   void RemoveFromNewConnections(tcp::ConnectionPtr connection);
-  void ChangeChunkstorePath(VaultInfo vault_info);
+  // Assigns the vault to the client, or starts moving its chunkstore if the request names a new
+  // directory.  Returns true if the vault's new details still need to be persisted and confirmed
+  // via ConfirmOwnership, or false if that's in hand or the client has been sent an error.
+  bool TakeOwnership(tcp::ConnectionPtr client, TakeOwnershipRequest&& take_ownership_request);
+  // Persists the vaults' details together, then sends 'client' a VaultRunningResponse for each.
+  // Returns a future which is ready once the details are on disk.
+  std::shared_future<void> ConfirmOwnership(tcp::ConnectionPtr client,
+                                            const std::vector<NonEmptyString>& labels);
+  std::shared_future<void> ConfirmOwnership(tcp::ConnectionPtr client, const NonEmptyString& label);
+  // Waits off the event loop for 'committed', then invokes 'functor' on strand_ with its outcome
+  // (success or the commit error), unless stopping.
+  void WhenCommitted(std::shared_future<void> committed,
+                     std::function<void(maidsafe_error)> functor);
+  // Sends the vault's owner, if connected, a VaultRunningResponse with the vault's credentials, or
+  // with 'commit_error' if the vault couldn't be persisted.
+  void SendVaultRunning(const VaultInfo& vault_info, maidsafe_error commit_error);
+
+  // Moving a vault's chunkstore (to 'vault_info.vault_dir'):
+  // * the chunkstore is copied in bulk on worker_service_ while the vault keeps running, with
+  //   progress sent to 'client'
+  // * the vault is sent a MoveChunkstoreRequest, and copies across whatever changed meanwhile
+  //   before switching to the new directory
+  // * on success, the new details are persisted, 'client' is sent a VaultRunningResponse, and the
+  //   old directory is removed
+  // A vault which can't switch directories while running is instead stopped and restarted in the
+  // new one, keeping its resource limits and restart budget.  A vault which reports switching to
+  // any other directory has failed.  On failure, 'client' is sent the error and the vault is left
+  // in its old directory.
+  struct ChunkstoreMove {
+    VaultInfo target;
+    boost::filesystem::path old_vault_dir;
+    tcp::ConnectionPtr client;
+    // Set while waiting for the vault to switch directories.
+    tcp::ConnectionPtr vault_connection;
+  };
+  typedef std::map<std::string, ChunkstoreMove>::iterator ChunkstoreMoveItr;
+
+  void ChangeChunkstorePath(VaultInfo vault_info, tcp::ConnectionPtr client);
+  void HandleChunkstoreCopied(const NonEmptyString& label, maidsafe_error error);
+  void CompleteChunkstoreMove(ChunkstoreMoveItr itr);
+  void MoveChunkstoreByRestart(ChunkstoreMoveItr itr);
+  void HandleVaultStoppedForMove(const NonEmptyString& label,
+                                 const RetainedVaultState& retained_state, maidsafe_error error);
+  void FailChunkstoreMove(ChunkstoreMoveItr itr, maidsafe_error error, bool remove_copy);
+  void RemoveVaultDirOnceCommitted(std::shared_future<void> committed,
+                                   boost::filesystem::path vault_dir);
+
+  void StartVault(tcp::ConnectionPtr client, StartVaultRequest&& start_vault_request);
+  // Runs the blocking steps of creating a new vault (taking keys from the pool, storing its public
+  // keys on the network via pmid_publisher_ and creating its directory) off the event loop, then
+  // continues on strand_ by handing the vault to the process manager and queueing it to be added
+  // to the config file.  The vaults of a batch go through these steps concurrently, and the config
+  // file writer merges their additions.  Errors are reported to 'client' if it is non-null.  If
+  // 'client' is null (the first vault of a fresh installation), storing the keys is retried until
+  // it succeeds.
+  void StartVaultAsync(VaultInfo vault_info, tcp::ConnectionPtr client);
+  void PrepareVaultDir(VaultInfo vault_info, tcp::ConnectionPtr client);
+  void HandleVaultPrepared(VaultInfo vault_info, tcp::ConnectionPtr client);
+  void SendStartVaultError(tcp::ConnectionPtr client, NonEmptyString label, maidsafe_error error);
+
+  // Every kDiskQuotaInterval, the vaults' directories and the free space on their filesystems are
+  // measured on worker_service_, then back on strand_ each vault whose fair share has changed is
+  // sent a MaxDiskUsageUpdate.  A vault's share never exceeds the limit set by its owner, which
+  // remains what's persisted in the config file.
+  void ScheduleDiskQuotaUpdate();
+  void MeasureDiskUsage();
+  void ApplyDiskQuotas(const std::map<std::string, uint64_t>& quotas);
+  // Returns the vault's current share of its filesystem if one has been worked out, capped at
+  // 'limit'.
+  DiskUsage DiskQuota(const NonEmptyString& label, DiskUsage limit) const;
 
   ConfigFileHandler config_file_handler_;
+  KeyPool key_pool_;
   bool network_stable_, tear_down_with_interval_;
+  std::atomic<bool> stopping_;
   AsioService asio_service_;
   asio::io_service::strand strand_;
   std::shared_ptr<tcp::Listener> listener_;
   std::shared_ptr<ProcessManager> process_manager_;
   std::shared_ptr<ClientConnections> client_connections_;
   std::shared_ptr<NewConnections> new_connections_;
+  PmidPublisher pmid_publisher_;
+  const SessionTickets session_tickets_;
+  // Keyed by vault label.
+  std::map<std::string, ChunkstoreMove> chunkstore_moves_;
+  Timer disk_quota_timer_;
+  // Keyed by vault label.
+  std::map<std::string, DiskUsage> disk_quotas_;
+  // Keyed by vault label.  The config file commits of newly started vaults whose owners haven't yet
+  // been told they're running.
+  std::map<std::string, std::shared_future<void>> uncommitted_vaults_;
+  // Declared last so that it's destroyed (and its threads joined) before anything it uses.
+  AsioService worker_service_;
 };
 
 }  // namespace vault_manager
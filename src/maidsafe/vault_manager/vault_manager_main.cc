@@ -22,6 +22,7 @@
 #include <signal.h>
 #endif
 
+#include <cstdint>
 #include <future>
 #include <iostream>
 #include <string>
@@ -37,6 +38,7 @@
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
 
+#include "maidsafe/vault_manager/launcher.h"
 #include "maidsafe/vault_manager/vault_manager.h"
 #include "maidsafe/vault_manager/utils.h"
 
@@ -133,7 +135,8 @@ BOOL CtrlHandler(DWORD control_type) {
 
 #endif
 
-void HandleProgramOptions(int argc, char** argv) {
+// Returns the number of event loop threads to run, or 0 for the default.
+uint32_t HandleProgramOptions(int argc, char** argv) {
   po::options_description options_description("Allowed options");
   options_description.add_options()
 #ifdef TESTING
@@ -141,7 +144,10 @@ void HandleProgramOptions(int argc, char** argv) {
                                                    "Path to the vault executable including name")(
           "root_dir", po::value<std::string>(), "Path to folder of config file")
 #endif
-          ("help", "produce help message");
+          ("spawn_helper", "launch vaults via a small helper process (Linux only)")(
+              "threads", po::value<uint32_t>(),
+              "number of event loop threads (default: one per core)")(
+              "help", "produce help message");
   po::variables_map variables_map;
   po::store(
       po::command_line_parser(argc, argv).options(options_description).allow_unregistered().run(),
@@ -154,6 +160,12 @@ void HandleProgramOptions(int argc, char** argv) {
     BOOST_THROW_EXCEPTION(maidsafe::MakeError(maidsafe::CommonErrors::success));
   }
 
+#ifndef MAIDSAFE_WIN32
+  // Done before anything else so that the helper is forked while the manager is still small.
+  if (variables_map.count("spawn_helper") != 0 && !maidsafe::vault_manager::StartSpawnHelper())
+    LOG(kWarning) << "Failed to start spawn helper; launching vaults directly.";
+#endif
+
 #ifdef TESTING
   typedef maidsafe::tcp::Port Port;
   Port port(maidsafe::kLivePort + 100);
@@ -174,6 +186,7 @@ void HandleProgramOptions(int argc, char** argv) {
 
   maidsafe::vault_manager::test::SetEnvironment(port, root_dir, path_to_vault);
 #endif
+  return variables_map.count("threads") != 0 ? variables_map["threads"].as<uint32_t>() : 0;
 }
 
 }  // unnamed namespace
@@ -183,9 +196,9 @@ int main(int argc, char** argv) {
 #ifdef MAIDSAFE_WIN32
 #ifdef TESTING
   try {
-    HandleProgramOptions(argc, argv);
+    uint32_t thread_count{HandleProgramOptions(argc, argv)};
     if (SetConsoleCtrlHandler(reinterpret_cast<PHANDLER_ROUTINE>(CtrlHandler), TRUE)) {
-      maidsafe::vault_manager::VaultManager vault_manager;
+      maidsafe::vault_manager::VaultManager vault_manager{thread_count};
       g_shutdown_promise.get_future().get();
     } else {
       LOG(kError) << "Failed to set control handler.";
@@ -206,8 +219,8 @@ int main(int argc, char** argv) {
 #endif
 #else
   try {
-    HandleProgramOptions(argc, argv);
-    maidsafe::vault_manager::VaultManager vault_manager;
+    uint32_t thread_count{HandleProgramOptions(argc, argv)};
+    maidsafe::vault_manager::VaultManager vault_manager{thread_count};
     std::cout << "Successfully started vault_manager" << std::endl;
     signal(SIGINT, ShutDownVaultManager);
     signal(SIGTERM, ShutDownVaultManager);